@@ -1,5 +1,5 @@
 /* $Id$ */
-/* Copyright (c) 2015-2018 Pierre Pronchery <khorben@defora.org> */
+/* Copyright (c) 2015-2026 Pierre Pronchery <khorben@defora.org> */
 /* This file is part of DeforaOS Desktop Panel */
 /* This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -48,6 +48,9 @@ typedef struct _PanelAppletHelper
 	void (*shutdown_dialog)(Panel * panel);
 	void (*suspend)(Panel * panel);
 	void (*suspend_dialog)(Panel * panel);
+	guint (*timeout_add)(Panel * panel, guint interval,
+			GSourceFunc callback, PanelApplet * applet);
+	void (*timeout_remove)(Panel * panel, guint id);
 } PanelAppletHelper;
 
 typedef struct _PanelAppletDefinition
@@ -61,6 +64,13 @@ typedef struct _PanelAppletDefinition
 			gboolean reset);
 	gboolean expand;
 	gboolean fill;
+	void (*suspend)(PanelApplet * applet);
+	void (*resume)(PanelApplet * applet);
 } PanelAppletDefinition;
 
+
+/* constants */
+/* how long the samples shared by the instances of an applet remain valid */
+# define PANEL_APPLET_SAMPLE_AGE	250	/* in milliseconds	*/
+
 #endif /* !DESKTOP_PANEL_APPLET_H */
@@ -0,0 +1,121 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Panel */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#ifndef DESKTOP_PANEL_CLIENTS_H
+# define DESKTOP_PANEL_CLIENTS_H
+
+# include <stddef.h>
+# include <X11/X.h>
+# include <gdk/gdk.h>
+# include "window.h"
+
+
+/* PanelClients */
+/* types */
+typedef struct _PanelClients PanelClients;
+
+typedef enum _PanelClientsAtom
+{
+	PANEL_CLIENTS_ATOM__NET_ACTIVE_WINDOW = 0,
+	PANEL_CLIENTS_ATOM__NET_CLIENT_LIST,
+	PANEL_CLIENTS_ATOM__NET_CLOSE_WINDOW,
+	PANEL_CLIENTS_ATOM__NET_CURRENT_DESKTOP,
+	PANEL_CLIENTS_ATOM__NET_DESKTOP_NAMES,
+	PANEL_CLIENTS_ATOM__NET_NUMBER_OF_DESKTOPS,
+	PANEL_CLIENTS_ATOM__NET_WM_ACTION_CHANGE_DESKTOP,
+	PANEL_CLIENTS_ATOM__NET_WM_ACTION_CLOSE,
+	PANEL_CLIENTS_ATOM__NET_WM_ACTION_MOVE,
+	PANEL_CLIENTS_ATOM__NET_WM_ACTION_RESIZE,
+	PANEL_CLIENTS_ATOM__NET_WM_ACTION_MINIMIZE,
+	PANEL_CLIENTS_ATOM__NET_WM_ACTION_SHADE,
+	PANEL_CLIENTS_ATOM__NET_WM_ACTION_STICK,
+	PANEL_CLIENTS_ATOM__NET_WM_ACTION_MAXIMIZE_HORZ,
+	PANEL_CLIENTS_ATOM__NET_WM_ACTION_MAXIMIZE_VERT,
+	PANEL_CLIENTS_ATOM__NET_WM_ACTION_FULLSCREEN,
+	PANEL_CLIENTS_ATOM__NET_WM_ALLOWED_ACTIONS,
+	PANEL_CLIENTS_ATOM__NET_WM_DESKTOP,
+	PANEL_CLIENTS_ATOM__NET_WM_ICON,
+	PANEL_CLIENTS_ATOM__NET_WM_MOVERESIZE,
+	PANEL_CLIENTS_ATOM__NET_WM_NAME,
+	PANEL_CLIENTS_ATOM__NET_WM_STATE,
+	PANEL_CLIENTS_ATOM__NET_WM_STATE_FULLSCREEN,
+	PANEL_CLIENTS_ATOM__NET_WM_STATE_MAXIMIZED_HORZ,
+	PANEL_CLIENTS_ATOM__NET_WM_STATE_MAXIMIZED_VERT,
+	PANEL_CLIENTS_ATOM__NET_WM_STATE_SHADED,
+	PANEL_CLIENTS_ATOM__NET_WM_STATE_SKIP_TASKBAR,
+	PANEL_CLIENTS_ATOM__NET_WM_STATE_STICKY,
+	PANEL_CLIENTS_ATOM__NET_WM_STATE_TOGGLE,
+	PANEL_CLIENTS_ATOM__NET_WM_VISIBLE_NAME,
+	PANEL_CLIENTS_ATOM__NET_WM_WINDOW_TYPE,
+	PANEL_CLIENTS_ATOM__NET_WM_WINDOW_TYPE_NORMAL,
+	PANEL_CLIENTS_ATOM_UTF8_STRING,
+	PANEL_CLIENTS_ATOM_WM_NAME
+} PanelClientsAtom;
+# define PANEL_CLIENTS_ATOM_LAST	PANEL_CLIENTS_ATOM_WM_NAME
+# define PANEL_CLIENTS_ATOM_COUNT	(PANEL_CLIENTS_ATOM_LAST + 1)
+
+typedef enum _PanelClientsEvent
+{
+	PANEL_CLIENTS_EVENT_ADDED = 0,
+	PANEL_CLIENTS_EVENT_CHANGED,
+	PANEL_CLIENTS_EVENT_REMOVED
+} PanelClientsEvent;
+
+/* the window is the root window for the properties of the screen, and the
+ * names of a window are all notified as _NET_WM_NAME */
+typedef void (*PanelClientsCallback)(void * data, PanelClientsEvent event,
+		Window window, PanelClientsAtom property);
+
+
+/* functions */
+/* the model is shared by every caller on the same screen */
+PanelClients * panel_clients_acquire(GdkScreen * screen);
+void panel_clients_release(PanelClients * clients);
+
+/* accessors */
+/* the values are only kept up to date while subscribed */
+Atom const * panel_clients_get_atoms(PanelClients * clients);
+GdkDisplay * panel_clients_get_display(PanelClients * clients);
+Window panel_clients_get_root(PanelClients * clients);
+
+/* screen */
+Window panel_clients_get_active(PanelClients * clients);
+Window const * panel_clients_get_clients(PanelClients * clients,
+		size_t * cnt);
+int panel_clients_get_current_desktop(PanelClients * clients);
+char const * panel_clients_get_desktop_name(PanelClients * clients,
+		unsigned int desktop);
+unsigned int panel_clients_get_desktops(PanelClients * clients);
+
+/* windows, as listed in _NET_CLIENT_LIST */
+int panel_clients_get_desktop(PanelClients * clients, Window window);
+char const * panel_clients_get_name(PanelClients * clients, Window window);
+gboolean panel_clients_get_state(PanelClients * clients, Window window,
+		PanelClientsAtom state);
+gboolean panel_clients_get_typehint_normal(PanelClients * clients,
+		Window window);
+
+/* useful */
+/* the callbacks for the windows added and removed are called before the
+ * change to _NET_CLIENT_LIST is notified; the time spent in the callbacks is
+ * accounted to the applet passed as data, within its panel window */
+int panel_clients_subscribe(PanelClients * clients, PanelWindow * window,
+		PanelClientsCallback callback, void * data);
+void panel_clients_unsubscribe(PanelClients * clients,
+		PanelClientsCallback callback, void * data);
+
+#endif /* !DESKTOP_PANEL_CLIENTS_H */
@@ -0,0 +1,49 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Panel */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#ifndef DESKTOP_PANEL_IMAGE_H
+# define DESKTOP_PANEL_IMAGE_H
+
+# include <stddef.h>
+# include <gdk/gdk.h>
+
+
+/* PanelImage */
+/* types */
+typedef enum _PanelImageFlag
+{
+	PANEL_IMAGE_PREMULTIPLIED = 0x1
+} PanelImageFlag;
+
+
+/* functions */
+/* converts pixels from the layout of _NET_WM_ICON (one ARGB value per long,
+ * as returned by XGetWindowProperty()) to RGBA bytes */
+void panel_image_unpack(unsigned char * rgba, unsigned long const * argb,
+		size_t cnt, unsigned int flags);
+void panel_image_unpremultiply(unsigned char * rgba, size_t cnt);
+
+/* downscales premultiplied RGBA with a box filter; returns -1 if the
+ * destination is larger than the source */
+int panel_image_scale(unsigned char * dst, int dst_width, int dst_height,
+		unsigned char const * src, int src_width, int src_height);
+
+/* returns a new pixbuf of the given size from the layout of _NET_WM_ICON */
+GdkPixbuf * panel_image_new_pixbuf(unsigned long const * argb, int width,
+		int height, int pixbuf_width, int pixbuf_height);
+
+#endif /* !DESKTOP_PANEL_IMAGE_H */
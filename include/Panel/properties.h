@@ -0,0 +1,55 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Panel */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#ifndef DESKTOP_PANEL_PROPERTIES_H
+# define DESKTOP_PANEL_PROPERTIES_H
+
+# include <X11/X.h>
+# include <gdk/gdk.h>
+
+
+/* PanelProperties */
+/* types */
+typedef struct _PanelProperties PanelProperties;
+
+
+/* functions */
+/* the requests are sent as they are added, and the replies collected later */
+PanelProperties * panel_properties_new(GdkDisplay * display);
+void panel_properties_delete(PanelProperties * properties);
+
+/* accessors */
+/* the data is formatted as with XGetWindowProperty(), and remains owned by
+ * the PanelProperties object; returns 1 if the type differs */
+int panel_properties_get(PanelProperties * properties, int index,
+		unsigned long * cnt, void * data);
+/* returns the number of bytes left after the range requested */
+unsigned long panel_properties_get_remaining(PanelProperties * properties,
+		int index);
+/* returns the text in UTF-8, to be freed with g_free() */
+char * panel_properties_get_text(PanelProperties * properties, int index);
+
+/* useful */
+/* returns the index of the request, or -1 on error */
+int panel_properties_add(PanelProperties * properties, Window window,
+		Atom property, Atom type);
+/* the offset and length are in 32-bit units */
+int panel_properties_add_range(PanelProperties * properties, Window window,
+		Atom property, Atom type, unsigned long offset,
+		unsigned long length);
+
+#endif /* !DESKTOP_PANEL_PROPERTIES_H */
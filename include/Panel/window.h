@@ -1,5 +1,5 @@
 /* $Id$ */
-/* Copyright (c) 2015-2022 Pierre Pronchery <khorben@defora.org> */
+/* Copyright (c) 2015-2026 Pierre Pronchery <khorben@defora.org> */
 /* This file is part of DeforaOS Desktop Panel */
 /* This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -37,4 +37,10 @@ GtkIconSize panel_window_get_icon_size(PanelWindow * panel);
 GtkOrientation panel_window_get_orientation(PanelWindow * panel);
 PanelWindowType panel_window_get_type(PanelWindow * panel);
 
+/* useful */
+void panel_window_add_filter(PanelWindow * panel, GdkWindow * window,
+		GdkFilterFunc filter, gpointer applet);
+void panel_window_remove_filter(PanelWindow * panel, GdkWindow * window,
+		GdkFilterFunc filter, gpointer applet);
+
 #endif /* !DESKTOP_PANEL_WINDOW_H */
@@ -1,5 +1,5 @@
 /* $Id$ */
-/* Copyright (c) 2010-2023 Pierre Pronchery <khorben@defora.org> */
+/* Copyright (c) 2010-2026 Pierre Pronchery <khorben@defora.org> */
 /* This file is part of DeforaOS Desktop Panel */
 /* This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -78,6 +78,17 @@ typedef struct _PanelApplet
 } Battery;
 
 
+/* variables */
+/* the sample is shared by every instance */
+static struct
+{
+	gint64 time;
+	gboolean ret;
+	gdouble level;
+	gboolean charging;
+} _battery_sample;
+
+
 /* prototypes */
 static Battery * _battery_init(PanelAppletHelper * helper, GtkWidget ** widget);
 static void _battery_destroy(Battery * battery);
@@ -113,7 +124,6 @@ PanelAppletDefinition applet =
 /* battery_init */
 static Battery * _battery_init(PanelAppletHelper * helper, GtkWidget ** widget)
 {
-	const int timeout = 5000;
 	Battery * battery;
 	GtkIconSize iconsize;
 	GtkWidget * vbox;
@@ -175,7 +185,7 @@ static Battery * _battery_init(PanelAppletHelper * helper, GtkWidget ** widget)
 #endif
 		battery->box = hbox;
 	}
-	battery->timeout = g_timeout_add(timeout, _battery_on_timeout, battery);
+	/* the callback schedules itself */
 	_battery_on_timeout(battery);
 	gtk_widget_show(battery->image);
 	*widget = battery->box;
@@ -187,7 +197,8 @@ static Battery * _battery_init(PanelAppletHelper * helper, GtkWidget ** widget)
 static void _battery_destroy(Battery * battery)
 {
 	if(battery->timeout > 0)
-		g_source_remove(battery->timeout);
+		battery->helper->timeout_remove(battery->helper->panel,
+				battery->timeout);
 #if defined(__NetBSD__) || defined(__linux__)
 	if(battery->fd != -1)
 		close(battery->fd);
@@ -489,22 +500,45 @@ static gboolean _battery_on_timeout(gpointer data)
 	PanelAppletHelper * helper = battery->helper;
 	gdouble level;
 	gboolean charging;
+	gboolean ret;
+	gboolean cached;
+	gint64 now;
 	int timeout;
 
-	if(_battery_get(battery, &level, &charging) == FALSE)
+	now = g_get_monotonic_time();
+	if((cached = (_battery_sample.time != 0 && now - _battery_sample.time
+					< PANEL_APPLET_SAMPLE_AGE * 1000)))
+	{
+		ret = _battery_sample.ret;
+		level = _battery_sample.level;
+		charging = _battery_sample.charging;
+	}
+	else
+	{
+		ret = _battery_get(battery, &level, &charging);
+		_battery_sample.time = now;
+		_battery_sample.ret = ret;
+		_battery_sample.level = level;
+		_battery_sample.charging = charging;
+	}
+	/* errors are only reported once per sample */
+	if(ret == FALSE)
 	{
-		helper->error(NULL, error_get(NULL), 1);
+		if(!cached)
+			helper->error(NULL, error_get(NULL), 1);
 		timeout = 0;
 	}
 	else if(level == error || level < 0.0)
 	{
-		helper->error(NULL, error_get(NULL), 1);
+		if(!cached)
+			helper->error(NULL, error_get(NULL), 1);
 		timeout = 30000;
 	}
 	else
 		timeout = 5000;
 	_battery_set(battery, level, charging);
 	battery->timeout = (timeout > 0)
-		? g_timeout_add(timeout, _battery_on_timeout, battery) : 0;
+		? helper->timeout_add(helper->panel, timeout,
+				_battery_on_timeout, battery) : 0;
 	return FALSE;
 }
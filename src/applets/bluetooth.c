@@ -107,7 +107,8 @@ static Bluetooth * _bluetooth_init(PanelAppletHelper * helper,
 	gtk_box_pack_start(GTK_BOX(*widget), bluetooth->image, TRUE, TRUE, 0);
 	gtk_widget_set_no_show_all(*widget, TRUE);
 	bluetooth->timeout = (_bluetooth_on_timeout(bluetooth) == TRUE)
-		? g_timeout_add(timeout, _bluetooth_on_timeout, bluetooth) : 0;
+		? helper->timeout_add(helper->panel, timeout,
+				_bluetooth_on_timeout, bluetooth) : 0;
 	return bluetooth;
 }
 
@@ -116,7 +117,8 @@ static Bluetooth * _bluetooth_init(PanelAppletHelper * helper,
 static void _bluetooth_destroy(Bluetooth * bluetooth)
 {
 	if(bluetooth->timeout > 0)
-		g_source_remove(bluetooth->timeout);
+		bluetooth->helper->timeout_remove(bluetooth->helper->panel,
+				bluetooth->timeout);
 #if defined(__NetBSD__) || defined(__linux__)
 	if(bluetooth->fd >= 0)
 		close(bluetooth->fd);
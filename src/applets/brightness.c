@@ -79,7 +79,6 @@ PanelAppletDefinition applet =
 static Brightness * _brightness_init(PanelAppletHelper * helper,
 		GtkWidget ** widget)
 {
-	const int timeout = 1000;
 	Brightness * brightness;
 	GtkIconSize iconsize;
 	GtkWidget * vbox;
@@ -132,8 +131,7 @@ static Brightness * _brightness_init(PanelAppletHelper * helper,
 #endif
 		brightness->box = hbox;
 	}
-	brightness->timeout = g_timeout_add(timeout, _brightness_on_timeout,
-			brightness);
+	/* the callback schedules itself */
 	_brightness_on_timeout(brightness);
 	gtk_widget_show(brightness->image);
 	*widget = brightness->box;
@@ -145,7 +143,8 @@ static Brightness * _brightness_init(PanelAppletHelper * helper,
 static void _brightness_destroy(Brightness * brightness)
 {
 	if(brightness->timeout > 0)
-		g_source_remove(brightness->timeout);
+		brightness->helper->timeout_remove(brightness->helper->panel,
+				brightness->timeout);
 	gtk_widget_destroy(brightness->box);
 	free(brightness);
 }
@@ -249,7 +248,8 @@ static gboolean _brightness_on_timeout(gpointer data)
 	}
 	else
 		timeout = 10000;
-	brightness->timeout = g_timeout_add(timeout, _brightness_on_timeout,
-			brightness);
+	brightness->timeout = brightness->helper->timeout_add(
+			brightness->helper->panel, timeout,
+			_brightness_on_timeout, brightness);
 	return FALSE;
 }
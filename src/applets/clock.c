@@ -1,5 +1,5 @@
 /* $Id$ */
-/* Copyright (c) 2010-2020 Pierre Pronchery <khorben@defora.org> */
+/* Copyright (c) 2010-2026 Pierre Pronchery <khorben@defora.org> */
 /* This file is part of DeforaOS Desktop Panel */
 /* This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -18,6 +18,7 @@
 
 
 #include <sys/time.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
@@ -40,9 +41,20 @@ typedef struct _PanelApplet
 	char const * format;
 	GtkWidget * label;
 	guint timeout;
+	char text[32];
+	char tooltip[32];
 } Clock;
 
 
+/* variables */
+/* the broken-down time is shared by every instance */
+static struct
+{
+	time_t time;
+	struct tm tm;
+} _clock_sample;
+
+
 /* prototypes */
 static Clock * _clock_init(PanelAppletHelper * helper, GtkWidget ** widget);
 static void _clock_destroy(Clock * clock);
@@ -82,6 +94,8 @@ static Clock * _clock_init(PanelAppletHelper * helper, GtkWidget ** widget)
 	clock->iconsize = panel_window_get_icon_size(helper->window);
 	clock->helper = helper;
 	clock->label = gtk_label_new(" \n ");
+	clock->text[0] = '\0';
+	clock->tooltip[0] = '\0';
 	if((clock->format = helper->config_get(helper->panel, "clock",
 					"format")) == NULL)
 #ifdef EMBEDDED
@@ -103,7 +117,8 @@ static Clock * _clock_init(PanelAppletHelper * helper, GtkWidget ** widget)
 	gtk_container_add(GTK_CONTAINER(clock->widget), clock->label);
 #endif
 	gtk_label_set_justify(GTK_LABEL(clock->label), GTK_JUSTIFY_CENTER);
-	clock->timeout = g_timeout_add(timeout, _clock_on_timeout, clock);
+	clock->timeout = helper->timeout_add(helper->panel, timeout,
+			_clock_on_timeout, clock);
 	_clock_on_timeout(clock);
 	gtk_widget_show_all(clock->widget);
 	*widget = clock->widget;
@@ -114,7 +129,9 @@ static Clock * _clock_init(PanelAppletHelper * helper, GtkWidget ** widget)
 /* clock_destroy */
 static void _clock_destroy(Clock * clock)
 {
-	g_source_remove(clock->timeout);
+	if(clock->timeout != 0)
+		clock->helper->timeout_remove(clock->helper->panel,
+				clock->timeout);
 	gtk_widget_destroy(clock->widget);
 	object_delete(clock);
 }
@@ -127,8 +144,6 @@ static gboolean _clock_on_timeout(gpointer data)
 	Clock * clock = data;
 	PanelAppletHelper * helper = clock->helper;
 	struct timeval tv;
-	time_t t;
-	struct tm tm;
 	char buf[32];
 
 	if(gettimeofday(&tv, NULL) != 0)
@@ -138,15 +153,29 @@ static gboolean _clock_on_timeout(gpointer data)
 		helper->error(NULL, error_get(NULL), 1);
 		return TRUE;
 	}
-	t = tv.tv_sec;
-	localtime_r(&t, &tm);
-	strftime(buf, sizeof(buf), clock->format, &tm);
-	gtk_label_set_text(GTK_LABEL(clock->label), buf);
+	if(tv.tv_sec != _clock_sample.time)
+	{
+		_clock_sample.time = tv.tv_sec;
+		localtime_r(&_clock_sample.time, &_clock_sample.tm);
+	}
+	strftime(buf, sizeof(buf), clock->format, &_clock_sample.tm);
+	/* avoid relayouts when the text did not change */
+	if(strcmp(buf, clock->text) != 0)
+	{
+		snprintf(clock->text, sizeof(clock->text), "%s", buf);
+		gtk_label_set_text(GTK_LABEL(clock->label), buf);
+	}
 #ifndef EMBEDDED
 	if(clock->iconsize != GTK_ICON_SIZE_LARGE_TOOLBAR)
 	{
-		strftime(buf, sizeof(buf), _("%H:%M:%S\n%d/%m/%Y"), &tm);
-		gtk_widget_set_tooltip_text(clock->label, buf);
+		strftime(buf, sizeof(buf), _("%H:%M:%S\n%d/%m/%Y"),
+				&_clock_sample.tm);
+		if(strcmp(buf, clock->tooltip) != 0)
+		{
+			snprintf(clock->tooltip, sizeof(clock->tooltip), "%s",
+					buf);
+			gtk_widget_set_tooltip_text(clock->label, buf);
+		}
 	}
 #endif
 	return TRUE;
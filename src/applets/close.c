@@ -1,5 +1,5 @@
 /* $Id$ */
-/* Copyright (c) 2011-2024 Pierre Pronchery <khorben@defora.org> */
+/* Copyright (c) 2011-2026 Pierre Pronchery <khorben@defora.org> */
 /* This file is part of DeforaOS Desktop Panel */
 /* This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -23,10 +23,12 @@
 #include <gdk/gdk.h>
 #ifdef GDK_WINDOWING_X11
 # include <gdk/gdkx.h>
-# include <X11/Xatom.h>
 #endif
 #include <System.h>
 #include "Panel/applet.h"
+#if defined(GDK_WINDOWING_X11)
+# include "Panel/clients.h"
+#endif
 #define _(string) gettext(string)
 #define N_(string) string
 
@@ -44,13 +46,9 @@ typedef struct _PanelApplet
 	GtkWidget * widget;
 	gulong source;
 
-	GdkDisplay * display;
-	GdkScreen * screen;
-	GdkWindow * root;
-
 #if defined(GDK_WINDOWING_X11)
-	Atom atom_active;
-	Atom atom_close;
+	PanelClients * clients;
+	gboolean subscribed;
 	Window window;
 	Window panel;
 #endif
@@ -61,6 +59,8 @@ typedef struct _PanelApplet
 /* close */
 static Close * _close_init(PanelAppletHelper * helper, GtkWidget ** widget);
 static void _close_destroy(Close * close);
+static void _close_resume(Close * close);
+static void _close_suspend(Close * close);
 
 /* useful */
 static void _close_do(Close * close);
@@ -68,8 +68,8 @@ static void _close_do(Close * close);
 /* callbacks */
 #if defined(GDK_WINDOWING_X11)
 static void _close_on_close(gpointer data);
-static GdkFilterReturn _close_on_filter(GdkXEvent * xevent, GdkEvent * event,
-		gpointer data);
+static void _close_on_clients(void * data, PanelClientsEvent event,
+		Window window, PanelClientsAtom property);
 static void _close_on_screen_changed(GtkWidget * widget, GdkScreen * previous,
 		gpointer data);
 #endif
@@ -86,7 +86,9 @@ PanelAppletDefinition applet =
 	_close_destroy,
 	NULL,
 	FALSE,
-	TRUE
+	TRUE,
+	_close_suspend,
+	_close_resume
 };
 
 
@@ -122,12 +124,9 @@ static Close * _close_init(PanelAppletHelper * helper, GtkWidget ** widget)
 #else
 	close->source = 0;
 #endif
-	close->display = NULL;
-	close->screen = NULL;
-	close->root = NULL;
 #if defined(GDK_WINDOWING_X11)
-	close->atom_active = 0;
-	close->atom_close = 0;
+	close->clients = NULL;
+	close->subscribed = FALSE;
 	close->window = None;
 	close->panel = None;
 #endif
@@ -143,63 +142,61 @@ static void _close_destroy(Close * close)
 	if(close->source != 0)
 		g_signal_handler_disconnect(close->widget, close->source);
 #if defined(GDK_WINDOWING_X11)
-	if(close->root != NULL)
-		gdk_window_remove_filter(close->root, _close_on_filter, close);
+	if(close->clients != NULL)
+	{
+		_close_suspend(close);
+		panel_clients_release(close->clients);
+	}
 #endif
 	gtk_widget_destroy(close->widget);
 	object_delete(close);
 }
 
 
-#if defined(GDK_WINDOWING_X11)
-/* accessors */
-/* close_get_window_property */
-static int _close_get_window_property(Close * close, Window window,
-		Atom property, Atom atom, unsigned long * cnt,
-		unsigned char ** ret)
+/* close_resume */
+static void _close_resume(Close * close)
 {
-	int res;
-	Atom type;
-	int format;
-	unsigned long bytes;
+#if defined(GDK_WINDOWING_X11)
+	if(close->clients == NULL || close->subscribed)
+		return;
+	/* track the changes again, and catch up with them */
+	if(panel_clients_subscribe(close->clients, close->helper->window,
+				_close_on_clients, close) != 0)
+		return;
+	close->subscribed = TRUE;
+	_close_do(close);
+#else
+	(void) close;
+#endif
+}
 
-#ifdef DEBUG
-	fprintf(stderr, "DEBUG: %s(close, window, %lu, %lu)\n", __func__,
-			property, atom);
+
+/* close_suspend */
+static void _close_suspend(Close * close)
+{
+#if defined(GDK_WINDOWING_X11)
+	if(close->clients != NULL && close->subscribed)
+		panel_clients_unsubscribe(close->clients, _close_on_clients,
+				close);
+	close->subscribed = FALSE;
+#else
+	(void) close;
 #endif
-	gdk_error_trap_push();
-	res = XGetWindowProperty(GDK_DISPLAY_XDISPLAY(close->display), window,
-			property, 0, G_MAXLONG, False, atom, &type, &format,
-			cnt, &bytes, ret);
-	if(gdk_error_trap_pop() != 0 || res != Success)
-		return 1;
-	if(type != atom)
-	{
-		if(*ret != NULL)
-			XFree(*ret);
-		*ret = NULL;
-		return 1;
-	}
-	return 0;
 }
 
 
+#if defined(GDK_WINDOWING_X11)
 /* close_do */
 static void _close_do(Close * close)
 {
-	unsigned long cnt = 0;
-	Window * window;
+	Window window;
 
 #ifdef DEBUG
 	fprintf(stderr, "DEBUG: %s()\n", __func__);
 #endif
-	if(_close_get_window_property(close, GDK_WINDOW_XID(close->root),
-				close->atom_active, XA_WINDOW, &cnt,
-				(void*)&window) != 0 || cnt != 1)
-		return;
-	if(*window != close->panel)
-		close->window = *window;
-	XFree(window);
+	if((window = panel_clients_get_active(close->clients)) != None
+			&& window != close->panel)
+		close->window = window;
 #ifdef DEBUG
 	fprintf(stderr, "DEBUG: %s() %u\n", __func__, close->window);
 #endif
@@ -212,6 +209,7 @@ static void _close_on_close(gpointer data)
 {
 	Close * close = data;
 	GdkDisplay * display;
+	Atom const * atoms;
 	XEvent xev;
 
 #ifdef DEBUG
@@ -219,37 +217,35 @@ static void _close_on_close(gpointer data)
 #endif
 	if(close->window == None)
 		return;
-	display = close->display;
+	display = panel_clients_get_display(close->clients);
+	atoms = panel_clients_get_atoms(close->clients);
 	memset(&xev, 0, sizeof(xev));
 	xev.xclient.type = ClientMessage;
 	xev.xclient.window = close->window;
-	xev.xclient.message_type = close->atom_close;
+	xev.xclient.message_type = atoms[
+		PANEL_CLIENTS_ATOM__NET_CLOSE_WINDOW];
 	xev.xclient.format = 32;
 	xev.xclient.data.l[0] = gdk_x11_display_get_user_time(display);
 	xev.xclient.data.l[1] = 2;
 	gdk_error_trap_push();
-	XSendEvent(GDK_DISPLAY_XDISPLAY(display), GDK_WINDOW_XID(close->root),
-			False,
+	XSendEvent(GDK_DISPLAY_XDISPLAY(display),
+			panel_clients_get_root(close->clients), False,
 			SubstructureNotifyMask | SubstructureRedirectMask,
 			&xev);
 	gdk_error_trap_pop_ignored();
 }
 
 
-/* close_on_filter */
-static GdkFilterReturn _close_on_filter(GdkXEvent * xevent, GdkEvent * event,
-		gpointer data)
+/* close_on_clients */
+static void _close_on_clients(void * data, PanelClientsEvent event,
+		Window window, PanelClientsAtom property)
 {
 	Close * close = data;
-	XEvent * xev = xevent;
-	(void) event;
+	(void) window;
 
-	if(xev->type != PropertyNotify)
-		return GDK_FILTER_CONTINUE;
-	if(xev->xproperty.atom != close->atom_active)
-		return GDK_FILTER_CONTINUE;
-	_close_do(close);
-	return GDK_FILTER_CONTINUE;
+	if(event == PANEL_CLIENTS_EVENT_CHANGED
+			&& property == PANEL_CLIENTS_ATOM__NET_ACTIVE_WINDOW)
+		_close_do(close);
 }
 
 
@@ -258,28 +254,24 @@ static void _close_on_screen_changed(GtkWidget * widget, GdkScreen * previous,
 		gpointer data)
 {
 	Close * close = data;
+	PanelClients * clients;
 	GdkWindow * window;
-	GdkEventMask events;
 	(void) previous;
 
 #ifdef DEBUG
 	fprintf(stderr, "DEBUG: %s()\n", __func__);
 #endif
-	if(close->root != NULL)
-		gdk_window_remove_filter(close->root, _close_on_filter, close);
-	close->screen = gtk_widget_get_screen(widget);
-	close->display = gdk_screen_get_display(close->screen);
-	close->root = gdk_screen_get_root_window(close->screen);
+	if((clients = panel_clients_acquire(gtk_widget_get_screen(widget)))
+			== NULL)
+		return;
+	if(close->clients != NULL)
+	{
+		_close_suspend(close);
+		panel_clients_release(close->clients);
+	}
+	close->clients = clients;
 	close->panel = ((window = gtk_widget_get_parent_window(widget)) != NULL)
 		? GDK_WINDOW_XID(window) : None;
-	events = gdk_window_get_events(close->root);
-	gdk_window_set_events(close->root, events
-			| GDK_PROPERTY_CHANGE_MASK);
-	gdk_window_add_filter(close->root, _close_on_filter, close);
-	close->atom_active = gdk_x11_get_xatom_by_name_for_display(
-			close->display, "_NET_ACTIVE_WINDOW");
-	close->atom_close = gdk_x11_get_xatom_by_name_for_display(
-			close->display, "_NET_CLOSE_WINDOW");
-	_close_do(close);
+	_close_resume(close);
 }
 #endif
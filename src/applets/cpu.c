@@ -1,5 +1,5 @@
 /* $Id$ */
-/* Copyright (c) 2010-2021 Pierre Pronchery <khorben@defora.org> */
+/* Copyright (c) 2010-2026 Pierre Pronchery <khorben@defora.org> */
 /* This file is part of DeforaOS Desktop Panel */
 /* This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -43,11 +43,20 @@ typedef struct _PanelApplet
 	GtkWidget ** scales;
 	size_t scales_cnt;
 	guint timeout;
+} CPU;
+
+
+/* variables */
+/* the sample is shared by every instance */
+static struct
+{
+	gint64 time;
+	gdouble level;
 #if defined(__FreeBSD__) || defined(__NetBSD__)
 	int used;
 	int total;
 #endif
-} CPU;
+} _cpu_sample;
 
 
 /* prototypes */
@@ -151,11 +160,8 @@ static CPU * _cpu_init(PanelAppletHelper * helper, GtkWidget ** widget)
 		gtk_box_pack_start(GTK_BOX(cpu->widget), cpu->scales[i], FALSE,
 				FALSE, 0);
 	}
-	cpu->timeout = g_timeout_add(timeout, _cpu_on_timeout, cpu);
-#if defined(__FreeBSD__) || defined(__NetBSD__)
-	cpu->used = 0;
-	cpu->total = 0;
-#endif
+	cpu->timeout = helper->timeout_add(helper->panel, timeout,
+			_cpu_on_timeout, cpu);
 	_cpu_on_timeout(cpu);
 	pango_font_description_free(desc);
 	gtk_widget_show_all(cpu->widget);
@@ -169,7 +175,7 @@ static void _cpu_destroy(CPU * cpu)
 {
 	free(cpu->scales);
 	if(cpu->timeout > 0)
-		g_source_remove(cpu->timeout);
+		cpu->helper->timeout_remove(cpu->helper->panel, cpu->timeout);
 	gtk_widget_destroy(cpu->widget);
 	free(cpu);
 }
@@ -189,12 +195,20 @@ static gboolean _cpu_get(CPU * cpu, size_t index, gdouble * level)
 	size_t size = sizeof(cpu_time);
 	int used;
 	int total;
+	gint64 now;
 
 	if(index >= cpu->scales_cnt)
 	{
 		error_set("%s %zu: %s", applet.name, index, strerror(ERANGE));
 		return FALSE;
 	}
+	now = g_get_monotonic_time();
+	if(_cpu_sample.time != 0 && now - _cpu_sample.time
+			< PANEL_APPLET_SAMPLE_AGE * 1000)
+	{
+		*level = _cpu_sample.level;
+		return TRUE;
+	}
 # if defined(__FreeBSD__)
 	if(sysctlbyname(name, &cpu_time, &size, NULL, 0) < 0)
 # elif defined(__NetBSD__)
@@ -209,12 +223,15 @@ static gboolean _cpu_get(CPU * cpu, size_t index, gdouble * level)
 	used = cpu_time[CP_USER] + cpu_time[CP_SYS] + cpu_time[CP_NICE]
 		+ cpu_time[CP_INTR];
 	total = used + cpu_time[CP_IDLE];
-	if(cpu->used == 0 || total == cpu->total)
+	if(_cpu_sample.used == 0 || total == _cpu_sample.total)
 		*level = 0.0;
 	else
-		*level = 100.0 * (used - cpu->used) / (total - cpu->total);
-	cpu->used = used;
-	cpu->total = total;
+		*level = 100.0 * (used - _cpu_sample.used)
+			/ (total - _cpu_sample.total);
+	_cpu_sample.time = now;
+	_cpu_sample.level = *level;
+	_cpu_sample.used = used;
+	_cpu_sample.total = total;
 	return TRUE;
 #else
 	(void) cpu;
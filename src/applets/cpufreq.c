@@ -175,9 +175,10 @@ static Cpufreq * _cpufreq_init(PanelAppletHelper * helper, GtkWidget ** widget)
 			0);
 	label = gtk_label_new(_("MHz"));
 	gtk_box_pack_start(GTK_BOX(cpufreq->hbox), label, FALSE, TRUE, 0);
+	cpufreq->timeout = 0;
 	if(_cpufreq_on_timeout(cpufreq) == TRUE)
-		cpufreq->timeout = g_timeout_add(timeout, _cpufreq_on_timeout,
-				cpufreq);
+		cpufreq->timeout = helper->timeout_add(helper->panel, timeout,
+				_cpufreq_on_timeout, cpufreq);
 	pango_font_description_free(desc);
 	gtk_widget_show_all(cpufreq->hbox);
 	*widget = cpufreq->hbox;
@@ -192,7 +193,9 @@ static Cpufreq * _cpufreq_init(PanelAppletHelper * helper, GtkWidget ** widget)
 /* cpufreq_destroy */
 static void _cpufreq_destroy(Cpufreq * cpufreq)
 {
-	g_source_remove(cpufreq->timeout);
+	if(cpufreq->timeout != 0)
+		cpufreq->helper->timeout_remove(cpufreq->helper->panel,
+				cpufreq->timeout);
 	gtk_widget_destroy(cpufreq->hbox);
 	free(cpufreq);
 }
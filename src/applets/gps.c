@@ -93,7 +93,8 @@ static GPS * _gps_init(PanelAppletHelper * helper, GtkWidget ** widget)
 	gtk_widget_set_tooltip_text(gps->image, _("GPS is enabled"));
 #endif
 	gps->timeout = (_gps_on_timeout(gps) == TRUE)
-		? g_timeout_add(timeout, _gps_on_timeout, gps) : 0;
+		? helper->timeout_add(helper->panel, timeout, _gps_on_timeout,
+				gps) : 0;
 	gtk_widget_set_no_show_all(gps->image, TRUE);
 	*widget = gps->image;
 	return gps;
@@ -104,7 +105,7 @@ static GPS * _gps_init(PanelAppletHelper * helper, GtkWidget ** widget)
 static void _gps_destroy(GPS * gps)
 {
 	if(gps->timeout > 0)
-		g_source_remove(gps->timeout);
+		gps->helper->timeout_remove(gps->helper->panel, gps->timeout);
 #if defined(__linux__)
 	if(gps->fd != -1)
 		close(gps->fd);
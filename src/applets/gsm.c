@@ -104,7 +104,8 @@ static GSM * _gsm_init(PanelAppletHelper * helper, GtkWidget ** widget)
 	gtk_widget_show(gsm->image);
 	gtk_box_pack_start(GTK_BOX(gsm->hbox), gsm->image, FALSE, TRUE, 0);
 	gsm->timeout = (_gsm_on_timeout(gsm) == TRUE)
-		? g_timeout_add(timeout, _gsm_on_timeout, gsm) : 0;
+		? helper->timeout_add(helper->panel, timeout, _gsm_on_timeout,
+				gsm) : 0;
 	gtk_widget_set_no_show_all(gsm->hbox, TRUE);
 	*widget = gsm->hbox;
 	return gsm;
@@ -115,7 +116,7 @@ static GSM * _gsm_init(PanelAppletHelper * helper, GtkWidget ** widget)
 static void _gsm_destroy(GSM * gsm)
 {
 	if(gsm->timeout > 0)
-		g_source_remove(gsm->timeout);
+		gsm->helper->timeout_remove(gsm->helper->panel, gsm->timeout);
 #if defined(__linux__)
 	if(gsm->fd != -1)
 		close(gsm->fd);
@@ -125,7 +125,8 @@ static void _leds_destroy(LEDs * leds)
 #if defined(GDK_WINDOWING_X11)
 	/* XXX free xkb? */
 	if(leds->timeout != 0)
-		g_source_remove(leds->timeout);
+		leds->helper->timeout_remove(leds->helper->panel,
+				leds->timeout);
 	if(leds->source != 0)
 		g_signal_handler_disconnect(leds->widget, leds->source);
 	gtk_widget_destroy(leds->widget);
@@ -161,7 +162,7 @@ static void _leds_on_screen_changed(GtkWidget * widget, GdkScreen * previous,
 		/* XXX free xkb? */
 		leds->xkb = NULL;
 	if(leds->timeout != 0)
-		g_source_remove(leds->timeout);
+		helper->timeout_remove(helper->panel, leds->timeout);
 	leds->timeout = 0;
 	screen = gtk_widget_get_screen(widget);
 	leds->display = gdk_screen_get_display(screen);
@@ -209,7 +210,8 @@ static void _leds_on_screen_changed(GtkWidget * widget, GdkScreen * previous,
 			XkbIndicatorStateNotifyMask);
 	/* FIXME react on XKB events instead */
 	if(_leds_on_timeout(leds) != FALSE)
-		leds->source = g_timeout_add(timeout, _leds_on_timeout, leds);
+		leds->timeout = helper->timeout_add(helper->panel, timeout,
+				_leds_on_timeout, leds);
 }
 
 
@@ -1,5 +1,5 @@
 /* $Id$ */
-/* Copyright (c) 2010-2023 Pierre Pronchery <khorben@defora.org> */
+/* Copyright (c) 2010-2026 Pierre Pronchery <khorben@defora.org> */
 /* This file is part of DeforaOS Desktop Panel */
 /* This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -48,6 +48,15 @@ typedef struct _PanelApplet
 } Memory;
 
 
+/* variables */
+/* the sample is shared by every instance */
+static struct
+{
+	gint64 time;
+	gdouble level;
+} _memory_sample;
+
+
 /* prototypes */
 static Memory * _memory_init(PanelAppletHelper * helper, GtkWidget ** widget);
 static void _memory_destroy(Memory * memory);
@@ -132,7 +141,8 @@ static Memory * _memory_init(PanelAppletHelper * helper, GtkWidget ** widget)
 #endif
 	gtk_box_pack_start(GTK_BOX(memory->widget), memory->scale, FALSE, FALSE,
 			0);
-	memory->timeout = g_timeout_add(timeout, _memory_on_timeout, memory);
+	memory->timeout = helper->timeout_add(helper->panel, timeout,
+			_memory_on_timeout, memory);
 	_memory_on_timeout(memory);
 	pango_font_description_free(desc);
 	gtk_widget_show_all(memory->widget);
@@ -148,7 +158,9 @@ static Memory * _memory_init(PanelAppletHelper * helper, GtkWidget ** widget)
 /* memory_destroy */
 static void _memory_destroy(Memory * memory)
 {
-	g_source_remove(memory->timeout);
+	if(memory->timeout != 0)
+		memory->helper->timeout_remove(memory->helper->panel,
+				memory->timeout);
 	gtk_widget_destroy(memory->widget);
 	free(memory);
 }
@@ -177,7 +189,15 @@ static gboolean _memory_on_timeout(gpointer data)
 	Memory * memory = data;
 	struct sysinfo sy;
 	gdouble value;
+	gint64 now;
 
+	now = g_get_monotonic_time();
+	if(_memory_sample.time != 0 && now - _memory_sample.time
+			< PANEL_APPLET_SAMPLE_AGE * 1000)
+	{
+		_memory_set(memory, _memory_sample.level);
+		return TRUE;
+	}
 	if(sysinfo(&sy) != 0)
 	{
 		error_set("%s: %s: %s", applet.name, "sysinfo",
@@ -186,6 +206,8 @@ static gboolean _memory_on_timeout(gpointer data)
 	}
 	value = sy.sharedram;
 	value /= sy.totalram;
+	_memory_sample.time = now;
+	_memory_sample.level = value;
 	_memory_set(memory, value);
 	return TRUE;
 }
@@ -197,7 +219,15 @@ static gboolean _memory_on_timeout(gpointer data)
 	struct vmtotal vm;
 	size_t size = sizeof(vm);
 	gdouble value;
+	gint64 now;
 
+	now = g_get_monotonic_time();
+	if(_memory_sample.time != 0 && now - _memory_sample.time
+			< PANEL_APPLET_SAMPLE_AGE * 1000)
+	{
+		_memory_set(memory, _memory_sample.level);
+		return TRUE;
+	}
 	if(sysctl(mib, 2, &vm, &size, NULL, 0) != 0)
 	{
 		error_set("%s: %s: %s", applet.name, "sysctl",
@@ -206,6 +236,8 @@ static gboolean _memory_on_timeout(gpointer data)
 	}
 	value = vm.t_arm * 100;
 	value /= (vm.t_rm + vm.t_free);
+	_memory_sample.time = now;
+	_memory_sample.level = value;
 	_memory_set(memory, value);
 	return TRUE;
 }
@@ -15,13 +15,14 @@
 
 
 
+#include <sys/mman.h>
 #include <sys/stat.h>
-#if defined(__sun)
-# include <fcntl.h>
-#endif
+#include <fcntl.h>
 #include <dirent.h>
 #include <unistd.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <stdio.h>
 #include <string.h>
 #include <errno.h>
 #include <libintl.h>
@@ -51,21 +52,149 @@
 /* Menu */
 /* private */
 /* types */
+typedef struct _MenuApp MenuApp;
+typedef struct _MenuCache MenuCache;
+typedef struct _MenuDir MenuDir;
+typedef struct _MenuLoad MenuLoad;
+
 typedef struct _PanelApplet
 {
 	PanelAppletHelper * helper;
-	GSList * apps;
+	MenuApp * apps;			/* sorted by name		*/
+	size_t apps_cnt;
+	MenuLoad * load;		/* while loading the entries	*/
 	guint idle;
-	gboolean refresh;
-	time_t refresh_mti;
+
+	/* changes */
+	MenuDir * dirs;
+	size_t dirs_cnt;
+	GHashTable * changes;		/* the paths, to their directory */
+	guint source;			/* coalesces the changes	*/
+	guint poll;
+
+	/* menus */
+	GtkWidget * applications;	/* kept until the entries change */
+	guint build;
+	GtkWidget * menushell;		/* the last one popped up	*/
+
 	GtkWidget * widget;
 } Menu;
 
-typedef struct _MenuApp
+struct _MenuDir
 {
-	MimeHandler * handler;
+	Menu * menu;
+	String * path;
+	String * apppath;
+	GFileMonitor * monitor;		/* polled if NULL		*/
+	time_t mtime;
+};
+
+typedef enum _MenuAppFlag
+{
+	MENU_APP_FLAG_HIDDEN	= 0x1,	/* cannot be displayed		*/
+	MENU_APP_FLAG_INVALID	= 0x2,	/* could not be loaded		*/
+	MENU_APP_FLAG_NOEXEC	= 0x4	/* cannot be executed (yet)	*/
+} MenuAppFlag;
+#define MENU_APP_FLAG_SKIP	(MENU_APP_FLAG_HIDDEN | MENU_APP_FLAG_INVALID \
+		| MENU_APP_FLAG_NOEXEC)
+
+struct _MenuApp
+{
+	MimeHandler * handler;		/* only loaded when activated	*/
+	char * filename;
 	char * path;
-} MenuApp;
+	char * name;
+	char * comment;
+	char * icon;
+	int category;			/* in _menu_categories, or -1	*/
+	char * key;			/* to collate the names		*/
+};
+
+/* the index of the entries, as stored in the cache file: the header, the
+ * directories, the entries of every directory sorted by filename, then the
+ * strings; the strings are referred to by offset, 0 meaning none */
+typedef struct _MenuCacheHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t dirs_cnt;
+	uint32_t entries_cnt;
+	uint32_t strings_size;
+	uint32_t locale;
+} MenuCacheHeader;
+
+typedef struct _MenuCacheDir
+{
+	int64_t mtime;
+	uint32_t path;
+	uint32_t first;
+	uint32_t cnt;
+	uint32_t mtime_nsec;
+} MenuCacheDir;
+
+typedef struct _MenuCacheEntry
+{
+	int64_t mtime;
+	int64_t size;
+	uint32_t filename;
+	uint32_t flags;
+	uint32_t name;			/* generic name, or name	*/
+	uint32_t comment;
+	uint32_t icon;
+	uint32_t categories;		/* separated by ';'		*/
+	uint32_t mtime_nsec;
+	uint32_t padding;
+} MenuCacheEntry;
+
+struct _MenuCache
+{
+	/* as previously saved */
+	void * map;
+	size_t map_size;
+	MenuCacheHeader const * header;
+	MenuCacheDir const * dirs;
+	MenuCacheEntry const * entries;
+	char const * strings;
+
+	/* as being loaded */
+	MenuCacheDir * ndirs;
+	size_t ndirs_cnt;
+	MenuCacheEntry * nentries;
+	size_t nentries_cnt;
+	char * nstrings;
+	size_t nstrings_size;
+	gboolean changed;
+};
+
+typedef struct _MenuLoadError
+{
+	gchar * path;
+	int code;			/* or 0 to load the file again	*/
+} MenuLoadError;
+
+/* the directories are loaded by the threads, then merged from the main thread
+ * once they are all done; as neither libSystem nor libDesktop are thread-safe,
+ * the threads only rely on GLib */
+typedef struct _MenuLoadDir
+{
+	String * path;
+	String * apppath;
+	MenuCache * cache;		/* for this directory only	*/
+	MenuApp * apps;
+	size_t apps_cnt;
+	MenuLoadError * errors;
+	size_t errors_cnt;
+} MenuLoadDir;
+
+struct _MenuLoad
+{
+	MenuCache * cache;
+	GThreadPool * pool;
+	MenuLoadDir * dirs;
+	size_t dirs_cnt;
+	gint pending;
+	gint cancel;
+};
 
 typedef struct _MenuCategory
 {
@@ -93,6 +222,20 @@ static const MenuCategory _menu_categories[] =
 };
 #define MENU_MENUS_COUNT (sizeof(_menu_categories) / sizeof(*_menu_categories))
 
+#define MENU_CACHE_FILE		"menu.cache"
+#define MENU_CACHE_MAGIC	0x504d4e55
+#define MENU_CACHE_VERSION	2
+
+/* the modifications within the same second must be noticed as well */
+#ifdef __APPLE__
+# define MENU_MTIME_NSEC(st)	((st)->st_mtimespec.tv_nsec)
+#else
+# define MENU_MTIME_NSEC(st)	((st)->st_mtim.tv_nsec)
+#endif
+
+#define MENU_WATCH_DELAY	250	/* in milliseconds		*/
+#define MENU_WATCH_POLL		10	/* in seconds			*/
+
 
 /* prototypes */
 static Menu * _menu_init(PanelAppletHelper * helper, GtkWidget ** widget);
@@ -100,22 +243,33 @@ static void _menu_destroy(Menu * menu);
 
 /* helpers */
 static GtkWidget * _menu_applications(Menu * menu);
+static void _menu_change(Menu * menu, MenuDir * dir, gchar * filename);
 static GtkWidget * _menu_icon(Menu * menu, char const * path,
 		char const * icon);
+static int _menu_load(Menu * menu);
+static void _menu_invalidate(Menu * menu);
+static void _menu_load_merge(Menu * menu);
 static GtkWidget * _menu_menuitem(Menu * menu, char const * path,
 		char const * label, char const * icon);
 static GtkWidget * _menu_menuitem_stock(char const * icon, char const * label,
 		gboolean mnemonic);
+static void _menu_reset(Menu * menu);
+static void _menu_watch(Menu * menu);
 
 static void _menu_xdg_dirs(Menu * menu, void (*callback)(Menu * menu,
 			char const * path, char const * apppath));
 
 /* callbacks */
 static void _menu_on_about(gpointer data);
+static gboolean _menu_on_build(gpointer data);
+static void _menu_on_changed(GFileMonitor * monitor, GFile * file,
+		GFile * other, GFileMonitorEvent event, gpointer data);
 static void _menu_on_clicked(gpointer data);
 static gboolean _menu_on_idle(gpointer data);
+static gboolean _menu_on_loading(gpointer data);
 static void _menu_on_lock(gpointer data);
 static void _menu_on_logout(gpointer data);
+static gboolean _menu_on_refresh(gpointer data);
 #ifdef EMBEDDED
 static void _menu_on_rotate(gpointer data);
 #endif
@@ -125,8 +279,46 @@ static void _menu_on_suspend(gpointer data);
 static gboolean _menu_on_timeout(gpointer data);
 
 /* MenuApp */
-static MenuApp * _menuapp_new(MimeHandler * handler, String const * path);
-static void _menuapp_delete(MenuApp * menuapp);
+static int _menuapp_init(MenuApp * menuapp, MenuCache * cache,
+		MenuCacheEntry const * entry, String const * path,
+		String const * apppath);
+static void _menuapp_destroy(MenuApp * menuapp);
+
+/* MenuCache */
+static MenuCache * _menucache_new(void);
+static MenuCache * _menucache_new_dir(MenuCache * cache);
+static void _menucache_delete(MenuCache * cache);
+
+/* accessors */
+static char const * _menucache_get_string(MenuCache * cache, uint32_t offset);
+static char const * _menucache_get_nstring(MenuCache * cache,
+		uint32_t offset);
+
+/* useful */
+static int _menucache_add_dir(MenuCache * cache, char const * path,
+		struct stat const * st, size_t first);
+static int _menucache_add_entry(MenuCache * cache, char const * filename,
+		struct stat const * st, unsigned int flags, char const * name,
+		char const * comment, char const * icon,
+		char const * categories);
+static int _menucache_add_string(MenuCache * cache, char const * s,
+		uint32_t * offset);
+static int _menucache_copy_entry(MenuCache * cache,
+		MenuCacheEntry const * entry);
+static MenuCacheDir const * _menucache_lookup_dir(MenuCache * cache,
+		char const * path);
+static MenuCacheEntry const * _menucache_lookup_entry(MenuCache * cache,
+		MenuCacheDir const * dir, char const * filename);
+static int _menucache_merge(MenuCache * cache, MenuCache * dir);
+static int _menucache_save(MenuCache * cache);
+
+/* MenuLoad */
+static void _menuload_delete(MenuLoad * load);
+
+/* MenuLoadDir */
+static int _menuloaddir_init(MenuLoadDir * dir, MenuCache * cache,
+		String const * path, String const * apppath);
+static void _menuloaddir_destroy(MenuLoadDir * dir);
 
 
 /* public */
@@ -163,8 +355,18 @@ static Menu * _menu_init(PanelAppletHelper * helper, GtkWidget ** widget)
 	}
 	menu->helper = helper;
 	menu->apps = NULL;
+	menu->apps_cnt = 0;
+	menu->load = NULL;
 	menu->idle = g_idle_add(_menu_on_idle, menu);
-	menu->refresh_mti = 0;
+	menu->dirs = NULL;
+	menu->dirs_cnt = 0;
+	menu->changes = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+			NULL);
+	menu->source = 0;
+	menu->poll = 0;
+	menu->applications = NULL;
+	menu->build = 0;
+	menu->menushell = NULL;
 	menu->widget = gtk_button_new();
 	hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 4);
 	if((p = helper->config_get(helper->panel, "menu", "icon")) == NULL)
@@ -201,10 +403,41 @@ static Menu * _menu_init(PanelAppletHelper * helper, GtkWidget ** widget)
 /* menu_destroy */
 static void _menu_destroy(Menu * menu)
 {
+	size_t i;
+
 	if(menu->idle != 0)
 		g_source_remove(menu->idle);
-	g_slist_foreach(menu->apps, (GFunc)_menuapp_delete, NULL);
-	g_slist_free(menu->apps);
+	if(menu->source != 0)
+		g_source_remove(menu->source);
+	if(menu->poll != 0)
+		g_source_remove(menu->poll);
+	if(menu->build != 0)
+		g_source_remove(menu->build);
+	if(menu->load != NULL)
+		_menuload_delete(menu->load);
+	for(i = 0; i < menu->dirs_cnt; i++)
+	{
+		if(menu->dirs[i].monitor != NULL)
+		{
+			g_file_monitor_cancel(menu->dirs[i].monitor);
+			g_object_unref(menu->dirs[i].monitor);
+		}
+		string_delete(menu->dirs[i].path);
+		string_delete(menu->dirs[i].apppath);
+	}
+	free(menu->dirs);
+	g_hash_table_destroy(menu->changes);
+	if(menu->applications != NULL)
+	{
+		if(gtk_menu_get_attach_widget(GTK_MENU(menu->applications))
+				!= NULL)
+			gtk_menu_detach(GTK_MENU(menu->applications));
+		gtk_widget_destroy(menu->applications);
+		g_object_unref(menu->applications);
+	}
+	if(menu->menushell != NULL)
+		gtk_widget_destroy(menu->menushell);
+	_menu_reset(menu);
 	gtk_widget_destroy(menu->widget);
 	free(menu);
 }
@@ -213,104 +446,90 @@ static void _menu_destroy(Menu * menu)
 /* helpers */
 /* menu_applications */
 static void _applications_on_activate(gpointer data);
-static void _applications_categories(GtkWidget * menu, GtkWidget ** menus);
+static void _applications_on_show(GtkWidget * widget, gpointer data);
+static void _applications_categories(Menu * menu, GtkWidget * menushell,
+		GtkWidget ** menus);
+static GtkWidget * _applications_menuitem(Menu * menu, MenuApp * menuapp);
 
 static GtkWidget * _menu_applications(Menu * menu)
 {
 	GtkWidget * menus[MENU_MENUS_COUNT];
-	GSList * p;
+	size_t i;
 	GtkWidget * menushell;
 	GtkWidget * menuitem;
 	MenuApp * menuapp;
-	MimeHandler * handler;
-	char const * name;
-#if GTK_CHECK_VERSION(2, 12, 0)
-	char const * comment;
-#endif
-	char const * q;
-	String const ** categories;
-	size_t i;
-	size_t j;
 
+	/* kept until the entries change */
+	if(menu->applications != NULL)
+		return menu->applications;
+	/* wait for the entries if not loaded yet */
 	if(menu->apps == NULL)
-		_menu_on_idle(menu);
+	{
+		if(menu->load == NULL && _menu_load(menu) != 0)
+			menu->helper->error(NULL, error_get(NULL), 1);
+		_menu_load_merge(menu);
+	}
+	if(menu->build != 0)
+		g_source_remove(menu->build);
+	menu->build = 0;
 	memset(&menus, 0, sizeof(menus));
 	menushell = gtk_menu_new();
-	for(p = menu->apps; p != NULL; p = p->next)
+	for(i = 0; i < menu->apps_cnt; i++)
 	{
-		menuapp = p->data;
-		handler = menuapp->handler;
-		if((name = mimehandler_get_name(handler, 1)) == NULL)
-		{
-			menu->helper->error(NULL, error_get(NULL), 0);
-			continue;
-		}
-#if GTK_CHECK_VERSION(2, 12, 0)
-		comment = mimehandler_get_comment(handler, 1);
-#endif
-		if((q = mimehandler_get_generic_name(handler, 1)) != NULL)
-		{
-#if GTK_CHECK_VERSION(2, 12, 0)
-			if(comment == NULL)
-				comment = name;
-#endif
-			name = q;
-		}
-		menuitem = _menu_menuitem(menu, menuapp->path, name,
-				mimehandler_get_icon(handler, 1));
-#if GTK_CHECK_VERSION(2, 12, 0)
-		if(comment != NULL)
-			gtk_widget_set_tooltip_text(menuitem, comment);
-#endif
-		if(mimehandler_get_type(handler)
-				== MIMEHANDLER_TYPE_APPLICATION
-				&& mimehandler_can_execute(handler) == 0)
-			gtk_widget_set_sensitive(menuitem, FALSE);
-		else
-			g_signal_connect_swapped(menuitem, "activate",
-					G_CALLBACK(_applications_on_activate),
-					handler);
-		if((categories = mimehandler_get_categories(handler)) == NULL
-				|| categories[0] == NULL)
+		menuapp = &menu->apps[i];
+		/* the categories are only populated once shown */
+		if(menuapp->category >= 0)
 		{
-			gtk_menu_shell_append(GTK_MENU_SHELL(menushell),
-					menuitem);
+			if(menus[menuapp->category] == NULL)
+				menus[menuapp->category] = gtk_menu_new();
 			continue;
 		}
-		for(i = 0; i < MENU_MENUS_COUNT; i++)
-		{
-			for(j = 0; categories[j] != NULL; j++)
-				if(string_compare(_menu_categories[i].category,
-							categories[j]) == 0)
-					break;
-			if(categories[j] != NULL)
-				break;
-		}
-		if(i == MENU_MENUS_COUNT)
-			gtk_menu_shell_append(GTK_MENU_SHELL(menushell),
-					menuitem);
-		else
-		{
-			if(menus[i] == NULL)
-				menus[i] = gtk_menu_new();
-			gtk_menu_shell_append(GTK_MENU_SHELL(menus[i]),
-					menuitem);
-		}
+		menuitem = _applications_menuitem(menu, menuapp);
+		gtk_menu_shell_append(GTK_MENU_SHELL(menushell), menuitem);
 	}
-	_applications_categories(menushell, menus);
+	_applications_categories(menu, menushell, menus);
+	menu->applications = g_object_ref_sink(menushell);
 	return menushell;
 }
 
 static void _applications_on_activate(gpointer data)
 {
-	MimeHandler * handler = data;
+	MenuApp * menuapp = data;
 
-	if(mimehandler_open(handler, NULL) != 0)
+	/* only loaded once actually needed */
+	if(menuapp->handler == NULL && (menuapp->handler
+				= mimehandler_new_load(menuapp->filename))
+			== NULL)
 		/* XXX really report error */
 		error_print(NULL);
+	else if(mimehandler_open(menuapp->handler, NULL) != 0)
+		/* XXX really report error */
+		error_print(NULL);
+}
+
+static void _applications_on_show(GtkWidget * widget, gpointer data)
+{
+	Menu * menu = data;
+	int category;
+	size_t i;
+	GtkWidget * menuitem;
+
+	/* populated only once */
+	g_signal_handlers_disconnect_by_func(widget, _applications_on_show,
+			data);
+	category = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(widget),
+				"category"));
+	for(i = 0; i < menu->apps_cnt; i++)
+	{
+		if(menu->apps[i].category != category)
+			continue;
+		menuitem = _applications_menuitem(menu, &menu->apps[i]);
+		gtk_menu_shell_append(GTK_MENU_SHELL(widget), menuitem);
+	}
 }
 
-static void _applications_categories(GtkWidget * menu, GtkWidget ** menus)
+static void _applications_categories(Menu * menu, GtkWidget * menushell,
+		GtkWidget ** menus)
 {
 	size_t i;
 	MenuCategory const * m;
@@ -323,11 +542,45 @@ static void _applications_categories(GtkWidget * menu, GtkWidget ** menus)
 			continue;
 		m = &_menu_categories[i];
 		menuitem = _menu_menuitem_stock(m->stock, _(m->label), FALSE);
+		/* shown before the submenu is set, not to show it as well */
+		gtk_widget_show_all(menuitem);
+		g_object_set_data(G_OBJECT(menus[i]), "category",
+				GINT_TO_POINTER(i));
+		g_signal_connect(menus[i], "show", G_CALLBACK(
+					_applications_on_show), menu);
 		gtk_menu_item_set_submenu(GTK_MENU_ITEM(menuitem), menus[i]);
-		gtk_menu_shell_insert(GTK_MENU_SHELL(menu), menuitem, pos++);
+		gtk_menu_shell_insert(GTK_MENU_SHELL(menushell), menuitem,
+				pos++);
 	}
 }
 
+static GtkWidget * _applications_menuitem(Menu * menu, MenuApp * menuapp)
+{
+	GtkWidget * menuitem;
+
+	menuitem = _menu_menuitem(menu, menuapp->path, menuapp->name,
+			menuapp->icon);
+#if GTK_CHECK_VERSION(2, 12, 0)
+	if(menuapp->comment != NULL)
+		gtk_widget_set_tooltip_text(menuitem, menuapp->comment);
+#endif
+	g_signal_connect_swapped(menuitem, "activate", G_CALLBACK(
+				_applications_on_activate), menuapp);
+	gtk_widget_show_all(menuitem);
+	return menuitem;
+}
+
+
+/* menu_change */
+static void _menu_change(Menu * menu, MenuDir * dir, gchar * filename)
+{
+	/* the files are usually written in several steps */
+	g_hash_table_replace(menu->changes, filename, dir);
+	if(menu->source == 0)
+		menu->source = g_timeout_add(MENU_WATCH_DELAY,
+				_menu_on_refresh, menu);
+}
+
 
 /* menu_icon */
 static GtkWidget * _menu_icon(Menu * menu, char const * path, char const * icon)
@@ -365,168 +618,809 @@ static GtkWidget * _menu_icon(Menu * menu, char const * path, char const * icon)
 }
 
 
-/* menu_menuitem */
-static GtkWidget * _menu_menuitem(Menu * menu, char const * path,
-		char const * label, char const * icon)
+/* menu_invalidate */
+static void _menu_invalidate(Menu * menu)
 {
-	GtkWidget * ret;
-	GtkWidget * image;
-
-	ret = gtk_image_menu_item_new_with_label(label);
-	if(icon != NULL)
+	/* the menu items refer to the entries */
+	if(menu->applications != NULL)
 	{
-		image = _menu_icon(menu, path, icon);
-		gtk_image_menu_item_set_image(GTK_IMAGE_MENU_ITEM(ret), image);
+		if(gtk_menu_get_attach_widget(GTK_MENU(menu->applications))
+				!= NULL)
+			gtk_menu_detach(GTK_MENU(menu->applications));
+		gtk_widget_destroy(menu->applications);
+		g_object_unref(menu->applications);
+		menu->applications = NULL;
 	}
-	return ret;
+	/* built again in the background, once the entries are known */
+	if(menu->build == 0)
+		menu->build = g_idle_add_full(G_PRIORITY_LOW, _menu_on_build,
+				menu, NULL);
 }
 
 
-/* menu_menuitem_stock */
-static GtkWidget * _menu_menuitem_stock(char const * icon, char const * label,
-		gboolean mnemonic)
+/* menu_load */
+static void _load_path(Menu * menu, char const * path, char const * apppath);
+static void _load_thread(gpointer data, gpointer user_data);
+static void _load_dir(MenuLoadDir * dir, gint * cancel);
+static void _load_dir_apps(MenuLoadDir * dir, size_t first);
+static char ** _load_dir_list(MenuLoadDir * dir, DIR * d, size_t * cnt);
+static int _dir_list_compare(void const * a, void const * b);
+static gboolean _load_dir_filter(char const * filename);
+static void _load_dir_entry(MenuLoadDir * dir, int fd,
+		MenuCacheDir const * cdir, char const * filename);
+static void _load_dir_file(MenuLoadDir * dir, char const * filename,
+		struct stat const * st);
+static gboolean _file_can_display(GKeyFile * keyfile);
+static gboolean _file_can_execute(GKeyFile * keyfile);
+static void _load_dir_error(MenuLoadDir * dir, char const * path, int code);
+
+static int _menu_load(Menu * menu)
 {
-	GtkWidget * ret;
-	GtkWidget * image;
+	MenuLoad * load;
+	guint threads;
+	size_t i;
 
-	ret = (mnemonic) ? gtk_image_menu_item_new_with_mnemonic(label)
-		: gtk_image_menu_item_new_with_label(label);
-	if(icon != NULL)
+	/* watch the directories before they are read */
+	if(menu->dirs == NULL)
+		_menu_watch(menu);
+	if((load = object_new(sizeof(*load))) == NULL)
+		return -1;
+	load->pool = NULL;
+	load->dirs = NULL;
+	load->dirs_cnt = 0;
+	load->pending = 0;
+	load->cancel = 0;
+	if((load->cache = _menucache_new()) == NULL)
 	{
-		image = gtk_image_new_from_icon_name(icon, GTK_ICON_SIZE_MENU);
-		gtk_image_menu_item_set_image(GTK_IMAGE_MENU_ITEM(ret), image);
+		_menuload_delete(load);
+		return -1;
 	}
-	return ret;
+	/* the directories are listed from the main thread */
+	menu->load = load;
+	_menu_xdg_dirs(menu, _load_path);
+	if(load->dirs_cnt == 0)
+		return 0;
+	g_atomic_int_set(&load->pending, load->dirs_cnt);
+	threads = MIN(g_get_num_processors(), load->dirs_cnt);
+	load->pool = g_thread_pool_new(_load_thread, load, threads, FALSE,
+			NULL);
+	/* then loaded in parallel, one directory per task */
+	for(i = 0; i < load->dirs_cnt; i++)
+		if(load->pool != NULL)
+			g_thread_pool_push(load->pool, &load->dirs[i], NULL);
+		else
+			_load_thread(&load->dirs[i], load);
+	return 0;
 }
 
+static void _load_path(Menu * menu, char const * path, char const * apppath)
+{
+	MenuLoad * load = menu->load;
+	MenuLoadDir * p;
 
-/* menu_xdg_dirs */
-static void _xdg_dirs_home(Menu * menu, void (*callback)(Menu * menu,
-			char const * path, char const * apppath));
-static void _xdg_dirs_path(Menu * menu, void (*callback)(Menu * menu,
-			char const * path, char const * apppath),
-		char const * path);
+	if(apppath == NULL)
+		return;
+	if((p = realloc(load->dirs, sizeof(*p) * (load->dirs_cnt + 1)))
+			== NULL)
+	{
+		menu->helper->error(NULL, apppath, 1);
+		return;
+	}
+	load->dirs = p;
+	if(_menuloaddir_init(&load->dirs[load->dirs_cnt], load->cache, path,
+				apppath) != 0)
+	{
+		menu->helper->error(NULL, apppath, 1);
+		return;
+	}
+	load->dirs_cnt++;
+}
 
-static void _menu_xdg_dirs(Menu * menu, void (*callback)(Menu * menu,
-			char const * path, char const * apppath))
+static void _load_thread(gpointer data, gpointer user_data)
 {
-	char const * path;
-	char * p;
+	MenuLoadDir * dir = data;
+	MenuLoad * load = user_data;
+
+	if(g_atomic_int_get(&load->cancel) == 0)
+		_load_dir(dir, &load->cancel);
+	g_atomic_int_add(&load->pending, -1);
+}
+
+static void _load_dir(MenuLoadDir * dir, gint * cancel)
+{
+	MenuCache * cache = dir->cache;
+	DIR * d = NULL;
+	int fd = -1;
+	struct stat st;
+	MenuCacheDir const * cdir;
+	char ** names;
+	size_t cnt;
+	size_t first = cache->nentries_cnt;
 	size_t i;
-	size_t j;
-	int datadir = 1;
 
-	/* read through every XDG application folder */
-	if((path = getenv("XDG_DATA_DIRS")) == NULL || strlen(path) == 0)
-	{
-#if defined(__FreeBSD__)
-		/* XXX really detect if DATADIR is already included */
-		path = DATADIR ":/usr/share";
-#elif defined(__NetBSD__)
-		/* XXX include the default path for pkgsrc */
-		path = "/usr/pkg/share:" DATADIR ":/usr/share";
+#if defined(__sun)
+	if((fd = open(dir->apppath, O_RDONLY)) < 0
+			|| fstat(fd, &st) != 0
+			|| (d = fdopendir(fd)) == NULL)
 #else
-		path = "/usr/local/share:" DATADIR ":/usr/share";
+	if((d = opendir(dir->apppath)) == NULL
+			|| (fd = dirfd(d)) < 0
+			|| fstat(fd, &st) != 0)
 #endif
-		datadir = 0;
+	{
+		if(errno != ENOENT)
+			_load_dir_error(dir, dir->apppath, errno);
+		if(_menucache_lookup_dir(cache, dir->apppath) != NULL)
+			cache->changed = TRUE;
+		if(d != NULL)
+			closedir(d);
+		else if(fd >= 0)
+			close(fd);
+		return;
 	}
-	if((p = strdup(path)) == NULL)
-		menu->helper->error(NULL, "strdup", 1);
+	/* the same files are found if the directory did not change */
+	if((cdir = _menucache_lookup_dir(cache, dir->apppath)) != NULL
+			&& cdir->mtime == (int64_t)st.st_mtime
+			&& cdir->mtime_nsec == (uint32_t)MENU_MTIME_NSEC(&st))
+		for(i = 0; i < cdir->cnt && g_atomic_int_get(cancel) == 0;
+				i++)
+			_load_dir_entry(dir, fd, cdir, _menucache_get_string(
+						cache, cache->entries[
+						cdir->first + i].filename));
 	else
-		for(i = 0, j = 0;; i++)
-			if(p[i] == '\0')
-			{
-				string_rtrim(&p[j], "/");
-				_xdg_dirs_path(menu, callback, &p[j]);
-				datadir |= (strcmp(&p[j], DATADIR) == 0);
-				break;
-			}
-			else if(p[i] == ':')
-			{
-				p[i] = '\0';
-				string_rtrim(&p[j], "/");
-				_xdg_dirs_path(menu, callback, &p[j]);
-				datadir |= (strcmp(&p[j], DATADIR) == 0);
-				j = i + 1;
-			}
-	free(p);
-	if(datadir == 0)
-		_xdg_dirs_path(menu, callback, DATADIR);
-	_xdg_dirs_home(menu, callback);
+	{
+		cache->changed = TRUE;
+		names = _load_dir_list(dir, d, &cnt);
+		for(i = 0; i < cnt; i++)
+		{
+			if(g_atomic_int_get(cancel) == 0)
+				_load_dir_entry(dir, fd, cdir, names[i]);
+			free(names[i]);
+		}
+		free(names);
+	}
+	closedir(d);
+	if(_menucache_add_dir(cache, dir->apppath, &st, first) != 0)
+		_load_dir_error(dir, dir->apppath, errno);
+	_load_dir_apps(dir, first);
 }
 
-static void _xdg_dirs_home(Menu * menu, void (*callback)(Menu * menu,
-			char const * path, char const * apppath))
+static void _load_dir_apps(MenuLoadDir * dir, size_t first)
 {
-	char const fallback[] = ".local/share";
-	char const * path;
-	char const * homedir;
-	String * p;
+	MenuCache * cache = dir->cache;
+	MenuApp * p;
+	size_t i;
 
-	/* use $XDG_DATA_HOME if set and not empty */
-	if((path = getenv("XDG_DATA_HOME")) != NULL && strlen(path) > 0)
+	if(cache->nentries_cnt == first)
+		return;
+	/* room for every entry of this directory at once */
+	if((p = realloc(dir->apps, sizeof(*p) * (dir->apps_cnt
+						+ cache->nentries_cnt - first)))
+			== NULL)
 	{
-		_xdg_dirs_path(menu, callback, path);
+		_load_dir_error(dir, dir->apppath, errno);
 		return;
 	}
-	/* fallback to "$HOME/.local/share" */
-	if((homedir = getenv("HOME")) == NULL)
-		homedir = g_get_home_dir();
-	if((p = string_new_append(homedir, "/", fallback, NULL)) == NULL)
+	dir->apps = p;
+	for(i = first; i < cache->nentries_cnt; i++)
 	{
-		menu->helper->error(NULL, homedir, 1);
-		return;
+		/* skip this entry if cannot be displayed or opened */
+		if(cache->nentries[i].flags & MENU_APP_FLAG_SKIP)
+			continue;
+		if(_menuapp_init(&dir->apps[dir->apps_cnt], cache,
+					&cache->nentries[i], dir->path,
+					dir->apppath) != 0)
+		{
+			_load_dir_error(dir, dir->apppath, errno);
+			continue;
+		}
+		dir->apps_cnt++;
 	}
-	_xdg_dirs_path(menu, callback, p);
-	string_delete(p);
 }
 
-static void _xdg_dirs_path(Menu * menu, void (*callback)(Menu * menu,
-			char const * path, char const * apppath),
-		char const * path)
+static char ** _load_dir_list(MenuLoadDir * dir, DIR * d, size_t * cnt)
 {
-	const char applications[] = "/applications";
-	char * apppath;
+	char ** ret = NULL;
+	struct dirent * de;
+	char ** p;
 
-	if((apppath = string_new_append(path, applications, NULL)) == NULL)
-		menu->helper->error(NULL, path, 1);
-	callback(menu, path, apppath);
-	string_delete(apppath);
+	*cnt = 0;
+	while((de = readdir(d)) != NULL)
+	{
+		if(_load_dir_filter(de->d_name) != TRUE)
+			continue;
+		if((p = realloc(ret, sizeof(*p) * (*cnt + 1))) == NULL)
+		{
+			_load_dir_error(dir, dir->apppath, errno);
+			continue;
+		}
+		ret = p;
+		if((ret[*cnt] = strdup(de->d_name)) == NULL)
+		{
+			_load_dir_error(dir, dir->apppath, errno);
+			continue;
+		}
+		(*cnt)++;
+	}
+	/* the entries are kept sorted by filename in the cache */
+	if(*cnt > 1)
+		qsort(ret, *cnt, sizeof(*ret), _dir_list_compare);
+	return ret;
 }
 
-
-/* callbacks */
-/* menu_on_about */
-static void _menu_on_about(gpointer data)
+static int _dir_list_compare(void const * a, void const * b)
 {
-	Menu * menu = data;
+	char * const * sa = a;
+	char * const * sb = b;
 
-	menu->helper->about_dialog(menu->helper->panel);
+	return strcmp(*sa, *sb);
 }
 
+static gboolean _load_dir_filter(char const * filename)
+{
+	size_t len;
+	const char ext[] = ".desktop";
 
-/* menu_on_clicked */
-static void _clicked_position_menu(GtkMenu * widget, gint * x, gint * y,
-		gboolean * push_in, gpointer data);
+	if(filename[0] == '.')
+		if(filename[1] == '\0' || (filename[1] == '.'
+					&& filename[2] == '\0'))
+			return FALSE;
+	len = strlen(filename);
+	if(len < sizeof(ext))
+		return FALSE;
+	return (strncmp(&filename[len - sizeof(ext) + 1], ext, sizeof(ext))
+			== 0) ? TRUE : FALSE;
+}
 
-static void _menu_on_clicked(gpointer data)
+static void _load_dir_entry(MenuLoadDir * dir, int fd,
+		MenuCacheDir const * cdir, char const * filename)
 {
-	Menu * menu = data;
-	PanelAppletHelper * helper = menu->helper;
-	GtkWidget * menushell;
-	GtkWidget * menuitem;
-	GtkWidget * widget;
-	char const * p;
+	MenuCache * cache = dir->cache;
+	struct stat st;
+	MenuCacheEntry const * entry = NULL;
+	size_t cnt;
 
-	menushell = gtk_menu_new();
-	if((p = helper->config_get(helper->panel, "menu", "applications"))
-			== NULL || strtol(p, NULL, 0) != 0)
+	if(filename == NULL || fstatat(fd, filename, &st, 0) != 0)
 	{
-		menuitem = _menu_menuitem_stock("gnome-applications",
-				_("A_pplications"), TRUE);
-		widget = _menu_applications(menu);
-		gtk_menu_item_set_submenu(GTK_MENU_ITEM(menuitem), widget);
-		gtk_menu_shell_append(GTK_MENU_SHELL(menushell), menuitem);
+		/* removed in the meantime */
+		cache->changed = TRUE;
+		return;
+	}
+	if(cdir != NULL)
+		entry = _menucache_lookup_entry(cache, cdir, filename);
+	if(entry == NULL || entry->mtime != (int64_t)st.st_mtime
+			|| entry->mtime_nsec
+			!= (uint32_t)MENU_MTIME_NSEC(&st)
+			|| entry->size != (int64_t)st.st_size)
+	{
+		cache->changed = TRUE;
+		_load_dir_file(dir, filename, &st);
+		return;
+	}
+	if((entry->flags & MENU_APP_FLAG_NOEXEC) == 0)
+	{
+		if(_menucache_copy_entry(cache, entry) != 0)
+			_load_dir_error(dir, dir->apppath, errno);
+		return;
+	}
+	/* the program may have been installed since */
+	cnt = cache->nentries_cnt;
+	_load_dir_file(dir, filename, &st);
+	if(cache->nentries_cnt == cnt
+			|| cache->nentries[cnt].flags != entry->flags)
+		cache->changed = TRUE;
+}
+
+static void _load_dir_file(MenuLoadDir * dir, char const * filename,
+		struct stat const * st)
+{
+	char const section[] = G_KEY_FILE_DESKTOP_GROUP;
+	MenuCache * cache = dir->cache;
+	gchar * name;
+	GKeyFile * keyfile;
+	unsigned int flags = 0;
+	gchar * label;
+	gchar * comment;
+	gchar * icon;
+	gchar * p;
+	gchar ** categories;
+	GString * c = NULL;
+	size_t i;
+	int res;
+
+	name = g_strconcat(dir->apppath, "/", filename, NULL);
+#ifdef DEBUG
+	fprintf(stderr, "DEBUG: %s() \"%s\"\n", __func__, name);
+#endif
+	keyfile = g_key_file_new();
+	if(g_key_file_load_from_file(keyfile, name, G_KEY_FILE_NONE, NULL)
+			!= TRUE
+			|| g_key_file_has_group(keyfile, section) != TRUE)
+	{
+		/* reported with libDesktop from the main thread */
+		_load_dir_error(dir, name, 0);
+		g_free(name);
+		g_key_file_free(keyfile);
+		/* not loaded again until modified */
+		if(_menucache_add_entry(cache, filename, st,
+					MENU_APP_FLAG_INVALID, NULL, NULL,
+					NULL, NULL) != 0)
+			_load_dir_error(dir, dir->apppath, errno);
+		return;
+	}
+	if(_file_can_display(keyfile) != TRUE)
+		flags |= MENU_APP_FLAG_HIDDEN;
+	if(_file_can_execute(keyfile) != TRUE)
+		flags |= MENU_APP_FLAG_NOEXEC;
+	if((label = g_key_file_get_locale_string(keyfile, section, "Name",
+					NULL, NULL)) == NULL)
+	{
+		if((flags & MENU_APP_FLAG_SKIP) == 0)
+			_load_dir_error(dir, name, 0);
+		flags |= MENU_APP_FLAG_INVALID;
+	}
+	g_free(name);
+	comment = g_key_file_get_locale_string(keyfile, section, "Comment",
+			NULL, NULL);
+	if((p = g_key_file_get_locale_string(keyfile, section, "GenericName",
+					NULL, NULL)) != NULL)
+	{
+		if(comment == NULL)
+			comment = label;
+		else
+			g_free(label);
+		label = p;
+	}
+	icon = g_key_file_get_locale_string(keyfile, section, "Icon", NULL,
+			NULL);
+	if((categories = g_key_file_get_string_list(keyfile, section,
+					"Categories", NULL, NULL)) != NULL)
+	{
+		c = g_string_new(NULL);
+		for(i = 0; categories[i] != NULL; i++)
+			g_string_append_printf(c, "%s;", categories[i]);
+		g_strfreev(categories);
+	}
+	res = _menucache_add_entry(cache, filename, st, flags, label, comment,
+			icon, (c != NULL) ? c->str : NULL);
+	if(res != 0)
+		_load_dir_error(dir, dir->apppath, errno);
+	if(c != NULL)
+		g_string_free(c, TRUE);
+	g_free(label);
+	g_free(comment);
+	g_free(icon);
+	g_key_file_free(keyfile);
+}
+
+static gboolean _file_can_display(GKeyFile * keyfile)
+{
+	char const section[] = G_KEY_FILE_DESKTOP_GROUP;
+
+	if(g_key_file_get_boolean(keyfile, section, "NoDisplay", NULL)
+			|| g_key_file_get_boolean(keyfile, section, "Hidden",
+				NULL))
+		return FALSE;
+	return TRUE;
+}
+
+static gboolean _file_can_execute(GKeyFile * keyfile)
+{
+	char const section[] = G_KEY_FILE_DESKTOP_GROUP;
+	gchar * p;
+	gchar * q;
+	gboolean ret;
+
+	if((p = g_key_file_get_string(keyfile, section, "Type", NULL)) == NULL)
+		return FALSE;
+	ret = (strcmp(p, "Application") == 0) ? TRUE : FALSE;
+	g_free(p);
+	if(ret != TRUE || (p = g_key_file_get_string(keyfile, section, "Exec",
+					NULL)) == NULL)
+		return FALSE;
+	g_free(p);
+	/* the program may not be installed */
+	if((p = g_key_file_get_string(keyfile, section, "TryExec", NULL))
+			== NULL)
+		return TRUE;
+	q = g_find_program_in_path(p);
+	ret = (q != NULL) ? TRUE : FALSE;
+	g_free(q);
+	g_free(p);
+	return ret;
+}
+
+static void _load_dir_error(MenuLoadDir * dir, char const * path, int code)
+{
+	MenuLoadError * p;
+
+	/* only reported from the main thread */
+	if((p = realloc(dir->errors, sizeof(*p) * (dir->errors_cnt + 1)))
+			== NULL)
+		return;
+	dir->errors = p;
+	p = &dir->errors[dir->errors_cnt];
+	p->path = g_strdup(path);
+	p->code = code;
+	dir->errors_cnt++;
+}
+
+
+/* menu_load_merge */
+static void _load_merge_apps(Menu * menu, MenuLoadDir * dir);
+static void _load_merge_error(Menu * menu, MenuLoadError const * error);
+static int _load_apps_compare(void const * a, void const * b);
+
+static void _menu_load_merge(Menu * menu)
+{
+	MenuLoad * load = menu->load;
+	MenuLoadDir * dir;
+	size_t i;
+
+	if(load == NULL)
+		return;
+	/* wait for the directories still being loaded */
+	if(load->pool != NULL)
+	{
+		g_thread_pool_free(load->pool, FALSE, TRUE);
+		load->pool = NULL;
+	}
+	menu->load = NULL;
+	for(i = 0; i < load->dirs_cnt; i++)
+	{
+		dir = &load->dirs[i];
+		if(_menucache_merge(load->cache, dir->cache) != 0)
+			menu->helper->error(NULL, error_get(NULL), 1);
+		_load_merge_apps(menu, dir);
+	}
+	/* sorted at once, as collated in advance */
+	if(menu->apps_cnt > 1)
+		qsort(menu->apps, menu->apps_cnt, sizeof(*menu->apps),
+				_load_apps_compare);
+	if(_menucache_save(load->cache) != 0)
+		menu->helper->error(NULL, error_get(NULL), 1);
+	_menuload_delete(load);
+	if(menu->idle != 0)
+		g_source_remove(menu->idle);
+	menu->idle = 0;
+	_menu_invalidate(menu);
+}
+
+static void _load_merge_apps(Menu * menu, MenuLoadDir * dir)
+{
+	MenuApp * p;
+	size_t i;
+
+	for(i = 0; i < dir->errors_cnt; i++)
+		_load_merge_error(menu, &dir->errors[i]);
+	if(dir->apps_cnt == 0)
+		return;
+	if((p = realloc(menu->apps, sizeof(*p) * (menu->apps_cnt
+						+ dir->apps_cnt))) == NULL)
+	{
+		menu->helper->error(NULL, dir->apppath, 1);
+		return;
+	}
+	/* the applications now belong to the menu */
+	menu->apps = p;
+	memcpy(&p[menu->apps_cnt], dir->apps, sizeof(*p) * dir->apps_cnt);
+	menu->apps_cnt += dir->apps_cnt;
+	dir->apps_cnt = 0;
+}
+
+static void _load_merge_error(Menu * menu, MenuLoadError const * error)
+{
+	String * s;
+	MimeHandler * handler;
+
+	if(error->code != 0)
+	{
+		s = string_new_append(error->path, ": ", strerror(error->code),
+				NULL);
+		menu->helper->error(NULL, (s != NULL) ? s : error->path, 1);
+		string_delete(s);
+	}
+	/* the errors of libDesktop cannot be obtained from the threads */
+	else if((handler = mimehandler_new_load(error->path)) == NULL)
+		menu->helper->error(NULL, error_get(NULL), 1);
+	else
+	{
+		if(mimehandler_get_name(handler, 1) == NULL)
+			menu->helper->error(NULL, error_get(NULL), 1);
+		mimehandler_delete(handler);
+	}
+}
+
+static int _load_apps_compare(void const * a, void const * b)
+{
+	MenuApp const * maa = a;
+	MenuApp const * mab = b;
+	int ret;
+
+	if((ret = strcmp(maa->key, mab->key)) != 0)
+		return ret;
+	return strcmp(maa->filename, mab->filename);
+}
+
+
+/* menu_menuitem */
+static GtkWidget * _menu_menuitem(Menu * menu, char const * path,
+		char const * label, char const * icon)
+{
+	GtkWidget * ret;
+	GtkWidget * image;
+
+	ret = gtk_image_menu_item_new_with_label(label);
+	if(icon != NULL)
+	{
+		image = _menu_icon(menu, path, icon);
+		gtk_image_menu_item_set_image(GTK_IMAGE_MENU_ITEM(ret), image);
+	}
+	return ret;
+}
+
+
+/* menu_menuitem_stock */
+static GtkWidget * _menu_menuitem_stock(char const * icon, char const * label,
+		gboolean mnemonic)
+{
+	GtkWidget * ret;
+	GtkWidget * image;
+
+	ret = (mnemonic) ? gtk_image_menu_item_new_with_mnemonic(label)
+		: gtk_image_menu_item_new_with_label(label);
+	if(icon != NULL)
+	{
+		image = gtk_image_new_from_icon_name(icon, GTK_ICON_SIZE_MENU);
+		gtk_image_menu_item_set_image(GTK_IMAGE_MENU_ITEM(ret), image);
+	}
+	return ret;
+}
+
+
+/* menu_reset */
+static void _menu_reset(Menu * menu)
+{
+	size_t i;
+
+	for(i = 0; i < menu->apps_cnt; i++)
+		_menuapp_destroy(&menu->apps[i]);
+	free(menu->apps);
+	menu->apps = NULL;
+	menu->apps_cnt = 0;
+}
+
+
+/* menu_watch */
+static void _watch_path(Menu * menu, char const * path, char const * apppath);
+
+static void _menu_watch(Menu * menu)
+{
+	size_t i;
+	MenuDir * dir;
+	GFile * file;
+
+	/* the directories are all known before being monitored */
+	_menu_xdg_dirs(menu, _watch_path);
+	for(i = 0; i < menu->dirs_cnt; i++)
+	{
+		dir = &menu->dirs[i];
+		file = g_file_new_for_path(dir->apppath);
+		if((dir->monitor = g_file_monitor_directory(file,
+						G_FILE_MONITOR_NONE, NULL,
+						NULL)) != NULL)
+			g_signal_connect(dir->monitor, "changed", G_CALLBACK(
+						_menu_on_changed), dir);
+		else if(menu->poll == 0)
+			/* fallback to polling */
+			menu->poll = g_timeout_add_seconds(MENU_WATCH_POLL,
+					_menu_on_timeout, menu);
+		g_object_unref(file);
+	}
+}
+
+static void _watch_path(Menu * menu, char const * path, char const * apppath)
+{
+	MenuDir * p;
+	struct stat st;
+
+	if(apppath == NULL)
+		return;
+	if((p = realloc(menu->dirs, sizeof(*p) * (menu->dirs_cnt + 1)))
+			== NULL)
+	{
+		menu->helper->error(NULL, apppath, 1);
+		return;
+	}
+	menu->dirs = p;
+	p = &menu->dirs[menu->dirs_cnt];
+	p->menu = menu;
+	p->path = string_new(path);
+	p->apppath = string_new(apppath);
+	p->monitor = NULL;
+	p->mtime = (stat(apppath, &st) == 0) ? st.st_mtime : 0;
+	if(p->path == NULL || p->apppath == NULL)
+	{
+		menu->helper->error(NULL, apppath, 1);
+		string_delete(p->path);
+		string_delete(p->apppath);
+		return;
+	}
+	menu->dirs_cnt++;
+}
+
+
+/* menu_xdg_dirs */
+static void _xdg_dirs_home(Menu * menu, void (*callback)(Menu * menu,
+			char const * path, char const * apppath));
+static void _xdg_dirs_path(Menu * menu, void (*callback)(Menu * menu,
+			char const * path, char const * apppath),
+		char const * path);
+
+static void _menu_xdg_dirs(Menu * menu, void (*callback)(Menu * menu,
+			char const * path, char const * apppath))
+{
+	char const * path;
+	char * p;
+	size_t i;
+	size_t j;
+	int datadir = 1;
+
+	/* read through every XDG application folder */
+	if((path = getenv("XDG_DATA_DIRS")) == NULL || strlen(path) == 0)
+	{
+#if defined(__FreeBSD__)
+		/* XXX really detect if DATADIR is already included */
+		path = DATADIR ":/usr/share";
+#elif defined(__NetBSD__)
+		/* XXX include the default path for pkgsrc */
+		path = "/usr/pkg/share:" DATADIR ":/usr/share";
+#else
+		path = "/usr/local/share:" DATADIR ":/usr/share";
+#endif
+		datadir = 0;
+	}
+	if((p = strdup(path)) == NULL)
+		menu->helper->error(NULL, "strdup", 1);
+	else
+		for(i = 0, j = 0;; i++)
+			if(p[i] == '\0')
+			{
+				string_rtrim(&p[j], "/");
+				_xdg_dirs_path(menu, callback, &p[j]);
+				datadir |= (strcmp(&p[j], DATADIR) == 0);
+				break;
+			}
+			else if(p[i] == ':')
+			{
+				p[i] = '\0';
+				string_rtrim(&p[j], "/");
+				_xdg_dirs_path(menu, callback, &p[j]);
+				datadir |= (strcmp(&p[j], DATADIR) == 0);
+				j = i + 1;
+			}
+	free(p);
+	if(datadir == 0)
+		_xdg_dirs_path(menu, callback, DATADIR);
+	_xdg_dirs_home(menu, callback);
+}
+
+static void _xdg_dirs_home(Menu * menu, void (*callback)(Menu * menu,
+			char const * path, char const * apppath))
+{
+	char const fallback[] = ".local/share";
+	char const * path;
+	char const * homedir;
+	String * p;
+
+	/* use $XDG_DATA_HOME if set and not empty */
+	if((path = getenv("XDG_DATA_HOME")) != NULL && strlen(path) > 0)
+	{
+		_xdg_dirs_path(menu, callback, path);
+		return;
+	}
+	/* fallback to "$HOME/.local/share" */
+	if((homedir = getenv("HOME")) == NULL)
+		homedir = g_get_home_dir();
+	if((p = string_new_append(homedir, "/", fallback, NULL)) == NULL)
+	{
+		menu->helper->error(NULL, homedir, 1);
+		return;
+	}
+	_xdg_dirs_path(menu, callback, p);
+	string_delete(p);
+}
+
+static void _xdg_dirs_path(Menu * menu, void (*callback)(Menu * menu,
+			char const * path, char const * apppath),
+		char const * path)
+{
+	const char applications[] = "/applications";
+	char * apppath;
+
+	if((apppath = string_new_append(path, applications, NULL)) == NULL)
+		menu->helper->error(NULL, path, 1);
+	callback(menu, path, apppath);
+	string_delete(apppath);
+}
+
+
+/* callbacks */
+/* menu_on_about */
+static void _menu_on_about(gpointer data)
+{
+	Menu * menu = data;
+
+	menu->helper->about_dialog(menu->helper->panel);
+}
+
+
+/* menu_on_build */
+static gboolean _menu_on_build(gpointer data)
+{
+	Menu * menu = data;
+
+	menu->build = 0;
+	/* only once the entries are settled */
+	if(menu->apps == NULL || menu->load != NULL || menu->source != 0)
+		return FALSE;
+	_menu_applications(menu);
+	return FALSE;
+}
+
+
+/* menu_on_changed */
+static void _menu_on_changed(GFileMonitor * monitor, GFile * file,
+		GFile * other, GFileMonitorEvent event, gpointer data)
+{
+	MenuDir * dir = data;
+	gchar * filename;
+	(void) monitor;
+	(void) other;
+
+	switch(event)
+	{
+		case G_FILE_MONITOR_EVENT_ATTRIBUTE_CHANGED:
+		case G_FILE_MONITOR_EVENT_PRE_UNMOUNT:
+		case G_FILE_MONITOR_EVENT_UNMOUNTED:
+			return;
+		default:
+			break;
+	}
+	if((filename = g_file_get_path(file)) != NULL)
+		_menu_change(dir->menu, dir, filename);
+}
+
+
+/* menu_on_clicked */
+static void _clicked_position_menu(GtkMenu * widget, gint * x, gint * y,
+		gboolean * push_in, gpointer data);
+
+static void _menu_on_clicked(gpointer data)
+{
+	Menu * menu = data;
+	PanelAppletHelper * helper = menu->helper;
+	GtkWidget * menushell;
+	GtkWidget * menuitem;
+	GtkWidget * applications = NULL;
+	char const * p;
+
+	/* the applications are kept for the next time */
+	if(menu->menushell != NULL)
+	{
+		if(menu->applications != NULL && gtk_menu_get_attach_widget(
+					GTK_MENU(menu->applications)) != NULL)
+			gtk_menu_detach(GTK_MENU(menu->applications));
+		gtk_widget_destroy(menu->menushell);
+	}
+	menushell = gtk_menu_new();
+	menu->menushell = menushell;
+	if((p = helper->config_get(helper->panel, "menu", "applications"))
+			== NULL || strtol(p, NULL, 0) != 0)
+	{
+		applications = _menu_menuitem_stock("gnome-applications",
+				_("A_pplications"), TRUE);
+		gtk_menu_shell_append(GTK_MENU_SHELL(menushell), applications);
 		menuitem = gtk_separator_menu_item_new();
 		gtk_menu_shell_append(GTK_MENU_SHELL(menushell), menuitem);
 	}
@@ -601,6 +1495,10 @@ static void _menu_on_clicked(gpointer data)
 		gtk_menu_shell_append(GTK_MENU_SHELL(menushell), menuitem);
 	}
 	gtk_widget_show_all(menushell);
+	/* attached once shown, as the categories are populated when shown */
+	if(applications != NULL)
+		gtk_menu_item_set_submenu(GTK_MENU_ITEM(applications),
+				_menu_applications(menu));
 	gtk_menu_popup(GTK_MENU(menushell), NULL, NULL, _clicked_position_menu,
 			menu, 0, gtk_get_current_event_time());
 }
@@ -619,112 +1517,37 @@ static void _clicked_position_menu(GtkMenu * widget, gint * x, gint * y,
 
 
 /* menu_on_idle */
-static gint _idle_apps_compare(gconstpointer a, gconstpointer b);
-static void _idle_path(Menu * menu, char const * path, char const * apppath);
-
-static gboolean _menu_on_idle(gpointer data)
-{
-	const int timeout = 10000;
-	Menu * menu = data;
-
-	if(menu->apps != NULL)
-	{
-		menu->idle = 0;
-		return FALSE;
-	}
-	_menu_xdg_dirs(menu, _idle_path);
-	menu->idle = g_timeout_add(timeout, _menu_on_timeout, menu);
-	return FALSE;
-}
-
-static gint _idle_apps_compare(gconstpointer a, gconstpointer b)
-{
-	MenuApp * maa = (MenuApp *)a;
-	MenuApp * mab = (MenuApp *)b;
-	MimeHandler * mha = maa->handler;
-	MimeHandler * mhb = mab->handler;
-	String const * mhas;
-	String const * mhbs;
-
-	if((mhas = mimehandler_get_generic_name(mha, 1)) == NULL)
-		mhas = mimehandler_get_name(mha, 1);
-	if((mhbs = mimehandler_get_generic_name(mhb, 1)) == NULL)
-		mhbs = mimehandler_get_name(mhb, 1);
-	return string_compare(mhas, mhbs);
-}
-
-static void _idle_path(Menu * menu, char const * path, char const * apppath)
-{
-	DIR * dir;
-	int fd;
-	struct stat st;
-	struct dirent * de;
-	size_t len;
-	const char ext[] = ".desktop";
-	char * name = NULL;
-	char * p;
-	MimeHandler * handler;
-	MenuApp * menuapp;
-	(void) path;
-
-#if defined(__sun)
-	if((fd = open(apppath, O_RDONLY)) < 0
-			|| fstat(fd, &st) != 0
-			|| (dir = fdopendir(fd)) == NULL)
-#else
-	if((dir = opendir(apppath)) == NULL
-			|| (fd = dirfd(dir)) < 0
-			|| fstat(fd, &st) != 0)
-#endif
-	{
-		if(errno != ENOENT)
-			menu->helper->error(NULL, apppath, 1);
-		return;
-	}
-	if(st.st_mtime > menu->refresh_mti)
-		menu->refresh_mti = st.st_mtime;
-	while((de = readdir(dir)) != NULL)
-	{
-		if(de->d_name[0] == '.')
-			if(de->d_name[1] == '\0' || (de->d_name[1] == '.'
-						&& de->d_name[2] == '\0'))
-				continue;
-		len = strlen(de->d_name);
-		if(len < sizeof(ext))
-			continue;
-		if(strncmp(&de->d_name[len - sizeof(ext) + 1], ext,
-					sizeof(ext)) != 0)
-			continue;
-		if((p = realloc(name, strlen(apppath) + len + 2)) == NULL)
-		{
-			menu->helper->error(NULL, apppath, 1);
-			continue;
-		}
-		name = p;
-		snprintf(name, strlen(apppath) + len + 2, "%s/%s", apppath,
-				de->d_name);
-#ifdef DEBUG
-		fprintf(stderr, "DEBUG: %s() \"%s\"\n", __func__, name);
-#endif
-		if((handler = mimehandler_new_load(name)) == NULL)
-		{
-			menu->helper->error(NULL, error_get(NULL), 1);
-			continue;
-		}
-		/* skip this entry if cannot be displayed or opened */
-		if(mimehandler_can_display(handler) == 0
-				|| mimehandler_can_execute(handler) == 0
-				|| (menuapp = _menuapp_new(handler, path))
-				== NULL)
-		{
-			mimehandler_delete(handler);
-			continue;
-		}
-		menu->apps = g_slist_insert_sorted(menu->apps, menuapp,
-				_idle_apps_compare);
+static gboolean _menu_on_idle(gpointer data)
+{
+	const int timeout = 10000;
+	const int interval = 100;
+	Menu * menu = data;
+
+	menu->idle = 0;
+	if(menu->apps != NULL)
+		return FALSE;
+	/* load the entries in the background */
+	if(menu->load == NULL && _menu_load(menu) != 0)
+	{
+		menu->helper->error(NULL, error_get(NULL), 1);
+		menu->idle = g_timeout_add(timeout, _menu_on_idle, menu);
 	}
-	free(name);
-	closedir(dir);
+	else
+		menu->idle = g_timeout_add(interval, _menu_on_loading, menu);
+	return FALSE;
+}
+
+
+/* menu_on_loading */
+static gboolean _menu_on_loading(gpointer data)
+{
+	Menu * menu = data;
+
+	if(menu->load != NULL && g_atomic_int_get(&menu->load->pending) > 0)
+		return TRUE;
+	menu->idle = 0;
+	_menu_load_merge(menu);
+	return FALSE;
 }
 
 
@@ -746,6 +1569,113 @@ static void _menu_on_logout(gpointer data)
 }
 
 
+/* menu_on_refresh */
+static void _refresh_path(Menu * menu, MenuCache * cache, MenuDir * dir,
+		char const * filename);
+static gboolean _refresh_path_match(MenuApp * menuapp, char const * apppath,
+		char const * basename);
+
+static gboolean _menu_on_refresh(gpointer data)
+{
+	Menu * menu = data;
+	MenuCache * cache;
+	GHashTableIter iter;
+	gpointer key;
+	gpointer value;
+
+	/* the changes may have been missed while loading */
+	if(menu->load != NULL)
+		return TRUE;
+	menu->source = 0;
+	/* nothing to refresh if not loaded yet */
+	if(menu->apps == NULL)
+	{
+		g_hash_table_remove_all(menu->changes);
+		return FALSE;
+	}
+	_menu_invalidate(menu);
+	/* only the files changed are parsed again */
+	if((cache = _menucache_new()) == NULL)
+		menu->helper->error(NULL, error_get(NULL), 1);
+	else
+	{
+		g_hash_table_iter_init(&iter, menu->changes);
+		while(g_hash_table_iter_next(&iter, &key, &value))
+			_refresh_path(menu, cache, value, key);
+		_menucache_delete(cache);
+	}
+	g_hash_table_remove_all(menu->changes);
+	if(menu->apps_cnt > 1)
+		qsort(menu->apps, menu->apps_cnt, sizeof(*menu->apps),
+				_load_apps_compare);
+	return FALSE;
+}
+
+static void _refresh_path(Menu * menu, MenuCache * cache, MenuDir * dir,
+		char const * filename)
+{
+	size_t len = strlen(dir->apppath);
+	char const * basename = NULL;
+	size_t i;
+	size_t j;
+	MenuLoadDir ldir;
+	gint cancel = 0;
+	int fd;
+
+	/* either the directory itself, or one of its files */
+	if(strcmp(filename, dir->apppath) != 0)
+	{
+		if(strncmp(filename, dir->apppath, len) != 0
+				|| filename[len] != '/')
+			return;
+		basename = &filename[len + 1];
+	}
+#ifdef DEBUG
+	fprintf(stderr, "DEBUG: %s() \"%s\"\n", __func__, filename);
+#endif
+	/* forget about the applications affected */
+	for(i = 0, j = 0; i < menu->apps_cnt; i++)
+		if(_refresh_path_match(&menu->apps[i], dir->apppath, basename))
+			_menuapp_destroy(&menu->apps[i]);
+		else
+			menu->apps[j++] = menu->apps[i];
+	menu->apps_cnt = j;
+	/* then load them again, if still there */
+	if(_menuloaddir_init(&ldir, cache, dir->path, dir->apppath) != 0)
+	{
+		menu->helper->error(NULL, dir->apppath, 1);
+		return;
+	}
+	if(basename == NULL)
+		_load_dir(&ldir, &cancel);
+	else if(_load_dir_filter(basename)
+			&& (fd = open(dir->apppath, O_RDONLY)) >= 0)
+	{
+		_load_dir_entry(&ldir, fd, _menucache_lookup_dir(ldir.cache,
+					dir->apppath), basename);
+		close(fd);
+		_load_dir_apps(&ldir, 0);
+	}
+	_load_merge_apps(menu, &ldir);
+	_menuloaddir_destroy(&ldir);
+}
+
+static gboolean _refresh_path_match(MenuApp * menuapp, char const * apppath,
+		char const * basename)
+{
+	size_t len = strlen(apppath);
+	char const * p = menuapp->filename;
+
+	if(strncmp(p, apppath, len) != 0 || p[len] != '/')
+		return FALSE;
+	p += len + 1;
+	if(basename != NULL)
+		return (strcmp(p, basename) == 0) ? TRUE : FALSE;
+	/* every file of the directory */
+	return (strchr(p, '/') == NULL) ? TRUE : FALSE;
+}
+
+
 #ifdef EMBEDDED
 /* menu_on_rotate */
 static void _menu_on_rotate(gpointer data)
@@ -794,64 +1724,659 @@ static void _menu_on_suspend(gpointer data)
 
 
 /* menu_on_timeout */
-static void _timeout_path(Menu * menu, char const * path, char const * apppath);
-
 static gboolean _menu_on_timeout(gpointer data)
 {
 	Menu * menu = data;
+	MenuDir * dir;
+	struct stat st;
+	size_t i;
 
-	menu->refresh = FALSE;
-	_menu_xdg_dirs(menu, _timeout_path);
-	if(menu->refresh == FALSE)
-		return TRUE;
-#ifdef DEBUG
-	fprintf(stderr, "DEBUG: %s() resetting the menu\n", __func__);
-#endif
-	g_slist_foreach(menu->apps, (GFunc)_menuapp_delete, NULL);
-	g_slist_free(menu->apps);
-	menu->apps = NULL;
-	menu->idle = g_idle_add(_menu_on_idle, menu);
-	return FALSE;
+	/* only for the directories that cannot be monitored */
+	for(i = 0; i < menu->dirs_cnt; i++)
+	{
+		dir = &menu->dirs[i];
+		if(dir->monitor != NULL)
+			continue;
+		if(stat(dir->apppath, &st) != 0)
+			st.st_mtime = 0;
+		if(st.st_mtime == dir->mtime)
+			continue;
+		dir->mtime = st.st_mtime;
+		_menu_change(menu, dir, g_strdup(dir->apppath));
+	}
+	return TRUE;
+}
+
+
+/* MenuApp */
+/* menuapp_init */
+static int _init_category(char const * categories);
+
+static int _menuapp_init(MenuApp * menuapp, MenuCache * cache,
+		MenuCacheEntry const * entry, String const * path,
+		String const * apppath)
+{
+	menuapp->handler = NULL;
+	menuapp->filename = g_strconcat(apppath, "/",
+			_menucache_get_nstring(cache, entry->filename), NULL);
+	menuapp->path = g_strdup(path);
+	menuapp->name = g_strdup(_menucache_get_nstring(cache, entry->name));
+	menuapp->comment = g_strdup(_menucache_get_nstring(cache,
+				entry->comment));
+	menuapp->icon = g_strdup(_menucache_get_nstring(cache, entry->icon));
+	menuapp->category = _init_category(_menucache_get_nstring(cache,
+				entry->categories));
+	menuapp->key = NULL;
+	/* the name is set for every valid entry */
+	if(menuapp->name == NULL)
+	{
+		_menuapp_destroy(menuapp);
+		errno = EINVAL;
+		return -1;
+	}
+	menuapp->key = g_utf8_collate_key(menuapp->name, -1);
+	return 0;
+}
+
+static int _init_category(char const * categories)
+{
+	size_t i;
+	char const * category;
+	size_t len;
+	char const * p;
+
+	if(categories == NULL)
+		return -1;
+	/* the first category known wins, as listed in _menu_categories */
+	for(i = 0; i < MENU_MENUS_COUNT; i++)
+	{
+		category = _menu_categories[i].category;
+		len = strlen(category);
+		for(p = categories; (p = strstr(p, category)) != NULL; p += len)
+			if((p == categories || p[-1] == ';') && p[len] == ';')
+				return i;
+	}
+	return -1;
+}
+
+
+/* menuapp_destroy */
+static void _menuapp_destroy(MenuApp * menuapp)
+{
+	if(menuapp->handler != NULL)
+		mimehandler_delete(menuapp->handler);
+	g_free(menuapp->filename);
+	g_free(menuapp->path);
+	g_free(menuapp->name);
+	g_free(menuapp->comment);
+	g_free(menuapp->icon);
+	g_free(menuapp->key);
+}
+
+
+/* MenuCache */
+/* menucache_new */
+static String * _new_locale(void);
+static String * _new_path(void);
+static void _new_load(MenuCache * cache, char const * locale);
+
+static MenuCache * _menucache_new(void)
+{
+	MenuCache * cache;
+	String * locale;
+	uint32_t offset;
+
+	if((cache = object_new(sizeof(*cache))) == NULL)
+		return NULL;
+	cache->map = NULL;
+	cache->map_size = 0;
+	cache->header = NULL;
+	cache->dirs = NULL;
+	cache->entries = NULL;
+	cache->strings = NULL;
+	cache->ndirs = NULL;
+	cache->ndirs_cnt = 0;
+	cache->nentries = NULL;
+	cache->nentries_cnt = 0;
+	cache->nstrings = NULL;
+	cache->nstrings_size = 0;
+	cache->changed = FALSE;
+	/* the first string is empty, for the offsets meaning none */
+	if((locale = _new_locale()) == NULL)
+	{
+		_menucache_delete(cache);
+		return NULL;
+	}
+	if(_menucache_add_string(cache, "", &offset) != 0
+			|| _menucache_add_string(cache, locale, &offset) != 0)
+	{
+		error_set_code(1, "%s", strerror(errno));
+		string_delete(locale);
+		_menucache_delete(cache);
+		return NULL;
+	}
+	/* a missing or invalid cache is simply rebuilt */
+	_new_load(cache, locale);
+	if(cache->header == NULL)
+		cache->changed = TRUE;
+	string_delete(locale);
+	return cache;
+}
+
+static String * _new_locale(void)
+{
+	char const * const * names;
+	String * ret;
+	String * p;
+	size_t i;
+
+	/* the names and comments are localized */
+	names = g_get_language_names();
+	if((ret = string_new("")) == NULL)
+		return NULL;
+	for(i = 0; names[i] != NULL; i++)
+	{
+		if((p = string_new_append(ret, (i > 0) ? ":" : "", names[i],
+						NULL)) == NULL)
+		{
+			string_delete(ret);
+			return NULL;
+		}
+		string_delete(ret);
+		ret = p;
+	}
+	return ret;
 }
 
-static void _timeout_path(Menu * menu, char const * path, char const * apppath)
+static String * _new_path(void)
 {
+	return string_new_append(g_get_user_cache_dir(), "/DeforaOS/" VENDOR
+			"/" PACKAGE "/" MENU_CACHE_FILE, NULL);
+}
+
+static void _new_load(MenuCache * cache, char const * locale)
+{
+	String * path;
+	int fd;
 	struct stat st;
-	(void) path;
+	void * map;
+	MenuCacheHeader const * header;
+	uint64_t size;
+	char const * strings;
+	MenuCacheDir const * dirs;
+	uint32_t i;
+
+	if((path = _new_path()) == NULL)
+		return;
+	fd = open(path, O_RDONLY);
+	string_delete(path);
+	if(fd < 0)
+		return;
+	if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(*header)
+			|| (map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED,
+					fd, 0)) == MAP_FAILED)
+	{
+		close(fd);
+		return;
+	}
+	close(fd);
+	header = map;
+	size = sizeof(*header) + (uint64_t)header->dirs_cnt * sizeof(*dirs)
+		+ (uint64_t)header->entries_cnt * sizeof(MenuCacheEntry)
+		+ header->strings_size;
+	if(header->magic != MENU_CACHE_MAGIC
+			|| header->version != MENU_CACHE_VERSION
+			|| size != (uint64_t)st.st_size
+			|| header->strings_size == 0)
+	{
+		munmap(map, st.st_size);
+		return;
+	}
+	dirs = (MenuCacheDir const *)(header + 1);
+	strings = (char const *)map + size - header->strings_size;
+	/* the strings must be terminated, and the locale the same */
+	if(strings[header->strings_size - 1] != '\0'
+			|| header->locale >= header->strings_size
+			|| strcmp(&strings[header->locale], locale) != 0)
+	{
+		munmap(map, st.st_size);
+		return;
+	}
+	for(i = 0; i < header->dirs_cnt; i++)
+		if((uint64_t)dirs[i].first + dirs[i].cnt > header->entries_cnt)
+		{
+			munmap(map, st.st_size);
+			return;
+		}
+	cache->map = map;
+	cache->map_size = st.st_size;
+	cache->header = header;
+	cache->dirs = dirs;
+	cache->entries = (MenuCacheEntry const *)&dirs[header->dirs_cnt];
+	cache->strings = strings;
+}
+
+
+
+/* menucache_new_dir */
+static MenuCache * _menucache_new_dir(MenuCache * cache)
+{
+	MenuCache * dir;
+	uint32_t offset;
+
+	if((dir = object_new(sizeof(*dir))) == NULL)
+		return NULL;
+	/* the map is shared with the cache, and only read */
+	dir->map = NULL;
+	dir->map_size = 0;
+	dir->header = cache->header;
+	dir->dirs = cache->dirs;
+	dir->entries = cache->entries;
+	dir->strings = cache->strings;
+	dir->ndirs = NULL;
+	dir->ndirs_cnt = 0;
+	dir->nentries = NULL;
+	dir->nentries_cnt = 0;
+	dir->nstrings = NULL;
+	dir->nstrings_size = 0;
+	dir->changed = FALSE;
+	if(_menucache_add_string(dir, "", &offset) != 0)
+	{
+		error_set_code(1, "%s", strerror(errno));
+		_menucache_delete(dir);
+		return NULL;
+	}
+	return dir;
+}
 
-	if(menu->refresh != TRUE
-			&& stat(apppath, &st) == 0
-			&& st.st_mtime > menu->refresh_mti)
-		menu->refresh = TRUE;
+
+/* menucache_delete */
+static void _menucache_delete(MenuCache * cache)
+{
+	if(cache->map != NULL)
+		munmap(cache->map, cache->map_size);
+	free(cache->ndirs);
+	free(cache->nentries);
+	free(cache->nstrings);
+	object_delete(cache);
 }
 
 
-/* MenuApp */
-/* menuapp_new */
-static MenuApp * _menuapp_new(MimeHandler * handler, String const * path)
+/* accessors */
+/* menucache_get_string */
+static char const * _menucache_get_string(MenuCache * cache, uint32_t offset)
 {
-	MenuApp * menuapp;
+	if(cache->header == NULL || offset == 0
+			|| offset >= cache->header->strings_size)
+		return NULL;
+	return &cache->strings[offset];
+}
 
-	if((menuapp = object_new(sizeof(*menuapp))) == NULL)
+
+/* menucache_get_nstring */
+static char const * _menucache_get_nstring(MenuCache * cache,
+		uint32_t offset)
+{
+	if(offset == 0 || offset >= cache->nstrings_size)
 		return NULL;
-	menuapp->handler = NULL;
-	if(path == NULL)
-		menuapp->path = NULL;
-	else if((menuapp->path = string_new(path)) == NULL)
+	return &cache->nstrings[offset];
+}
+
+
+/* useful */
+/* menucache_add_dir */
+static int _menucache_add_dir(MenuCache * cache, char const * path,
+		struct stat const * st, size_t first)
+{
+	MenuCacheDir * p;
+	uint32_t offset;
+
+	if(_menucache_add_string(cache, path, &offset) != 0)
+		return -1;
+	if((p = realloc(cache->ndirs, sizeof(*p) * (cache->ndirs_cnt + 1)))
+			== NULL)
+		return -1;
+	cache->ndirs = p;
+	p = &cache->ndirs[cache->ndirs_cnt++];
+	memset(p, 0, sizeof(*p));
+	p->mtime = st->st_mtime;
+	p->mtime_nsec = MENU_MTIME_NSEC(st);
+	p->path = offset;
+	p->first = first;
+	p->cnt = cache->nentries_cnt - first;
+	return 0;
+}
+
+
+/* menucache_add_entry */
+static int _menucache_add_entry(MenuCache * cache, char const * filename,
+		struct stat const * st, unsigned int flags, char const * name,
+		char const * comment, char const * icon,
+		char const * categories)
+{
+	MenuCacheEntry entry;
+	MenuCacheEntry * p;
+
+	memset(&entry, 0, sizeof(entry));
+	entry.mtime = st->st_mtime;
+	entry.mtime_nsec = MENU_MTIME_NSEC(st);
+	entry.size = st->st_size;
+	entry.flags = flags;
+	if(_menucache_add_string(cache, filename, &entry.filename) != 0
+			|| _menucache_add_string(cache, name, &entry.name) != 0
+			|| _menucache_add_string(cache, comment,
+				&entry.comment) != 0
+			|| _menucache_add_string(cache, icon, &entry.icon) != 0
+			|| _menucache_add_string(cache, categories,
+				&entry.categories) != 0)
+		return -1;
+	if((p = realloc(cache->nentries, sizeof(*p)
+					* (cache->nentries_cnt + 1))) == NULL)
+		return -1;
+	cache->nentries = p;
+	cache->nentries[cache->nentries_cnt++] = entry;
+	return 0;
+}
+
+
+/* menucache_add_string */
+static int _menucache_add_string(MenuCache * cache, char const * s,
+		uint32_t * offset)
+{
+	size_t len;
+	char * p;
+
+	if(s == NULL)
 	{
-		_menuapp_delete(menuapp);
+		*offset = 0;
+		return 0;
+	}
+	len = strlen(s) + 1;
+	if(cache->nstrings_size + len > UINT32_MAX)
+	{
+		errno = ERANGE;
+		return -1;
+	}
+	if((p = realloc(cache->nstrings, cache->nstrings_size + len)) == NULL)
+		return -1;
+	cache->nstrings = p;
+	memcpy(&p[cache->nstrings_size], s, len);
+	*offset = cache->nstrings_size;
+	cache->nstrings_size += len;
+	return 0;
+}
+
+
+/* menucache_copy_entry */
+static int _menucache_copy_entry(MenuCache * cache,
+		MenuCacheEntry const * entry)
+{
+	struct stat st;
+
+	memset(&st, 0, sizeof(st));
+	st.st_mtime = entry->mtime;
+	MENU_MTIME_NSEC(&st) = entry->mtime_nsec;
+	st.st_size = entry->size;
+	return _menucache_add_entry(cache,
+			_menucache_get_string(cache, entry->filename), &st,
+			entry->flags,
+			_menucache_get_string(cache, entry->name),
+			_menucache_get_string(cache, entry->comment),
+			_menucache_get_string(cache, entry->icon),
+			_menucache_get_string(cache, entry->categories));
+}
+
+
+/* menucache_lookup_dir */
+static MenuCacheDir const * _menucache_lookup_dir(MenuCache * cache,
+		char const * path)
+{
+	uint32_t i;
+	char const * p;
+
+	if(cache->header == NULL)
 		return NULL;
+	for(i = 0; i < cache->header->dirs_cnt; i++)
+		if((p = _menucache_get_string(cache, cache->dirs[i].path))
+				!= NULL && strcmp(p, path) == 0)
+			return &cache->dirs[i];
+	return NULL;
+}
+
+
+/* menucache_lookup_entry */
+static MenuCacheEntry const * _menucache_lookup_entry(MenuCache * cache,
+		MenuCacheDir const * dir, char const * filename)
+{
+	MenuCacheEntry const * entries = &cache->entries[dir->first];
+	size_t min = 0;
+	size_t max = dir->cnt;
+	size_t i;
+	char const * p;
+	int res;
+
+	/* the entries of every directory are sorted by filename */
+	while(min < max)
+	{
+		i = min + (max - min) / 2;
+		if((p = _menucache_get_string(cache, entries[i].filename))
+				== NULL)
+			return NULL;
+		if((res = strcmp(filename, p)) == 0)
+			return &entries[i];
+		else if(res < 0)
+			max = i;
+		else
+			min = i + 1;
 	}
-	menuapp->handler = handler;
-	return menuapp;
+	return NULL;
 }
 
 
-/* menuapp_delete */
-static void _menuapp_delete(MenuApp * menuapp)
+/* menucache_merge */
+static uint32_t _merge_offset(uint32_t offset, size_t base);
+
+static int _menucache_merge(MenuCache * cache, MenuCache * dir)
 {
-	if(menuapp->handler != NULL)
-		mimehandler_delete(menuapp->handler);
-	string_delete(menuapp->path);
-	object_delete(menuapp);
+	size_t base = cache->nstrings_size - 1;
+	size_t first = cache->nentries_cnt;
+	char * s;
+	MenuCacheDir * d;
+	MenuCacheEntry * e;
+	size_t i;
+
+	/* the first string of the directory is not copied */
+	if(base + dir->nstrings_size > UINT32_MAX)
+	{
+		errno = ERANGE;
+		return -error_set_code(1, "%s", strerror(errno));
+	}
+	if((s = realloc(cache->nstrings, base + dir->nstrings_size)) == NULL)
+		return -error_set_code(1, "%s", strerror(errno));
+	cache->nstrings = s;
+	if((d = realloc(cache->ndirs, sizeof(*d) * (cache->ndirs_cnt
+						+ dir->ndirs_cnt))) == NULL)
+		return -error_set_code(1, "%s", strerror(errno));
+	cache->ndirs = d;
+	if((e = realloc(cache->nentries, sizeof(*e) * (cache->nentries_cnt
+						+ dir->nentries_cnt))) == NULL)
+		return -error_set_code(1, "%s", strerror(errno));
+	cache->nentries = e;
+	memcpy(&s[cache->nstrings_size], &dir->nstrings[1],
+			dir->nstrings_size - 1);
+	cache->nstrings_size += dir->nstrings_size - 1;
+	for(i = 0; i < dir->ndirs_cnt; i++)
+	{
+		d = &cache->ndirs[cache->ndirs_cnt++];
+		*d = dir->ndirs[i];
+		d->path = _merge_offset(d->path, base);
+		d->first += first;
+	}
+	for(i = 0; i < dir->nentries_cnt; i++)
+	{
+		e = &cache->nentries[cache->nentries_cnt++];
+		*e = dir->nentries[i];
+		e->filename = _merge_offset(e->filename, base);
+		e->name = _merge_offset(e->name, base);
+		e->comment = _merge_offset(e->comment, base);
+		e->icon = _merge_offset(e->icon, base);
+		e->categories = _merge_offset(e->categories, base);
+	}
+	if(dir->changed)
+		cache->changed = TRUE;
+	return 0;
+}
+
+static uint32_t _merge_offset(uint32_t offset, size_t base)
+{
+	return (offset != 0) ? offset + base : 0;
+}
+
+
+/* menucache_save */
+static int _save_write(int fd, void const * buf, size_t size);
+
+static int _menucache_save(MenuCache * cache)
+{
+	MenuCacheHeader header;
+	String * path;
+	gchar * dir;
+	String * tmp;
+	int fd;
+
+	if(cache->changed != TRUE)
+		return 0;
+	memset(&header, 0, sizeof(header));
+	header.magic = MENU_CACHE_MAGIC;
+	header.version = MENU_CACHE_VERSION;
+	header.dirs_cnt = cache->ndirs_cnt;
+	header.entries_cnt = cache->nentries_cnt;
+	header.strings_size = cache->nstrings_size;
+	header.locale = 1;
+	if((path = _new_path()) == NULL)
+		return -1;
+	dir = g_path_get_dirname(path);
+	if(g_mkdir_with_parents(dir, 0700) != 0)
+	{
+		error_set_code(1, "%s: %s", dir, strerror(errno));
+		g_free(dir);
+		string_delete(path);
+		return -1;
+	}
+	g_free(dir);
+	/* replace the cache atomically */
+	if((tmp = string_new_append(path, ".XXXXXX", NULL)) == NULL
+			|| (fd = mkstemp(tmp)) < 0)
+	{
+		error_set_code(1, "%s: %s", path, strerror(errno));
+		string_delete(tmp);
+		string_delete(path);
+		return -1;
+	}
+	if(_save_write(fd, &header, sizeof(header)) != 0
+			|| _save_write(fd, cache->ndirs, sizeof(*cache->ndirs)
+				* cache->ndirs_cnt) != 0
+			|| _save_write(fd, cache->nentries,
+				sizeof(*cache->nentries)
+				* cache->nentries_cnt) != 0
+			|| _save_write(fd, cache->nstrings,
+				cache->nstrings_size) != 0)
+	{
+		error_set_code(1, "%s: %s", path, strerror(errno));
+		close(fd);
+		unlink(tmp);
+		string_delete(tmp);
+		string_delete(path);
+		return -1;
+	}
+	if(close(fd) != 0 || rename(tmp, path) != 0)
+	{
+		error_set_code(1, "%s: %s", path, strerror(errno));
+		unlink(tmp);
+		string_delete(tmp);
+		string_delete(path);
+		return -1;
+	}
+	string_delete(tmp);
+	string_delete(path);
+	return 0;
+}
+
+static int _save_write(int fd, void const * buf, size_t size)
+{
+	char const * p = buf;
+	ssize_t res;
+
+	while(size > 0)
+		if((res = write(fd, p, size)) < 0)
+		{
+			if(errno != EINTR)
+				return -1;
+		}
+		else
+		{
+			p += res;
+			size -= res;
+		}
+	return 0;
+}
+
+
+/* MenuLoad */
+/* menuload_delete */
+static void _menuload_delete(MenuLoad * load)
+{
+	size_t i;
+
+	/* cancel the directories still being loaded */
+	if(load->pool != NULL)
+	{
+		g_atomic_int_set(&load->cancel, 1);
+		g_thread_pool_free(load->pool, TRUE, TRUE);
+	}
+	for(i = 0; i < load->dirs_cnt; i++)
+		_menuloaddir_destroy(&load->dirs[i]);
+	free(load->dirs);
+	if(load->cache != NULL)
+		_menucache_delete(load->cache);
+	object_delete(load);
+}
+
+
+/* MenuLoadDir */
+/* menuloaddir_init */
+static int _menuloaddir_init(MenuLoadDir * dir, MenuCache * cache,
+		String const * path, String const * apppath)
+{
+	dir->path = string_new(path);
+	dir->apppath = string_new(apppath);
+	dir->cache = _menucache_new_dir(cache);
+	dir->apps = NULL;
+	dir->apps_cnt = 0;
+	dir->errors = NULL;
+	dir->errors_cnt = 0;
+	if(dir->path == NULL || dir->apppath == NULL || dir->cache == NULL)
+	{
+		_menuloaddir_destroy(dir);
+		return -1;
+	}
+	return 0;
+}
+
+
+/* menuloaddir_destroy */
+static void _menuloaddir_destroy(MenuLoadDir * dir)
+{
+	size_t i;
+
+	string_delete(dir->path);
+	string_delete(dir->apppath);
+	if(dir->cache != NULL)
+		_menucache_delete(dir->cache);
+	for(i = 0; i < dir->apps_cnt; i++)
+		_menuapp_destroy(&dir->apps[i]);
+	free(dir->apps);
+	for(i = 0; i < dir->errors_cnt; i++)
+		g_free(dir->errors[i].path);
+	free(dir->errors);
 }
@@ -131,7 +131,8 @@ static Network * _network_init(PanelAppletHelper * helper, GtkWidget ** widget)
 	network->iconsize = panel_window_get_icon_size(helper->window);
 	network->pr_box = NULL;
 	gtk_widget_show(network->widget);
-	network->source = g_timeout_add(timeout, _network_on_timeout, network);
+	network->source = helper->timeout_add(helper->panel, timeout,
+			_network_on_timeout, network);
 	if((network->fd = socket(AF_INET, SOCK_DGRAM, 0)) < 0)
 	{
 		error_set("%s: %s: %s", applet.name, "socket", strerror(errno));
@@ -156,7 +157,8 @@ static void _network_destroy(Network * network)
 	if(network->fd >= 0)
 		close(network->fd);
 	if(network->source != 0)
-		g_source_remove(network->source);
+		network->helper->timeout_remove(network->helper->panel,
+				network->source);
 	gtk_widget_destroy(network->widget);
 	object_delete(network);
 }
@@ -485,12 +487,10 @@ static void _settings_reset(Network * network, PanelAppletHelper * helper)
 /* network_on_timeout */
 static gboolean _network_on_timeout(gpointer data)
 {
-	const unsigned int timeout = 500;
 	Network * network = data;
 
 	_network_refresh(network);
-	network->source = g_timeout_add(timeout, _network_on_timeout, network);
-	return FALSE;
+	return TRUE;
 }
 
 
@@ -1,5 +1,5 @@
 /* $Id$ */
-/* Copyright (c) 2010-2024 Pierre Pronchery <khorben@defora.org> */
+/* Copyright (c) 2010-2026 Pierre Pronchery <khorben@defora.org> */
 /* This file is part of DeforaOS Pager Panel */
 /* This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -22,11 +22,13 @@
 #include <gdk/gdk.h>
 #ifdef GDK_WINDOWING_X11
 # include <gdk/gdkx.h>
-# include <X11/Xatom.h>
 #endif
 #include <System.h>
 #include <Desktop.h>
 #include "Panel/applet.h"
+#if defined(GDK_WINDOWING_X11)
+# include "Panel/clients.h"
+#endif
 #define _(string) gettext(string)
 #define N_(string) string
 
@@ -38,16 +40,6 @@
 /* Pager */
 /* private */
 /* types */
-typedef enum _PagerAtom
-{
-	PAGER_ATOM_NET_CURRENT_DESKTOP = 0,
-	PAGER_ATOM_NET_DESKTOP_NAMES,
-	PAGER_ATOM_NET_NUMBER_OF_DESKTOPS,
-	PAGER_ATOM_UTF8_STRING
-} PagerAtom;
-#define PAGER_ATOM_LAST PAGER_ATOM_UTF8_STRING
-#define PAGER_ATOM_COUNT (PAGER_ATOM_LAST + 1)
-
 typedef struct _PanelApplet
 {
 	PanelAppletHelper * helper;
@@ -59,46 +51,27 @@ typedef struct _PanelApplet
 	GtkWidget ** widgets;
 	size_t widgets_cnt;
 
-	Atom atoms[PAGER_ATOM_COUNT];
-	GdkDisplay * display;
-	GdkScreen * screen;
-	GdkWindow * root;
+	PanelClients * clients;
+	gboolean subscribed;
 #endif
 } Pager;
 
 
-/* constants */
-#if defined(GDK_WINDOWING_X11)
-static const char * _pager_atom[PAGER_ATOM_COUNT] =
-{
-	"_NET_CURRENT_DESKTOP",
-	"_NET_DESKTOP_NAMES",
-	"_NET_NUMBER_OF_DESKTOPS",
-	"UTF8_STRING"
-};
-#endif
-
-
 /* prototypes */
 static Pager * _pager_init(PanelAppletHelper * helper, GtkWidget ** widget);
 static void _pager_destroy(Pager * pager);
+static void _pager_resume(Pager * pager);
+static void _pager_suspend(Pager * pager);
 
 #if defined(GDK_WINDOWING_X11)
-/* accessors */
-static int _pager_get_current_desktop(Pager * pager);
-static char ** _pager_get_desktop_names(Pager * pager);
-static int _pager_get_window_property(Pager * pager, Window window,
-		PagerAtom property, Atom atom, unsigned long * cnt,
-		unsigned char ** ret);
-
 /* useful */
 static void _pager_do(Pager * pager);
-static void _pager_refresh(Pager * pager);
+static void _pager_refresh(Pager * pager, int cur);
 
 /* callbacks */
 static void _pager_on_clicked(GtkWidget * widget, gpointer data);
-static GdkFilterReturn _pager_on_filter(GdkXEvent * xevent, GdkEvent * event,
-		gpointer data);
+static void _pager_on_clients(void * data, PanelClientsEvent event,
+		Window window, PanelClientsAtom property);
 static void _pager_on_screen_changed(GtkWidget * widget, GdkScreen * previous,
 		gpointer data);
 #endif
@@ -115,7 +88,9 @@ PanelAppletDefinition applet =
 	_pager_destroy,
 	NULL,
 	FALSE,
-	TRUE
+	TRUE,
+	_pager_suspend,
+	_pager_resume
 };
 
 
@@ -146,9 +121,8 @@ static Pager * _pager_init(PanelAppletHelper * helper, GtkWidget ** widget)
 			G_CALLBACK(_pager_on_screen_changed), pager);
 	pager->widgets = NULL;
 	pager->widgets_cnt = 0;
-	pager->display = NULL;
-	pager->screen = NULL;
-	pager->root = NULL;
+	pager->clients = NULL;
+	pager->subscribed = FALSE;
 	*widget = pager->box;
 	return pager;
 #else
@@ -168,8 +142,11 @@ static void _pager_destroy(Pager * pager)
 	if(pager->source != 0)
 		g_signal_handler_disconnect(pager->box, pager->source);
 	pager->source = 0;
-	if(pager->root != NULL)
-		gdk_window_remove_filter(pager->root, _pager_on_filter, pager);
+	if(pager->clients != NULL)
+	{
+		_pager_suspend(pager);
+		panel_clients_release(pager->clients);
+	}
 	gtk_widget_destroy(pager->box);
 	free(pager);
 #else
@@ -178,130 +155,65 @@ static void _pager_destroy(Pager * pager)
 }
 
 
-#if defined(GDK_WINDOWING_X11)
-/* accessors */
-/* pager_get_current_desktop */
-static int _pager_get_current_desktop(Pager * pager)
+/* pager_resume */
+static void _pager_resume(Pager * pager)
 {
-	unsigned long cnt;
-	unsigned long * p;
-
-	if(_pager_get_window_property(pager, GDK_WINDOW_XID(pager->root),
-				PAGER_ATOM_NET_CURRENT_DESKTOP, XA_CARDINAL,
-				&cnt, (void*)&p) != 0)
-		return -1;
-	cnt = *p;
-	XFree(p);
-	return cnt;
-}
-
-
-/* pager_get_desktop_names */
-static char ** _pager_get_desktop_names(Pager * pager)
-{
-	char ** ret = NULL;
-	size_t ret_cnt = 0;
-	unsigned long cnt;
-	char * p;
-	unsigned long i;
-	unsigned long last = 0;
-	char ** q;
-
-	if(_pager_get_window_property(pager, GDK_WINDOW_XID(pager->root),
-				PAGER_ATOM_NET_DESKTOP_NAMES,
-				pager->atoms[PAGER_ATOM_UTF8_STRING], &cnt,
-				(void*)&p) != 0)
-		return NULL;
-	for(i = 0; i < cnt; i++)
-	{
-		if(p[i] != '\0')
-			continue;
-		if((q = realloc(ret, (ret_cnt + 2) * (sizeof(*q)))) == NULL)
-		{
-			free(ret);
-			XFree(p);
-			return NULL;
-		}
-		ret = q;
-		/* FIXME validate the UTF8 string */
-		ret[ret_cnt++] = g_strdup(&p[last]);
-		last = i + 1;
-	}
-	XFree(p);
-	if(ret == NULL)
-		return ret;
-	ret[ret_cnt] = NULL;
-	return ret;
+#if defined(GDK_WINDOWING_X11)
+	if(pager->clients == NULL || pager->subscribed)
+		return;
+	/* track the changes again, and catch up with them */
+	if(panel_clients_subscribe(pager->clients, pager->helper->window,
+				_pager_on_clients, pager) != 0)
+		return;
+	pager->subscribed = TRUE;
+	_pager_do(pager);
+#else
+	(void) pager;
+#endif
 }
 
 
-/* pager_get_window_property */
-static int _pager_get_window_property(Pager * pager, Window window,
-		PagerAtom property, Atom atom, unsigned long * cnt,
-		unsigned char ** ret)
+/* pager_suspend */
+static void _pager_suspend(Pager * pager)
 {
-	int res;
-	Atom type;
-	int format;
-	unsigned long bytes;
-
-# ifdef DEBUG
-	fprintf(stderr, "DEBUG: %s(pager, window, %s, %lu)\n", __func__,
-			_pager_atom[property], atom);
-# endif
-	gdk_error_trap_push();
-	res = XGetWindowProperty(GDK_DISPLAY_XDISPLAY(pager->display), window,
-			pager->atoms[property], 0, G_MAXLONG, False, atom,
-			&type, &format, cnt, &bytes, ret);
-	if(gdk_error_trap_pop() != 0 || res != Success)
-		return -1;
-	if(type != atom)
-	{
-		if(*ret != NULL)
-			XFree(*ret);
-		*ret = NULL;
-		return 1;
-	}
-	return 0;
+#if defined(GDK_WINDOWING_X11)
+	if(pager->clients != NULL && pager->subscribed)
+		panel_clients_unsubscribe(pager->clients, _pager_on_clients,
+				pager);
+	pager->subscribed = FALSE;
+#else
+	(void) pager;
+#endif
 }
 
 
+#if defined(GDK_WINDOWING_X11)
 /* useful */
 /* pager_do */
 static void _pager_do(Pager * pager)
 {
-	unsigned long cnt = 0;
 	unsigned long l;
-	unsigned long * p;
 	unsigned long i;
 	GtkWidget ** q;
-	char ** names;
+	char const * name;
 	char buf[64];
 
-	if(_pager_get_window_property(pager, GDK_WINDOW_XID(pager->root),
-				PAGER_ATOM_NET_NUMBER_OF_DESKTOPS,
-				XA_CARDINAL, &cnt, (void*)&p) != 0)
+	if((l = panel_clients_get_desktops(pager->clients)) == 0)
 		return;
-	l = *p;
 # ifdef DEBUG
 	fprintf(stderr, "DEBUG: %s() l=%ld\n", __func__, l);
 # endif
-	XFree(p);
 	for(i = l; i < pager->widgets_cnt; i++)
 		if(pager->widgets[i] != NULL)
 			gtk_widget_destroy(pager->widgets[i]);
-	if((q = realloc(pager->widgets, l * sizeof(*q))) == NULL
-			&& l != 0)
+	if((q = realloc(pager->widgets, l * sizeof(*q))) == NULL)
 		return;
 	pager->widgets = q;
-	names = _pager_get_desktop_names(pager);
 	for(i = 0; i < l; i++)
 	{
-		if(names != NULL && names[i] != NULL)
-		{
-			snprintf(buf, sizeof(buf), "%s", names[i]);
-			g_free(names[i]);
-		}
+		if((name = panel_clients_get_desktop_name(pager->clients, i))
+				!= NULL)
+			snprintf(buf, sizeof(buf), "%s", name);
 		else
 			snprintf(buf, sizeof(buf), _("Desk %lu"), i + 1);
 		if(i < pager->widgets_cnt)
@@ -316,9 +228,9 @@ static void _pager_do(Pager * pager)
 					pager->widgets[i], FALSE, TRUE, 0);
 		}
 	}
-	free(names);
 	pager->widgets_cnt = l;
-	_pager_refresh(pager);
+	_pager_refresh(pager, panel_clients_get_current_desktop(
+				pager->clients));
 	if(pager->widgets_cnt <= 1)
 		gtk_widget_hide(pager->box);
 	else
@@ -327,13 +239,11 @@ static void _pager_do(Pager * pager)
 
 
 /* pager_refresh */
-static void _pager_refresh(Pager * pager)
+static void _pager_refresh(Pager * pager, int cur)
 {
 	size_t i;
-	int cur;
 	char buf[64];
 
-	cur = _pager_get_current_desktop(pager);
 	for(i = 0; i < pager->widgets_cnt; i++)
 		if(cur < 0 || i != (unsigned int)cur)
 		{
@@ -364,9 +274,8 @@ static void _pager_on_clicked(GtkWidget * widget, gpointer data)
 {
 	Pager * pager = data;
 	size_t i;
-	GdkScreen * screen;
 	GdkDisplay * display;
-	GdkWindow * root;
+	Window root;
 	XEvent xev;
 
 	for(i = 0; i < pager->widgets_cnt; i++)
@@ -374,49 +283,39 @@ static void _pager_on_clicked(GtkWidget * widget, gpointer data)
 			break;
 	if(i == pager->widgets_cnt)
 		return;
-	screen = gtk_widget_get_screen(widget);
-	display = gtk_widget_get_display(widget);
-	root = gdk_screen_get_root_window(screen);
+	display = panel_clients_get_display(pager->clients);
+	root = panel_clients_get_root(pager->clients);
 	xev.xclient.type = ClientMessage;
-	xev.xclient.window = GDK_WINDOW_XID(root);
-	xev.xclient.message_type = gdk_x11_get_xatom_by_name_for_display(
-			display, "_NET_CURRENT_DESKTOP");
+	xev.xclient.window = root;
+	xev.xclient.message_type = panel_clients_get_atoms(pager->clients)[
+		PANEL_CLIENTS_ATOM__NET_CURRENT_DESKTOP];
 	xev.xclient.format = 32;
 	memset(&xev.xclient.data, 0, sizeof(xev.xclient.data));
 	xev.xclient.data.l[0] = i;
 	xev.xclient.data.l[1] = gdk_x11_display_get_user_time(display);
 	gdk_error_trap_push();
-	XSendEvent(GDK_DISPLAY_XDISPLAY(display), GDK_WINDOW_XID(root),
-			False,
+	XSendEvent(GDK_DISPLAY_XDISPLAY(display), root, False,
 			SubstructureNotifyMask | SubstructureRedirectMask,
 			&xev);
 	gdk_error_trap_pop_ignored();
 }
 
 
-/* pager_on_filter */
-static GdkFilterReturn _pager_on_filter(GdkXEvent * xevent, GdkEvent * event,
-		gpointer data)
+/* pager_on_clients */
+static void _pager_on_clients(void * data, PanelClientsEvent event,
+		Window window, PanelClientsAtom property)
 {
 	Pager * pager = data;
-	XEvent * xev = xevent;
-	int cur;
-	(void) event;
+	(void) window;
 
-	if(xev->type != PropertyNotify)
-		return GDK_FILTER_CONTINUE;
-	if(xev->xproperty.atom == pager->atoms[PAGER_ATOM_NET_CURRENT_DESKTOP])
-	{
-		if((cur = _pager_get_current_desktop(pager)) >= 0)
-			_pager_refresh(pager);
-		return GDK_FILTER_CONTINUE;
-	}
-	if(xev->xproperty.atom == pager->atoms[
-			PAGER_ATOM_NET_NUMBER_OF_DESKTOPS]
-			|| xev->xproperty.atom == pager->atoms[
-			PAGER_ATOM_NET_DESKTOP_NAMES])
+	if(event != PANEL_CLIENTS_EVENT_CHANGED)
+		return;
+	if(property == PANEL_CLIENTS_ATOM__NET_CURRENT_DESKTOP)
+		_pager_refresh(pager, panel_clients_get_current_desktop(
+					pager->clients));
+	else if(property == PANEL_CLIENTS_ATOM__NET_NUMBER_OF_DESKTOPS
+			|| property == PANEL_CLIENTS_ATOM__NET_DESKTOP_NAMES)
 		_pager_do(pager);
-	return GDK_FILTER_CONTINUE;
 }
 
 
@@ -425,22 +324,18 @@ static void _pager_on_screen_changed(GtkWidget * widget, GdkScreen * previous,
 		gpointer data)
 {
 	Pager * pager = data;
-	GdkEventMask events;
-	size_t i;
+	PanelClients * clients;
 	(void) previous;
 
-	if(pager->root != NULL)
-		gdk_window_remove_filter(pager->root, _pager_on_filter, pager);
-	pager->screen = gtk_widget_get_screen(widget);
-	pager->display = gdk_screen_get_display(pager->screen);
-	pager->root = gdk_screen_get_root_window(pager->screen);
-	events = gdk_window_get_events(pager->root);
-	gdk_window_set_events(pager->root, events | GDK_PROPERTY_CHANGE_MASK);
-	gdk_window_add_filter(pager->root, _pager_on_filter, pager);
-	/* atoms */
-	for(i = 0; i < PAGER_ATOM_COUNT; i++)
-		pager->atoms[i] = gdk_x11_get_xatom_by_name_for_display(
-				pager->display, _pager_atom[i]);
-	_pager_do(pager);
+	if((clients = panel_clients_acquire(gtk_widget_get_screen(widget)))
+			== NULL)
+		return;
+	if(pager->clients != NULL)
+	{
+		_pager_suspend(pager);
+		panel_clients_release(pager->clients);
+	}
+	pager->clients = clients;
+	_pager_resume(pager);
 }
 #endif
@@ -1,5 +1,5 @@
 /* $Id$ */
-/* Copyright (c) 2010-2022 Pierre Pronchery <khorben@defora.org> */
+/* Copyright (c) 2010-2026 Pierre Pronchery <khorben@defora.org> */
 /* This file is part of DeforaOS Desktop Panel */
 /* This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -54,6 +54,15 @@ typedef struct _PanelApplet
 } Swap;
 
 
+/* variables */
+/* the sample is shared by every instance */
+static struct
+{
+	gint64 time;
+	gdouble level;
+} _swap_sample;
+
+
 /* prototypes */
 static Swap * _swap_init(PanelAppletHelper * helper, GtkWidget ** widget);
 static void _swap_destroy(Swap * swap);
@@ -135,7 +144,8 @@ static Swap * _swap_init(PanelAppletHelper * helper, GtkWidget ** widget)
 #endif
 	gtk_box_pack_start(GTK_BOX(swap->widget), swap->scale, FALSE, FALSE, 0);
 	swap->timeout = (_swap_on_timeout(swap) == TRUE)
-		? g_timeout_add(timeout, _swap_on_timeout, swap) : 0;
+		? helper->timeout_add(helper->panel, timeout, _swap_on_timeout,
+				swap) : 0;
 	pango_font_description_free(desc);
 	gtk_widget_show_all(swap->widget);
 	*widget = swap->widget;
@@ -147,7 +157,8 @@ static Swap * _swap_init(PanelAppletHelper * helper, GtkWidget ** widget)
 static void _swap_destroy(Swap * swap)
 {
 	if(swap->timeout != 0)
-		g_source_remove(swap->timeout);
+		swap->helper->timeout_remove(swap->helper->panel,
+				swap->timeout);
 	gtk_widget_destroy(swap->widget);
 	free(swap);
 }
@@ -179,7 +190,15 @@ static gboolean _swap_on_timeout(gpointer data)
 	struct xsw_usage sw;
 	size_t size = sizeof(sw);
 	gdouble value;
+	gint64 now;
 
+	now = g_get_monotonic_time();
+	if(_swap_sample.time != 0 && now - _swap_sample.time
+			< PANEL_APPLET_SAMPLE_AGE * 1000)
+	{
+		_swap_set(swap, _swap_sample.level);
+		return TRUE;
+	}
 	if(sysctl(mib, 2, &sw, &size, NULL, 0) != 0)
 	{
 		error_set("%s: %s: %s", applet.name, "sysctl",
@@ -188,6 +207,8 @@ static gboolean _swap_on_timeout(gpointer data)
 	}
 	value = sw.xsu_used;
 	value /= sw.xsu_total;
+	_swap_sample.time = now;
+	_swap_sample.level = value;
 	_swap_set(swap, value);
 	return TRUE;
 #elif defined(__FreeBSD__)
@@ -195,22 +216,42 @@ static gboolean _swap_on_timeout(gpointer data)
 	struct vmtotal vm;
 	size_t size = sizeof(vm);
 	gdouble value;
+	gint64 now;
 
+	now = g_get_monotonic_time();
+	if(_swap_sample.time != 0 && now - _swap_sample.time
+			< PANEL_APPLET_SAMPLE_AGE * 1000)
+	{
+		_swap_set(swap, _swap_sample.level);
+		return TRUE;
+	}
 	if(sysctl(mib, 2, &vm, &size, NULL, 0) < 0)
 		return TRUE;
 	value = vm.t_avm;
 	value /= vm.t_vm;
+	_swap_sample.time = now;
+	_swap_sample.level = value;
 	_swap_set(swap, value);
 	return TRUE;
 #elif defined(__linux__)
 	struct sysinfo sy;
 	gdouble value;
+	gint64 now;
 
+	now = g_get_monotonic_time();
+	if(_swap_sample.time != 0 && now - _swap_sample.time
+			< PANEL_APPLET_SAMPLE_AGE * 1000)
+	{
+		_swap_set(swap, _swap_sample.level);
+		return TRUE;
+	}
 	if(sysinfo(&sy) != 0)
 		return swap->helper->error(swap->helper->panel, "sysinfo",
 				TRUE);
 	if((value = sy.totalswap - sy.freeswap) != 0.0 && sy.totalswap != 0)
 		value /= sy.totalswap;
+	_swap_sample.time = now;
+	_swap_sample.level = value;
 	_swap_set(swap, value);
 	return TRUE;
 #elif defined(__NetBSD__)
@@ -218,11 +259,21 @@ static gboolean _swap_on_timeout(gpointer data)
 	struct uvmexp ue;
 	size_t size = sizeof(ue);
 	gdouble value;
+	gint64 now;
 
+	now = g_get_monotonic_time();
+	if(_swap_sample.time != 0 && now - _swap_sample.time
+			< PANEL_APPLET_SAMPLE_AGE * 1000)
+	{
+		_swap_set(swap, _swap_sample.level);
+		return TRUE;
+	}
 	if(sysctl(mib, 2, &ue, &size, NULL, 0) < 0)
 		return TRUE;
 	if((value = ue.swpgonly) != 0.0 && ue.swpages != 0)
 		value /= ue.swpages;
+	_swap_sample.time = now;
+	_swap_sample.level = value;
 	_swap_set(swap, value);
 	return TRUE;
 #else
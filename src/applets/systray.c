@@ -1,5 +1,5 @@
 /* $Id$ */
-/* Copyright (c) 2010-2024 Pierre Pronchery <khorben@defora.org> */
+/* Copyright (c) 2010-2026 Pierre Pronchery <khorben@defora.org> */
 /* This file is part of DeforaOS Pager Panel */
 /* This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -134,7 +134,8 @@ static void _systray_destroy(Systray * systray)
 	if(systray->owner != NULL)
 	{
 		window = gtk_widget_get_window(systray->owner);
-		gdk_window_remove_filter(window, _systray_on_filter, systray);
+		panel_window_remove_filter(systray->helper->window, window,
+				_systray_on_filter, systray);
 		gtk_widget_destroy(systray->owner);
 	}
 	gtk_widget_destroy(systray->hbox);
@@ -200,7 +201,8 @@ static void _systray_on_owner_destroy(gpointer data)
 	if(systray->owner != NULL
 			&& (window = gtk_widget_get_window(systray->owner))
 			!= NULL)
-		gdk_window_remove_filter(window, _systray_on_filter, systray);
+		panel_window_remove_filter(systray->helper->window, window,
+				_systray_on_filter, systray);
 	systray->owner = NULL;
 }
 
@@ -250,6 +252,7 @@ static void _systray_on_screen_changed(GtkWidget * widget, GdkScreen * previous,
 	gdk_error_trap_pop();
 	gtk_widget_add_events(systray->owner, GDK_PROPERTY_CHANGE_MASK
 			| GDK_STRUCTURE_MASK);
-	gdk_window_add_filter(window, _systray_on_filter, systray);
+	panel_window_add_filter(systray->helper->window, window,
+			_systray_on_filter, systray);
 }
 #endif
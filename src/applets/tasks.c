@@ -1,5 +1,5 @@
 /* $Id$ */
-/* Copyright (c) 2011-2024 Pierre Pronchery <khorben@defora.org> */
+/* Copyright (c) 2011-2026 Pierre Pronchery <khorben@defora.org> */
 /* This file is part of DeforaOS Desktop Panel */
 /* This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -32,6 +32,11 @@
 #include <System.h>
 #include <Desktop.h>
 #include "Panel/applet.h"
+#if defined(GDK_WINDOWING_X11)
+# include "Panel/clients.h"
+# include "Panel/image.h"
+# include "Panel/properties.h"
+#endif
 
 #define _(string) gettext(string)
 #define N_(string) string
@@ -44,20 +49,30 @@
 /* Tasks */
 /* private */
 /* types */
+typedef struct _PanelApplet Tasks;
+
 #if defined(GDK_WINDOWING_X11)
-# define atom(a) TASKS_ATOM_ ## a
-typedef enum _TasksAtom
+typedef enum _TaskProperty
 {
-# include "tasks.atoms"
-} TasksAtom;
-# define TASKS_ATOM_LAST TASKS_ATOM_UTF8_STRING
-# define TASKS_ATOM_COUNT (TASKS_ATOM_LAST + 1)
-# undef atom
-#endif
+	TASK_PROPERTY_DESKTOP	= 0x01,
+	TASK_PROPERTY_ICON	= 0x02,
+	TASK_PROPERTY_NAME	= 0x04,
+	TASK_PROPERTY_STATE	= 0x08,
+	TASK_PROPERTY_TYPE	= 0x10
+} TaskProperty;
+# define TASK_PROPERTY_ALL	0x1f
+
+typedef struct _TaskRequest
+{
+	unsigned int properties;
+	int index;
 
-typedef struct _PanelApplet Tasks;
+	/* icon, in 32-bit units */
+	unsigned long icon_offset;	/* of the next image		*/
+	unsigned long icon_best;	/* of the best image so far	*/
+	long icon_width;		/* of the best image so far	*/
+} TaskRequest;
 
-#if defined(GDK_WINDOWING_X11)
 typedef struct _Task
 {
 	Tasks * tasks;
@@ -67,6 +82,13 @@ typedef struct _Task
 	GtkWidget * label;
 	gboolean delete;
 	gboolean reorder;
+	gboolean visible;
+
+	/* cached properties */
+	guint32 icon;			/* hash of the image displayed	*/
+	int desktop;
+	gboolean normal;
+	gboolean skip;
 } Task;
 #endif
 
@@ -76,9 +98,12 @@ struct _PanelApplet
 #if defined(GDK_WINDOWING_X11)
 	Task ** tasks;
 	size_t tasks_cnt;
+	GHashTable * windows;		/* Window to Task, for lookups	*/
 	gboolean label;
 	gboolean reorder;
 	gboolean embedded;
+	int desktop;
+	size_t added;			/* kept last, until refreshed	*/
 
 	GtkWidget * widget;
 	GtkWidget * hbox;
@@ -87,7 +112,9 @@ struct _PanelApplet
 	int icon_height;
 	gulong source;
 
-	Atom atom[TASKS_ATOM_COUNT];
+	PanelClients * clients;
+	gboolean subscribed;
+	Atom const * atom;
 	GdkDisplay * display;
 	GdkScreen * screen;
 	GdkWindow * root;
@@ -97,12 +124,7 @@ struct _PanelApplet
 
 #if defined(GDK_WINDOWING_X11)
 /* constants */
-# define atom(a) "" # a
-static const char * _tasks_atom[TASKS_ATOM_COUNT] =
-{
-# include "tasks.atoms"
-};
-# undef atom
+# define TASKS_ICON_SIZE_MAX			1024
 
 # define _NET_WM_MOVERESIZE_MOVE		 8 /* movement only */
 # define _NET_WM_MOVERESIZE_SIZE_KEYBOARD	 9 /* size via keyboard */
@@ -114,37 +136,34 @@ static const char * _tasks_atom[TASKS_ATOM_COUNT] =
 #if defined(GDK_WINDOWING_X11)
 /* task */
 static Task * _task_new(Tasks * tasks, gboolean label, gboolean reorder,
-		Window window, char const * name, GdkPixbuf * pixbuf);
+		Window window);
 static void _task_delete(Task * Task);
-static void _task_set(Task * task, char const * name, GdkPixbuf * pixbuf);
-static void _task_toggle_state(Task * task, TasksAtom state);
-static void _task_toggle_state2(Task * task, TasksAtom state1,
-		TasksAtom state2);
+static void _task_set_name(Task * task, char const * name);
+static void _task_set_pixbuf(Task * task, GdkPixbuf * pixbuf);
+static void _task_show(Task * task);
+static void _task_toggle_state(Task * task, PanelClientsAtom state);
+static void _task_toggle_state2(Task * task, PanelClientsAtom state1,
+		PanelClientsAtom state2);
 #endif
 
 /* tasks */
 static Tasks * _tasks_init(PanelAppletHelper * helper, GtkWidget ** widget);
 static void _tasks_destroy(Tasks * tasks);
+static void _tasks_resume(Tasks * tasks);
+static void _tasks_suspend(Tasks * tasks);
 
 #if defined(GDK_WINDOWING_X11)
-/* accessors */
-static int _tasks_get_current_desktop(Tasks * tasks);
-static int _tasks_get_text_property(Tasks * tasks, Window window, Atom property,
-		char ** ret);
-static int _tasks_get_window_property(Tasks * tasks, Window window,
-		TasksAtom property, Atom atom, unsigned long * cnt,
-		unsigned char ** ret);
-
 /* useful */
 static void _tasks_do(Tasks * tasks);
+static Task * _tasks_lookup(Tasks * tasks, Window window);
+static void _tasks_refresh(Tasks * tasks, Task ** t, size_t t_cnt,
+		unsigned int properties);
 
 /* callbacks */
 static gboolean _task_on_button_press(GtkWidget * widget,
 		GdkEventButton * event, gpointer data);
 static void _task_on_clicked(gpointer data);
 static gboolean _task_on_delete_event(gpointer data);
-static GdkFilterReturn _task_on_filter(GdkXEvent * xevent, GdkEvent * event,
-		gpointer data);
 static gboolean _task_on_popup(gpointer data);
 static void _task_on_popup_change_desktop(gpointer data);
 static void _task_on_popup_close(gpointer data);
@@ -159,6 +178,8 @@ static void _task_on_popup_shade(gpointer data);
 static void _task_on_popup_stick(gpointer data);
 static void _task_on_screen_changed(GtkWidget * widget, GdkScreen * previous,
 		gpointer data);
+static void _tasks_on_clients(void * data, PanelClientsEvent event,
+		Window window, PanelClientsAtom property);
 #endif
 
 
@@ -177,7 +198,9 @@ PanelAppletDefinition applet =
 #else
 	FALSE,
 #endif
-	TRUE
+	TRUE,
+	_tasks_suspend,
+	_tasks_resume
 };
 
 
@@ -187,7 +210,7 @@ PanelAppletDefinition applet =
 /* Task */
 /* task_new */
 static Task * _task_new(Tasks * tasks, gboolean label, gboolean reorder,
-		Window window, char const * name, GdkPixbuf * pixbuf)
+		Window window)
 {
 	Task * task;
 	GtkWidget * hbox;
@@ -211,6 +234,11 @@ static Task * _task_new(Tasks * tasks, gboolean label, gboolean reorder,
 	task->image = gtk_image_new();
 	task->delete = FALSE;
 	task->reorder = reorder;
+	task->visible = FALSE;
+	task->icon = 0;
+	task->desktop = -1;
+	task->normal = FALSE;
+	task->skip = FALSE;
 # if GTK_CHECK_VERSION(3, 0, 0)
 	hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0);
 # else
@@ -219,7 +247,7 @@ static Task * _task_new(Tasks * tasks, gboolean label, gboolean reorder,
 	gtk_box_pack_start(GTK_BOX(hbox), task->image, FALSE, TRUE, 0);
 	if(label)
 	{
-		task->label = gtk_label_new(name);
+		task->label = gtk_label_new(NULL);
 # if GTK_CHECK_VERSION(3, 0, 0) /* XXX should work with Gtk+ 2 too */
 		gtk_label_set_ellipsize(GTK_LABEL(task->label),
 				PANGO_ELLIPSIZE_END);
@@ -236,8 +264,11 @@ static Task * _task_new(Tasks * tasks, gboolean label, gboolean reorder,
 	}
 	else
 		task->label = NULL;
+	gtk_widget_show_all(hbox);
 	gtk_container_add(GTK_CONTAINER(task->widget), hbox);
-	_task_set(task, name, pixbuf);
+	/* only shown once known to belong to the current desktop */
+	gtk_widget_set_no_show_all(task->widget, TRUE);
+	_task_set_pixbuf(task, NULL);
 	return task;
 }
 
@@ -251,14 +282,20 @@ static void _task_delete(Task * task)
 }
 
 
-/* task_set */
-static void _task_set(Task * task, char const * name, GdkPixbuf * pixbuf)
+/* task_set_name */
+static void _task_set_name(Task * task, char const * name)
 {
 	if(task->label != NULL)
 		gtk_label_set_text(GTK_LABEL(task->label), name);
 #if GTK_CHECK_VERSION(2, 12, 0)
 	gtk_widget_set_tooltip_text(task->widget, name);
 #endif
+}
+
+
+/* task_set_pixbuf */
+static void _task_set_pixbuf(Task * task, GdkPixbuf * pixbuf)
+{
 	if(pixbuf != NULL)
 		gtk_image_set_from_pixbuf(GTK_IMAGE(task->image), pixbuf);
 	else
@@ -268,16 +305,35 @@ static void _task_set(Task * task, char const * name, GdkPixbuf * pixbuf)
 }
 
 
+/* task_show */
+static void _task_show(Task * task)
+{
+	Tasks * tasks = task->tasks;
+	gboolean visible;
+
+	visible = task->normal && !task->skip && (task->desktop < 0
+			|| tasks->desktop < 0
+			|| task->desktop == tasks->desktop);
+	if(task->widget == NULL || visible == task->visible)
+		return;
+	task->visible = visible;
+	if(visible)
+		gtk_widget_show(task->widget);
+	else
+		gtk_widget_hide(task->widget);
+}
+
+
 /* task_toggle_state */
-static void _task_toggle_state(Task * task, TasksAtom state)
+static void _task_toggle_state(Task * task, PanelClientsAtom state)
 {
 	_task_toggle_state2(task, state, 0);
 }
 
 
 /* task_toggle_state2 */
-static void _task_toggle_state2(Task * task, TasksAtom state1,
-		TasksAtom state2)
+static void _task_toggle_state2(Task * task, PanelClientsAtom state1,
+		PanelClientsAtom state2)
 {
 	Tasks * tasks = task->tasks;
 	GdkDisplay * display;
@@ -287,9 +343,11 @@ static void _task_toggle_state2(Task * task, TasksAtom state1,
 	memset(&xev, 0, sizeof(xev));
 	xev.xclient.type = ClientMessage;
 	xev.xclient.window = task->window;
-	xev.xclient.message_type = tasks->atom[TASKS_ATOM__NET_WM_STATE];
+	xev.xclient.message_type = tasks->atom[
+		PANEL_CLIENTS_ATOM__NET_WM_STATE];
 	xev.xclient.format = 32;
-	xev.xclient.data.l[0] = tasks->atom[TASKS_ATOM__NET_WM_STATE_TOGGLE];
+	xev.xclient.data.l[0] = tasks->atom[
+		PANEL_CLIENTS_ATOM__NET_WM_STATE_TOGGLE];
 	xev.xclient.data.l[1] = tasks->atom[state1];
 	xev.xclient.data.l[2] = (state2 != 0) ? tasks->atom[state2] : 0;
 	xev.xclient.data.l[3] = 2;
@@ -320,6 +378,7 @@ static Tasks * _tasks_init(PanelAppletHelper * helper, GtkWidget ** widget)
 	tasks->helper = helper;
 	tasks->tasks = NULL;
 	tasks->tasks_cnt = 0;
+	tasks->windows = g_hash_table_new(g_direct_hash, g_direct_equal);
 	/* config: label */
 	if((p = helper->config_get(helper->panel, "tasks", "label")) != NULL)
 		tasks->label = strtol(p, NULL, 0) ? TRUE : FALSE;
@@ -343,6 +402,8 @@ static Tasks * _tasks_init(PanelAppletHelper * helper, GtkWidget ** widget)
 #else
 	tasks->embedded = FALSE;
 #endif
+	tasks->desktop = -1;
+	tasks->added = 0;
 	orientation = panel_window_get_orientation(helper->window);
 #if GTK_CHECK_VERSION(3, 0, 0)
 	tasks->hbox = gtk_box_new(orientation, 0);
@@ -360,6 +421,9 @@ static Tasks * _tasks_init(PanelAppletHelper * helper, GtkWidget ** widget)
 			&tasks->icon_height);
 	tasks->icon_width -= 4;
 	tasks->icon_height -= 4;
+	tasks->clients = NULL;
+	tasks->subscribed = FALSE;
+	tasks->atom = NULL;
 	tasks->display = NULL;
 	tasks->screen = NULL;
 	tasks->root = NULL;
@@ -400,13 +464,17 @@ static void _tasks_destroy(Tasks * tasks)
 	if(tasks->source != 0)
 		g_signal_handler_disconnect(tasks->widget, tasks->source);
 	tasks->source = 0;
-	if(tasks->root != NULL)
-		gdk_window_remove_filter(tasks->root, _task_on_filter, tasks);
+	if(tasks->clients != NULL)
+	{
+		_tasks_suspend(tasks);
+		panel_clients_release(tasks->clients);
+	}
 	for(i = 0; i < tasks->tasks_cnt; i++)
 		_task_delete(tasks->tasks[i]);
 	free(tasks->tasks);
 	tasks->tasks = NULL;
 	tasks->tasks_cnt = 0;
+	g_hash_table_destroy(tasks->windows);
 	gtk_widget_destroy(tasks->widget);
 	free(tasks);
 #else
@@ -415,336 +483,320 @@ static void _tasks_destroy(Tasks * tasks)
 }
 
 
-#if defined(GDK_WINDOWING_X11)
-/* accessors */
-/* tasks_get_current_desktop */
-static int _tasks_get_current_desktop(Tasks * tasks)
-{
-	unsigned long cnt;
-	unsigned long *p;
-
-	if(tasks->embedded)
-		/* ignore the current desktop */
-		return -1;
-	if(_tasks_get_window_property(tasks, GDK_WINDOW_XID(tasks->root),
-				TASKS_ATOM__NET_CURRENT_DESKTOP, XA_CARDINAL,
-				&cnt, (void *)&p) != 0)
-		return -1;
-	cnt = *p;
-	XFree(p);
-	return cnt;
-}
-
-
-/* tasks_get_text_property */
-static int _tasks_get_text_property(Tasks * tasks, Window window, Atom property,
-		char ** ret)
+/* tasks_resume */
+static void _tasks_resume(Tasks * tasks)
 {
-	int res;
-	XTextProperty text;
-	GdkAtom atom;
-	int cnt;
-	char ** list;
-	int i;
-
-# ifdef DEBUG
-	fprintf(stderr, "DEBUG: %s(tasks, window, %lu)\n", __func__, property);
-# endif
-	gdk_error_trap_push();
-	res = XGetTextProperty(GDK_DISPLAY_XDISPLAY(tasks->display), window,
-			&text, property);
-	if(gdk_error_trap_pop() != 0 || res == 0)
-		return -1;
-	atom = gdk_x11_xatom_to_atom(text.encoding);
-# if GTK_CHECK_VERSION(2, 24, 0)
-	cnt = gdk_x11_display_text_property_to_text_list(tasks->display,
-			atom, text.format, text.value, text.nitems, &list);
-# else
-	cnt = gdk_text_property_to_utf8_list(atom, text.format, text.value,
-			text.nitems, &list);
-# endif
-	if(cnt > 0)
-	{
-		*ret = list[0];
-		for(i = 1; i < cnt; i++)
-			g_free(list[i]);
-		g_free(list);
-	}
-	else
-		*ret = NULL;
-	if(text.value != NULL)
-		XFree(text.value);
-	return 0;
+#if defined(GDK_WINDOWING_X11)
+	if(tasks->clients == NULL || tasks->subscribed)
+		return;
+	/* track the changes again, and catch up with them */
+	if(panel_clients_subscribe(tasks->clients, tasks->helper->window,
+				_tasks_on_clients, tasks) != 0)
+		return;
+	tasks->subscribed = TRUE;
+	_tasks_refresh(tasks, tasks->tasks, tasks->tasks_cnt,
+			TASK_PROPERTY_ALL);
+	_tasks_do(tasks);
+#else
+	(void) tasks;
+#endif
 }
 
 
-/* tasks_get_window_property */
-static int _tasks_get_window_property(Tasks * tasks, Window window,
-		TasksAtom property, Atom atom, unsigned long * cnt,
-		unsigned char ** ret)
+/* tasks_suspend */
+static void _tasks_suspend(Tasks * tasks)
 {
-	int res;
-	Atom type;
-	int format;
-	unsigned long bytes;
-
-# ifdef DEBUG
-	fprintf(stderr, "DEBUG: %s(tasks, window, %s, %lu)\n", __func__,
-			_tasks_atom[property], atom);
-# endif
-	gdk_error_trap_push();
-	res = XGetWindowProperty(GDK_DISPLAY_XDISPLAY(tasks->display), window,
-			tasks->atom[property], 0, G_MAXLONG, False, atom,
-			&type, &format, cnt, &bytes, ret);
-	if(gdk_error_trap_pop() != 0 || res != Success)
-		return -1;
-	if(type != atom)
-	{
-		if(*ret != NULL)
-			XFree(*ret);
-		*ret = NULL;
-		return 1;
-	}
-	return 0;
+#if defined(GDK_WINDOWING_X11)
+	if(tasks->clients != NULL && tasks->subscribed)
+		panel_clients_unsubscribe(tasks->clients, _tasks_on_clients,
+				tasks);
+	tasks->subscribed = FALSE;
+#else
+	(void) tasks;
+#endif
 }
 
 
+#if defined(GDK_WINDOWING_X11)
+/* useful */
 /* tasks_do */
-static char * _do_name(Tasks * tasks, Window window);
-static char * _do_name_text(Tasks * tasks, Window window, Atom property);
-static char * _do_name_utf8(Tasks * tasks, Window window, Atom property);
-static GdkPixbuf * _do_pixbuf(Tasks * tasks, Window window);
-static int _do_tasks_add(Tasks * tasks, int desktop, Window window,
-		char const * name, GdkPixbuf * pixbuf);
+static int _do_tasks_add(Tasks * tasks, Window window);
 static void _do_tasks_clean(Tasks * tasks);
-static int _do_typehint_normal(Tasks * tasks, Window window);
 
 static void _tasks_do(Tasks * tasks)
 {
-	unsigned long cnt = 0;
-	Window * windows = NULL;
-	int desktop;
-	unsigned long i;
-	char * name;
+	Window const * windows;
+	size_t cnt;
+	size_t i;
+	Task * task;
 
 # ifdef DEBUG
 	fprintf(stderr, "DEBUG: %s()\n", __func__);
 # endif
-	if(_tasks_get_window_property(tasks, GDK_WINDOW_XID(tasks->root),
-				TASKS_ATOM__NET_CLIENT_LIST,
-				XA_WINDOW, &cnt, (void *)&windows) != 0)
-		return;
-	desktop = _tasks_get_current_desktop(tasks);
+	windows = panel_clients_get_clients(tasks->clients, &cnt);
+	tasks->desktop = tasks->embedded ? -1
+		: panel_clients_get_current_desktop(tasks->clients);
 	for(i = 0; i < tasks->tasks_cnt; i++)
 		tasks->tasks[i]->delete = TRUE;
 	for(i = 0; i < cnt; i++)
-	{
-		if(_do_typehint_normal(tasks, windows[i]) != 0)
-			continue;
-		if((name = _do_name(tasks, windows[i])) == NULL)
-			continue;
-		_do_tasks_add(tasks, desktop, windows[i], name, _do_pixbuf(
-					tasks, windows[i]));
-		g_free(name);
-	}
+		if((task = _tasks_lookup(tasks, windows[i])) != NULL)
+			task->delete = FALSE;
+		else
+			_do_tasks_add(tasks, windows[i]);
 	_do_tasks_clean(tasks);
-	XFree(windows);
+	/* the new tasks are kept last, and refreshed all at once */
+	_tasks_refresh(tasks, &tasks->tasks[tasks->tasks_cnt - tasks->added],
+			tasks->added, TASK_PROPERTY_ALL);
+	tasks->added = 0;
+	for(i = 0; i < tasks->tasks_cnt; i++)
+		_task_show(tasks->tasks[i]);
 }
 
-static char * _do_name(Tasks * tasks, Window window)
+static int _do_tasks_add(Tasks * tasks, Window window)
 {
-	char * ret;
-
-	if((ret = _do_name_utf8(tasks, window, TASKS_ATOM__NET_WM_VISIBLE_NAME))
-			!= NULL)
-		return ret;
-	if((ret = _do_name_utf8(tasks, window, TASKS_ATOM__NET_WM_NAME))
-			!= NULL)
-		return ret;
-	if((ret = _do_name_text(tasks, window, XA_WM_NAME)) != NULL)
-		return ret;
-	return g_strdup(_("(Untitled)"));
+	Task * p;
+	Task ** q;
+
+	if((q = realloc(tasks->tasks, (tasks->tasks_cnt + 1) * sizeof(*q)))
+			== NULL)
+		return 1;
+	tasks->tasks = q;
+	if((p = _task_new(tasks, tasks->label, tasks->reorder, window)) == NULL)
+		return 1;
+	tasks->tasks[tasks->tasks_cnt++] = p;
+	tasks->added++;
+	g_hash_table_insert(tasks->windows, GSIZE_TO_POINTER(window), p);
+	gtk_box_pack_start(GTK_BOX(tasks->hbox), p->widget, FALSE, TRUE, 0);
+	if(tasks->reorder)
+		gtk_box_reorder_child(GTK_BOX(tasks->hbox), p->widget, 0);
+	return 0;
 }
 
-static char * _do_name_text(Tasks * tasks, Window window, Atom property)
+static void _do_tasks_clean(Tasks * tasks)
 {
-	char * ret = NULL;
+	size_t i;
+	size_t cnt;
+	Task * task;
+	Task ** q;
 
-	if(_tasks_get_text_property(tasks, window, property, (void *)&ret) != 0)
-		return NULL;
-	return ret;
+	/* keep the order of the remaining tasks, in a single pass */
+	for(i = 0, cnt = 0; i < tasks->tasks_cnt; i++)
+	{
+		task = tasks->tasks[i];
+		if(task->delete == FALSE)
+		{
+			tasks->tasks[cnt++] = task;
+			continue;
+		}
+		g_hash_table_remove(tasks->windows,
+				GSIZE_TO_POINTER(task->window));
+		_task_delete(task);
+	}
+	if(cnt == tasks->tasks_cnt)
+		return;
+	tasks->tasks_cnt = cnt;
+	if(cnt == 0)
+	{
+		free(tasks->tasks);
+		tasks->tasks = NULL;
+	}
+	else if((q = realloc(tasks->tasks, cnt * sizeof(*q))) != NULL)
+		tasks->tasks = q;
 }
 
-static char * _do_name_utf8(Tasks * tasks, Window window, Atom property)
+/* tasks_lookup */
+static Task * _tasks_lookup(Tasks * tasks, Window window)
 {
-	char * ret = NULL;
-	char * str = NULL;
-	unsigned long cnt = 0;
-
-	if(_tasks_get_window_property(tasks, window, property,
-				tasks->atom[TASKS_ATOM_UTF8_STRING], &cnt,
-				(void *)&str) != 0)
-		return NULL;
-	if(g_utf8_validate(str, cnt, NULL))
-		ret = g_strndup(str, cnt);
-	XFree(str);
-	return ret;
+	return g_hash_table_lookup(tasks->windows, GSIZE_TO_POINTER(window));
 }
 
-static GdkPixbuf * _do_pixbuf(Tasks * tasks, Window window)
+
+/* tasks_refresh */
+static void _refresh_request(Tasks * tasks, PanelProperties * properties,
+		Task * task, TaskRequest * request);
+static int _refresh_icon_header(Tasks * tasks, PanelProperties * properties,
+		Task * task, TaskRequest * request);
+static void _refresh_icon(Tasks * tasks, PanelProperties * properties,
+		Task * task, TaskRequest * request);
+
+static void _tasks_refresh(Tasks * tasks, Task ** t, size_t t_cnt,
+		unsigned int properties)
 {
-	GdkPixbuf * ret;
-	unsigned long cnt = 0;
-	unsigned long * buf = NULL;
-	unsigned long i;
-	long width;
-	long height;
-	unsigned long size;
-	unsigned char * pixbuf = NULL;
-	unsigned long j;
-	GdkPixbuf * p;
-	unsigned long * best = NULL;
+	PanelProperties * pp;
+	TaskRequest * r;
+	size_t i;
+	size_t icons = 0;
+	gboolean normal;
+	char const * name;
+	gboolean pending;
 
-	if(_tasks_get_window_property(tasks, window, TASKS_ATOM__NET_WM_ICON,
-				XA_CARDINAL, &cnt, (void *)&buf) != 0)
-		return NULL;
-	for(i = 0; i < cnt - 3; i += 2 + (width * height))
+	if(t_cnt == 0 || (r = malloc(sizeof(*r) * t_cnt)) == NULL)
+		return;
+	/* first whether to list the windows, as tracked already */
+	for(i = 0; i < t_cnt; i++)
 	{
-		width = buf[i];
-		height = buf[i + 1];
-		if(i + 2 + (width * height) > cnt)
-			break;
-		if(width <= 0 || height <= 0 || width != height)
-			continue;
-		if(tasks->icon_width == width)
+		r[i].properties = properties;
+		if(properties & TASK_PROPERTY_TYPE)
 		{
-			best = &buf[i];
-			break;
+			normal = panel_clients_get_typehint_normal(
+					tasks->clients, t[i]->window);
+			if(normal && !t[i]->normal)
+				r[i].properties |= TASK_PROPERTY_NAME
+					| TASK_PROPERTY_ICON;
+			t[i]->normal = normal;
 		}
-		if(best == NULL || abs(best[0] - tasks->icon_width)
-				> abs(width - tasks->icon_width))
-			best = &buf[i];
-	}
-	if(best != NULL)
-	{
-		width = best[0];
-		height = best[1];
-		size = width * height * 4;
-		pixbuf = malloc(size);
-	}
-	if(best == NULL || pixbuf == NULL)
-	{
-		XFree(buf);
-		return NULL;
+# ifndef EMBEDDED
+		if(properties & TASK_PROPERTY_DESKTOP)
+			t[i]->desktop = panel_clients_get_desktop(
+					tasks->clients, t[i]->window);
+# endif
+		if(properties & TASK_PROPERTY_STATE)
+			t[i]->skip = panel_clients_get_state(tasks->clients,
+					t[i]->window,
+					PANEL_CLIENTS_ATOM__NET_WM_STATE_SKIP_TASKBAR);
+		/* then the names and icons, only for the windows listed */
+		if(!t[i]->normal)
+			r[i].properties &= ~(TASK_PROPERTY_NAME
+					| TASK_PROPERTY_ICON);
+		if(r[i].properties & TASK_PROPERTY_NAME)
+		{
+			name = panel_clients_get_name(tasks->clients,
+					t[i]->window);
+			_task_set_name(t[i], (name != NULL)
+					? name : _("(Untitled)"));
+		}
+		if(r[i].properties & TASK_PROPERTY_ICON)
+			icons++;
 	}
-	for(i = 2, j = 0; j < size; i++)
+	/* the icons are not tracked by the model */
+	if(icons > 0 && (pp = panel_properties_new(tasks->display)) != NULL)
 	{
-		pixbuf[j++] = (best[i] >> 16) & 0xff; /* red */
-		pixbuf[j++] = (best[i] >> 8) & 0xff; /* green */
-		pixbuf[j++] = best[i] & 0xff; /* blue */
-		pixbuf[j++] = best[i] >> 24; /* alpha */
+		for(i = 0; i < t_cnt; i++)
+			if(r[i].properties & TASK_PROPERTY_ICON)
+				_refresh_request(tasks, pp, t[i], &r[i]);
+		/* walk through the sizes of the icons, for every window at
+		 * once */
+		do
+		{
+			pending = FALSE;
+			for(i = 0; i < t_cnt; i++)
+				if((r[i].properties & TASK_PROPERTY_ICON)
+						&& _refresh_icon_header(tasks,
+							pp, t[i], &r[i]) != 0)
+					pending = TRUE;
+		}
+		while(pending);
+		/* then only fetch the image selected */
+		for(i = 0; i < t_cnt; i++)
+			if((r[i].properties & TASK_PROPERTY_ICON)
+					&& r[i].icon_width > 0)
+				r[i].index = panel_properties_add_range(pp,
+						t[i]->window, tasks->atom[
+						PANEL_CLIENTS_ATOM__NET_WM_ICON],
+						XA_CARDINAL,
+						r[i].icon_best + 2,
+						r[i].icon_width
+						* r[i].icon_width);
+		for(i = 0; i < t_cnt; i++)
+			if(r[i].properties & TASK_PROPERTY_ICON)
+				_refresh_icon(tasks, pp, t[i], &r[i]);
+		panel_properties_delete(pp);
 	}
-	p = gdk_pixbuf_new_from_data(pixbuf, GDK_COLORSPACE_RGB, TRUE, 8, width,
-			height, width * 4, (GdkPixbufDestroyNotify)free, NULL);
-	XFree(buf);
-	if(width == tasks->icon_width)
-		return p;
-	ret = gdk_pixbuf_scale_simple(p, tasks->icon_width, tasks->icon_height,
-			GDK_INTERP_BILINEAR);
-	g_object_unref(p);
-	return ret;
+	for(i = 0; i < t_cnt; i++)
+		_task_show(t[i]);
+	free(r);
 }
 
-static int _do_tasks_add(Tasks * tasks, int desktop, Window window,
-		char const * name, GdkPixbuf * pixbuf)
+static void _refresh_request(Tasks * tasks, PanelProperties * properties,
+		Task * task, TaskRequest * request)
+{
+	/* only the size of the first image */
+	request->icon_offset = 0;
+	request->icon_best = 0;
+	request->icon_width = 0;
+	request->index = panel_properties_add_range(properties, task->window,
+			tasks->atom[PANEL_CLIENTS_ATOM__NET_WM_ICON],
+			XA_CARDINAL, 0, 2);
+}
+
+static int _refresh_icon_header(Tasks * tasks, PanelProperties * properties,
+		Task * task, TaskRequest * request)
 {
-	size_t i;
-	Task * p = NULL;
-# ifndef EMBEDDED
-	unsigned long * l;
 	unsigned long cnt;
-	int cur = -1;
-# endif
-	Task ** q;
+	unsigned long * p;
+	unsigned long remaining;
+	long width;
+	long height;
+	unsigned long size;
 
-# ifndef EMBEDDED
-	if(_tasks_get_window_property(tasks, window, TASKS_ATOM__NET_WM_DESKTOP,
-			XA_CARDINAL, &cnt, (void *)&l) == 0)
-	{
-		if(cnt == 1)
-			cur = *l;
-		XFree(l);
-	}
-	if(cur >= 0 && cur != desktop)
+	if(panel_properties_get(properties, request->index,
+				&cnt, (void *)&p) != 0 || cnt != 2)
 		return 0;
-# endif
-	for(i = 0; i < tasks->tasks_cnt; i++)
-		if(tasks->tasks[i]->window == window)
-			break;
-	if(i < tasks->tasks_cnt) /* found the task */
-	{
-		p = tasks->tasks[i];
-		_task_set(p, name, pixbuf);
-		p->delete = FALSE;
+	remaining = panel_properties_get_remaining(properties,
+			request->index);
+	width = p[0];
+	height = p[1];
+	if(width <= 0 || height <= 0 || width > TASKS_ICON_SIZE_MAX
+			|| height > TASKS_ICON_SIZE_MAX)
+		return 0;
+	size = width * height;
+	if(size * 4 > remaining)
+		/* truncated */
 		return 0;
+	if(width == height && (request->icon_width == 0
+				|| labs(request->icon_width - tasks->icon_width)
+				> labs(width - tasks->icon_width)))
+	{
+		request->icon_best = request->icon_offset;
+		request->icon_width = width;
 	}
-	if((q = realloc(tasks->tasks, (tasks->tasks_cnt + 1) * sizeof(*q)))
-			== NULL)
-		return 1;
-	tasks->tasks = q;
-	if((p = _task_new(tasks, tasks->label, tasks->reorder, window, name,
-					pixbuf)) == NULL)
-		return 1;
-	tasks->tasks[tasks->tasks_cnt++] = p;
-	gtk_widget_show_all(p->widget);
-	gtk_box_pack_start(GTK_BOX(tasks->hbox), p->widget, FALSE, TRUE, 0);
-	if(tasks->reorder)
-		gtk_box_reorder_child(GTK_BOX(tasks->hbox), p->widget, 0);
-	return 0;
+	if(request->icon_width == tasks->icon_width
+			|| remaining - size * 4 < 2 * 4)
+		return 0;
+	/* only the size of the next image */
+	request->icon_offset += 2 + size;
+	request->index = panel_properties_add_range(
+			properties, task->window,
+			tasks->atom[PANEL_CLIENTS_ATOM__NET_WM_ICON], XA_CARDINAL,
+			request->icon_offset, 2);
+	return 1;
 }
 
-static void _do_tasks_clean(Tasks * tasks)
+static void _refresh_icon(Tasks * tasks, PanelProperties * properties,
+		Task * task, TaskRequest * request)
 {
-	size_t i;
-	size_t cnt;
-	size_t j;
-	Task ** q;
+	unsigned long cnt;
+	unsigned long * p;
+	guint32 hash = 2166136261U;
+	unsigned long i;
+	GdkPixbuf * pixbuf;
 
-	for(i = 0, cnt = tasks->tasks_cnt; i < cnt;)
+	if(request->icon_width == 0 || panel_properties_get(properties,
+				request->index, &cnt,
+				(void *)&p) != 0 || cnt == 0
+			|| cnt != (unsigned long)(request->icon_width
+				* request->icon_width))
 	{
-		if(tasks->tasks[i]->delete == FALSE)
-		{
-			i++;
-			continue;
-		}
-		_task_delete(tasks->tasks[i]);
-		cnt--;
-		for(j = i; j < cnt; j++)
-			tasks->tasks[j] = tasks->tasks[j + 1];
-		if((q = realloc(tasks->tasks, cnt * sizeof(*q))) != NULL
-				|| cnt == 0)
-			tasks->tasks = q;
+		if(task->icon != 0)
+			_task_set_pixbuf(task, NULL);
+		task->icon = 0;
+		return;
 	}
-	tasks->tasks_cnt = cnt;
-}
-
-static int _do_typehint_normal(Tasks * tasks, Window window)
-{
-	Atom typehint;
-	Atom * p;
-	unsigned long cnt = 0;
-
-	if(_tasks_get_window_property(tasks, window,
-				TASKS_ATOM__NET_WM_WINDOW_TYPE, XA_ATOM, &cnt,
-				(void *)&p) == 0)
+	/* the image may not have changed at all (FNV-1a) */
+	for(i = 0; i < cnt; i++)
 	{
-		typehint = *p;
-		XFree(p);
-		return typehint == tasks->atom[
-			TASKS_ATOM__NET_WM_WINDOW_TYPE_NORMAL] ? 0 : 1;
+		hash ^= (guint32)p[i];
+		hash *= 16777619U;
 	}
-	/* FIXME return 1 if WM_TRANSIENT_FOR is set */
-	return 0;
+	if(hash == task->icon)
+		return;
+	pixbuf = panel_image_new_pixbuf(p, request->icon_width,
+			request->icon_width, tasks->icon_width,
+			tasks->icon_height);
+	_task_set_pixbuf(task, pixbuf);
+	if(pixbuf != NULL)
+		g_object_unref(pixbuf);
+	task->icon = (pixbuf != NULL) ? hash : 0;
 }
 
 
@@ -788,7 +840,7 @@ static void _clicked_activate(Task * task)
 	xev.xclient.type = ClientMessage;
 	xev.xclient.window = task->window;
 	xev.xclient.message_type = task->tasks->atom[
-		TASKS_ATOM__NET_ACTIVE_WINDOW];
+		PANEL_CLIENTS_ATOM__NET_ACTIVE_WINDOW];
 	xev.xclient.format = 32;
 	xev.xclient.data.l[0] = 2;
 	xev.xclient.data.l[1] = gdk_x11_display_get_user_time(display);
@@ -820,64 +872,44 @@ static gboolean _task_on_delete_event(gpointer data)
 }
 
 
-/* task_on_filter */
-static GdkFilterReturn _task_on_filter(GdkXEvent * xevent, GdkEvent * event,
-		gpointer data)
-{
-	Tasks * tasks = data;
-	XEvent * xev = xevent;
-	(void) event;
-
-	if(xev->type != PropertyNotify)
-		return GDK_FILTER_CONTINUE;
-	if(xev->xproperty.atom != tasks->atom[TASKS_ATOM__NET_CLIENT_LIST]
-# ifndef EMBEDDED
-			&& xev->xproperty.atom
-			!= tasks->atom[TASKS_ATOM__NET_CURRENT_DESKTOP]
-# endif
-			)
-		return GDK_FILTER_CONTINUE;
-	_tasks_do(tasks);
-	return GDK_FILTER_CONTINUE;
-}
-
-
 /* task_on_popup */
 static gboolean _task_on_popup(gpointer data)
 {
 	Task * task = data;
+	PanelProperties * properties;
 	unsigned long cnt = 0;
 	unsigned long * buf = NULL;
 	unsigned long i;
 	const struct {
-		TasksAtom atom;
+		PanelClientsAtom atom;
 		void (*callback)(gpointer data);
 		char const * stock;
 		char const * label;
 	} items[] = {
-		{ TASKS_ATOM__NET_WM_ACTION_MOVE, _task_on_popup_move, NULL,
-			N_("Move") },
-		{ TASKS_ATOM__NET_WM_ACTION_RESIZE, _task_on_popup_resize, NULL,
-			N_("Resize") },
-		{ TASKS_ATOM__NET_WM_ACTION_MINIMIZE, _task_on_popup_minimize,
-			NULL, N_("Minimize") },
-		{ TASKS_ATOM__NET_WM_ACTION_SHADE, _task_on_popup_shade, NULL,
-			N_("Shade") },
-		{ TASKS_ATOM__NET_WM_ACTION_STICK, _task_on_popup_stick, NULL,
-			N_("Stick") },
-		{ TASKS_ATOM__NET_WM_ACTION_MAXIMIZE_HORZ,
+		{ PANEL_CLIENTS_ATOM__NET_WM_ACTION_MOVE,
+			_task_on_popup_move, NULL, N_("Move") },
+		{ PANEL_CLIENTS_ATOM__NET_WM_ACTION_RESIZE,
+			_task_on_popup_resize, NULL, N_("Resize") },
+		{ PANEL_CLIENTS_ATOM__NET_WM_ACTION_MINIMIZE,
+			_task_on_popup_minimize, NULL, N_("Minimize") },
+		{ PANEL_CLIENTS_ATOM__NET_WM_ACTION_SHADE,
+			_task_on_popup_shade, NULL, N_("Shade") },
+		{ PANEL_CLIENTS_ATOM__NET_WM_ACTION_STICK,
+			_task_on_popup_stick, NULL, N_("Stick") },
+		{ PANEL_CLIENTS_ATOM__NET_WM_ACTION_MAXIMIZE_HORZ,
 			_task_on_popup_maximize_horz, NULL,
 			N_("Maximize horizontally") },
-		{ TASKS_ATOM__NET_WM_ACTION_MAXIMIZE_VERT,
+		{ PANEL_CLIENTS_ATOM__NET_WM_ACTION_MAXIMIZE_VERT,
 			_task_on_popup_maximize_vert, NULL,
 			N_("Maximize vertically") },
-		{ TASKS_ATOM__NET_WM_ACTION_FULLSCREEN, _task_on_popup_fullscreen,
-			GTK_STOCK_FULLSCREEN, N_("Fullscreen") },
-		{ TASKS_ATOM__NET_WM_ACTION_CHANGE_DESKTOP,
+		{ PANEL_CLIENTS_ATOM__NET_WM_ACTION_FULLSCREEN,
+			_task_on_popup_fullscreen, GTK_STOCK_FULLSCREEN,
+			N_("Fullscreen") },
+		{ PANEL_CLIENTS_ATOM__NET_WM_ACTION_CHANGE_DESKTOP,
 			_task_on_popup_change_desktop, NULL,
 			N_("Change desktop") },
-		{ TASKS_ATOM__NET_WM_ACTION_CLOSE, _task_on_popup_close,
-			GTK_STOCK_CLOSE, N_("Close") }
+		{ PANEL_CLIENTS_ATOM__NET_WM_ACTION_CLOSE,
+			_task_on_popup_close, GTK_STOCK_CLOSE, N_("Close") }
 	};
 	const size_t items_cnt = sizeof(items) / sizeof(*items);
 	size_t j;
@@ -885,10 +917,16 @@ static gboolean _task_on_popup(gpointer data)
 	GtkWidget * menuitem;
 	int max = 0;
 
-	if(_tasks_get_window_property(task->tasks, task->window,
-				TASKS_ATOM__NET_WM_ALLOWED_ACTIONS, XA_ATOM,
-				&cnt, (void *)&buf) != 0)
+	if((properties = panel_properties_new(task->tasks->display)) == NULL)
 		return FALSE;
+	if(panel_properties_get(properties, panel_properties_add(properties,
+					task->window, task->tasks->atom[
+					PANEL_CLIENTS_ATOM__NET_WM_ALLOWED_ACTIONS],
+					XA_ATOM), &cnt, (void *)&buf) != 0)
+	{
+		panel_properties_delete(properties);
+		return FALSE;
+	}
 	for(i = 0; i < cnt; i++)
 	{
 		for(j = 0; j < items_cnt; j++)
@@ -896,7 +934,8 @@ static gboolean _task_on_popup(gpointer data)
 				break;
 		if(j == items_cnt)
 			continue;
-		if(items[j].atom == TASKS_ATOM__NET_WM_ACTION_CHANGE_DESKTOP)
+		if(items[j].atom
+				== PANEL_CLIENTS_ATOM__NET_WM_ACTION_CHANGE_DESKTOP)
 			continue; /* FIXME implement as a special case */
 		if(menu == NULL)
 			menu = gtk_menu_new();
@@ -922,9 +961,10 @@ static gboolean _task_on_popup(gpointer data)
 					items[j].callback), task);
 		gtk_menu_shell_append(GTK_MENU_SHELL(menu), menuitem);
 		/* maximizing horizontally and vertically */
-		if(items[j].atom != TASKS_ATOM__NET_WM_ACTION_MAXIMIZE_VERT
+		if(items[j].atom
+				!= PANEL_CLIENTS_ATOM__NET_WM_ACTION_MAXIMIZE_VERT
 				&& items[j].atom
-				!= TASKS_ATOM__NET_WM_ACTION_MAXIMIZE_HORZ)
+				!= PANEL_CLIENTS_ATOM__NET_WM_ACTION_MAXIMIZE_HORZ)
 			continue;
 		if(max++ != 1)
 			continue;
@@ -933,7 +973,7 @@ static gboolean _task_on_popup(gpointer data)
 					_task_on_popup_maximize), task);
 		gtk_menu_shell_append(GTK_MENU_SHELL(menu), menuitem);
 	}
-	XFree(buf);
+	panel_properties_delete(properties);
 	if(menu == NULL)
 		return FALSE;
 	gtk_widget_show_all(menu);
@@ -962,7 +1002,7 @@ static void _task_on_popup_close(gpointer data)
 	xev.xclient.type = ClientMessage;
 	xev.xclient.window = task->window;
 	xev.xclient.message_type = task->tasks->atom[
-		TASKS_ATOM__NET_CLOSE_WINDOW];
+		PANEL_CLIENTS_ATOM__NET_CLOSE_WINDOW];
 	xev.xclient.format = 32;
 	xev.xclient.data.l[0] = gdk_x11_display_get_user_time(display);
 	xev.xclient.data.l[1] = 2;
@@ -980,7 +1020,7 @@ static void _task_on_popup_fullscreen(gpointer data)
 {
 	Task * task = data;
 
-	_task_toggle_state(task, TASKS_ATOM__NET_WM_STATE_FULLSCREEN);
+	_task_toggle_state(task, PANEL_CLIENTS_ATOM__NET_WM_STATE_FULLSCREEN);
 }
 
 
@@ -989,8 +1029,9 @@ static void _task_on_popup_maximize(gpointer data)
 {
 	Task * task = data;
 
-	_task_toggle_state2(task, TASKS_ATOM__NET_WM_STATE_MAXIMIZED_HORZ,
-			TASKS_ATOM__NET_WM_STATE_MAXIMIZED_VERT);
+	_task_toggle_state2(task,
+			PANEL_CLIENTS_ATOM__NET_WM_STATE_MAXIMIZED_HORZ,
+			PANEL_CLIENTS_ATOM__NET_WM_STATE_MAXIMIZED_VERT);
 }
 
 
@@ -999,7 +1040,8 @@ static void _task_on_popup_maximize_horz(gpointer data)
 {
 	Task * task = data;
 
-	_task_toggle_state(task, TASKS_ATOM__NET_WM_STATE_MAXIMIZED_HORZ);
+	_task_toggle_state(task,
+			PANEL_CLIENTS_ATOM__NET_WM_STATE_MAXIMIZED_HORZ);
 }
 
 
@@ -1008,7 +1050,8 @@ static void _task_on_popup_maximize_vert(gpointer data)
 {
 	Task * task = data;
 
-	_task_toggle_state(task, TASKS_ATOM__NET_WM_STATE_MAXIMIZED_VERT);
+	_task_toggle_state(task,
+			PANEL_CLIENTS_ATOM__NET_WM_STATE_MAXIMIZED_VERT);
 }
 
 
@@ -1036,7 +1079,8 @@ static void _task_on_popup_move(gpointer data)
 	memset(&xev, 0, sizeof(xev));
 	xev.xclient.type = ClientMessage;
 	xev.xclient.window = task->window;
-	xev.xclient.message_type = tasks->atom[TASKS_ATOM__NET_WM_MOVERESIZE];
+	xev.xclient.message_type = tasks->atom[
+		PANEL_CLIENTS_ATOM__NET_WM_MOVERESIZE];
 	xev.xclient.format = 32;
 	memset(&xev.xclient.data, 0, sizeof(xev.xclient.data));
 	xev.xclient.data.l[2] = _NET_WM_MOVERESIZE_MOVE_KEYBOARD;
@@ -1063,7 +1107,8 @@ static void _task_on_popup_resize(gpointer data)
 	memset(&xev, 0, sizeof(xev));
 	xev.xclient.type = ClientMessage;
 	xev.xclient.window = task->window;
-	xev.xclient.message_type = tasks->atom[TASKS_ATOM__NET_WM_MOVERESIZE];
+	xev.xclient.message_type = tasks->atom[
+		PANEL_CLIENTS_ATOM__NET_WM_MOVERESIZE];
 	xev.xclient.format = 32;
 	memset(&xev.xclient.data, 0, sizeof(xev.xclient.data));
 	xev.xclient.data.l[2] = _NET_WM_MOVERESIZE_SIZE_KEYBOARD;
@@ -1083,7 +1128,7 @@ static void _task_on_popup_shade(gpointer data)
 {
 	Task * task = data;
 
-	_task_toggle_state(task, TASKS_ATOM__NET_WM_STATE_SHADED);
+	_task_toggle_state(task, PANEL_CLIENTS_ATOM__NET_WM_STATE_SHADED);
 }
 
 
@@ -1092,7 +1137,7 @@ static void _task_on_popup_stick(gpointer data)
 {
 	Task * task = data;
 
-	_task_toggle_state(task, TASKS_ATOM__NET_WM_STATE_STICKY);
+	_task_toggle_state(task, PANEL_CLIENTS_ATOM__NET_WM_STATE_STICKY);
 }
 
 
@@ -1101,25 +1146,106 @@ static void _task_on_screen_changed(GtkWidget * widget, GdkScreen * previous,
 		gpointer data)
 {
 	Tasks * tasks = data;
-	GdkEventMask events;
+	PanelClients * clients;
 	size_t i;
 	(void) previous;
 
 # ifdef DEBUG
 	fprintf(stderr, "DEBUG: %s()\n", __func__);
 # endif
-	if(tasks->root != NULL)
-		gdk_window_remove_filter(tasks->root, _task_on_filter, tasks);
+	if((clients = panel_clients_acquire(gtk_widget_get_screen(widget)))
+			== NULL)
+		return;
+	if(tasks->clients != NULL)
+	{
+		_tasks_suspend(tasks);
+		panel_clients_release(tasks->clients);
+	}
+	/* the windows tracked may belong to another display */
+	for(i = 0; i < tasks->tasks_cnt; i++)
+		_task_delete(tasks->tasks[i]);
+	free(tasks->tasks);
+	tasks->tasks = NULL;
+	tasks->tasks_cnt = 0;
+	tasks->added = 0;
+	g_hash_table_remove_all(tasks->windows);
+	tasks->clients = clients;
+	tasks->atom = panel_clients_get_atoms(clients);
 	tasks->screen = gtk_widget_get_screen(widget);
 	tasks->display = gdk_screen_get_display(tasks->screen);
 	tasks->root = gdk_screen_get_root_window(tasks->screen);
-	events = gdk_window_get_events(tasks->root);
-	gdk_window_set_events(tasks->root, events | GDK_PROPERTY_CHANGE_MASK);
-	gdk_window_add_filter(tasks->root, _task_on_filter, tasks);
-	/* atoms */
-	for(i = 0; i < TASKS_ATOM_COUNT; i++)
-		tasks->atom[i] = gdk_x11_get_xatom_by_name_for_display(
-				tasks->display, _tasks_atom[i]);
-	_tasks_do(tasks);
+	_tasks_resume(tasks);
+}
+
+
+/* tasks_on_clients */
+static void _tasks_on_clients(void * data, PanelClientsEvent event,
+		Window window, PanelClientsAtom property)
+{
+	Tasks * tasks = data;
+	Task * task;
+# ifndef EMBEDDED
+	size_t i;
+# endif
+	unsigned int mask;
+
+	if(window == panel_clients_get_root(tasks->clients))
+	{
+		if(property == PANEL_CLIENTS_ATOM__NET_CLIENT_LIST)
+		{
+			/* the changes to the list are complete */
+			_do_tasks_clean(tasks);
+			_tasks_refresh(tasks, &tasks->tasks[tasks->tasks_cnt
+					- tasks->added], tasks->added,
+					TASK_PROPERTY_ALL);
+			tasks->added = 0;
+		}
+# ifndef EMBEDDED
+		else if(property == PANEL_CLIENTS_ATOM__NET_CURRENT_DESKTOP)
+		{
+			tasks->desktop = panel_clients_get_current_desktop(
+					tasks->clients);
+			/* the desktop of every task is known already */
+			for(i = 0; i < tasks->tasks_cnt; i++)
+				_task_show(tasks->tasks[i]);
+		}
+# endif
+		return;
+	}
+	if(event == PANEL_CLIENTS_EVENT_ADDED)
+	{
+		if(_tasks_lookup(tasks, window) == NULL)
+			_do_tasks_add(tasks, window);
+		return;
+	}
+	if((task = _tasks_lookup(tasks, window)) == NULL)
+		return;
+	if(event == PANEL_CLIENTS_EVENT_REMOVED)
+	{
+		/* removed along with the change to the list */
+		task->delete = TRUE;
+		return;
+	}
+	switch(property)
+	{
+		case PANEL_CLIENTS_ATOM__NET_WM_NAME:
+			mask = TASK_PROPERTY_NAME;
+			break;
+		case PANEL_CLIENTS_ATOM__NET_WM_ICON:
+			mask = TASK_PROPERTY_ICON;
+			break;
+		case PANEL_CLIENTS_ATOM__NET_WM_DESKTOP:
+			mask = TASK_PROPERTY_DESKTOP;
+			break;
+		case PANEL_CLIENTS_ATOM__NET_WM_STATE:
+			mask = TASK_PROPERTY_STATE;
+			break;
+		case PANEL_CLIENTS_ATOM__NET_WM_WINDOW_TYPE:
+			mask = TASK_PROPERTY_TYPE;
+			break;
+		default:
+			return;
+	}
+	_tasks_refresh(tasks, &task, 1, mask);
 }
 #endif
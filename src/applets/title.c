@@ -1,5 +1,5 @@
 /* $Id$ */
-/* Copyright (c) 2011-2024 Pierre Pronchery <khorben@defora.org> */
+/* Copyright (c) 2011-2026 Pierre Pronchery <khorben@defora.org> */
 /* This file is part of DeforaOS Desktop Panel */
 /* This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -21,12 +21,11 @@
 #include <errno.h>
 #include <libintl.h>
 #include <gtk/gtk.h>
-#if defined(GDK_WINDOWING_X11)
-# include <gdk/gdkx.h>
-# include <X11/Xatom.h>
-#endif
 #include <System.h>
 #include "Panel/applet.h"
+#if defined(GDK_WINDOWING_X11)
+# include "Panel/clients.h"
+#endif
 
 #define _(string) gettext(string)
 #define N_(string) string
@@ -42,14 +41,8 @@ typedef struct _PanelApplet
 	GtkWidget * widget;
 	gulong source;
 
-	GdkDisplay * display;
-	GdkScreen * screen;
-	GdkWindow * root;
-
-	Atom atom_active;
-	Atom atom_name;
-	Atom atom_utf8_string;
-	Atom atom_visible_name;
+	PanelClients * clients;
+	gboolean subscribed;
 #endif
 } Title;
 
@@ -58,18 +51,16 @@ typedef struct _PanelApplet
 /* title */
 static Title * _title_init(PanelAppletHelper * helper, GtkWidget ** widget);
 static void _title_destroy(Title * title);
+static void _title_resume(Title * title);
+static void _title_suspend(Title * title);
 
 #if defined(GDK_WINDOWING_X11)
-/* accessors */
-static int _title_get_text_property(Title * title, Window window, Atom property,
-		char ** ret);
-
 /* useful */
 static void _title_do(Title * title);
 
 /* callbacks */
-static GdkFilterReturn _title_on_filter(GdkXEvent * xevent, GdkEvent * event,
-		gpointer data);
+static void _title_on_clients(void * data, PanelClientsEvent event,
+		Window window, PanelClientsAtom property);
 static void _title_on_screen_changed(GtkWidget * widget, GdkScreen * previous,
 		gpointer data);
 #endif
@@ -86,7 +77,9 @@ PanelAppletDefinition applet =
 	_title_destroy,
 	NULL,
 	FALSE,
-	TRUE
+	TRUE,
+	_title_suspend,
+	_title_resume
 };
 
 
@@ -116,12 +109,8 @@ static Title * _title_init(PanelAppletHelper * helper, GtkWidget ** widget)
 	pango_font_description_free(bold);
 	title->source = g_signal_connect(title->widget, "screen-changed",
 			G_CALLBACK(_title_on_screen_changed), title);
-	title->display = NULL;
-	title->screen = NULL;
-	title->root = NULL;
-	title->atom_active = 0;
-	title->atom_name = 0;
-	title->atom_visible_name = 0;
+	title->clients = NULL;
+	title->subscribed = FALSE;
 	gtk_widget_show(title->widget);
 	*widget = title->widget;
 	return title;
@@ -142,8 +131,11 @@ static void _title_destroy(Title * title)
 	if(title->source != 0)
 		g_signal_handler_disconnect(title->widget, title->source);
 	title->source = 0;
-	if(title->root != NULL)
-		gdk_window_remove_filter(title->root, _title_on_filter, title);
+	if(title->clients != NULL)
+	{
+		_title_suspend(title);
+		panel_clients_release(title->clients);
+	}
 	gtk_widget_destroy(title->widget);
 	free(title);
 #else
@@ -152,164 +144,75 @@ static void _title_destroy(Title * title)
 }
 
 
-#if defined(GDK_WINDOWING_X11)
-/* accessors */
-/* title_get_window_property */
-static int _title_get_window_property(Title * title, Window window,
-		Atom property, Atom atom, unsigned long * cnt,
-		unsigned char ** ret)
+/* title_resume */
+static void _title_resume(Title * title)
 {
-	int res;
-	Atom type;
-	int format;
-	unsigned long bytes;
-
-# ifdef DEBUG
-	fprintf(stderr, "DEBUG: %s(title, window, %lu, %lu)\n", __func__,
-			property, atom);
-# endif
-	gdk_error_trap_push();
-	res = XGetWindowProperty(GDK_DISPLAY_XDISPLAY(title->display), window,
-			property, 0, G_MAXLONG, False, atom, &type, &format,
-			cnt, &bytes, ret);
-	if(gdk_error_trap_pop() != 0 || res != Success)
-		return 1;
-	if(type != atom)
-	{
-		if(*ret != NULL)
-			XFree(*ret);
-		*ret = NULL;
-		return 1;
-	}
-	return 0;
+#if defined(GDK_WINDOWING_X11)
+	if(title->clients == NULL || title->subscribed)
+		return;
+	/* track the changes again, and catch up with them */
+	if(panel_clients_subscribe(title->clients, title->helper->window,
+				_title_on_clients, title) != 0)
+		return;
+	title->subscribed = TRUE;
+	_title_do(title);
+#else
+	(void) title;
+#endif
 }
 
 
-/* title_get_text_property */
-static int _title_get_text_property(Title * title, Window window, Atom property,
-		char ** ret)
+/* title_suspend */
+static void _title_suspend(Title * title)
 {
-	int res;
-	XTextProperty text;
-	GdkAtom atom;
-	int cnt;
-	char ** list;
-	int i;
-
-# ifdef DEBUG
-	fprintf(stderr, "DEBUG: %s(title, window, %lu)\n", __func__, property);
-# endif
-	gdk_error_trap_push();
-	res = XGetTextProperty(GDK_DISPLAY_XDISPLAY(title->display), window,
-			&text, property);
-	if(gdk_error_trap_pop() != 0 || res == 0)
-		return 1;
-	atom = gdk_x11_xatom_to_atom(text.encoding);
-# if GTK_CHECK_VERSION(2, 24, 0)
-	cnt = gdk_x11_display_text_property_to_text_list(title->display,
-			atom, text.format, text.value, text.nitems, &list);
-# else
-	cnt = gdk_text_property_to_utf8_list(atom, text.format, text.value,
-			text.nitems, &list);
-# endif
-	if(cnt > 0)
-	{
-		*ret = list[0];
-		for(i = 1; i < cnt; i++)
-			g_free(list[i]);
-		g_free(list);
-	}
-	else
-		*ret = NULL;
-	if(text.value != NULL)
-		XFree(text.value);
-	return 0;
+#if defined(GDK_WINDOWING_X11)
+	if(title->clients != NULL && title->subscribed)
+		panel_clients_unsubscribe(title->clients, _title_on_clients,
+				title);
+	title->subscribed = FALSE;
+#else
+	(void) title;
+#endif
 }
 
 
+#if defined(GDK_WINDOWING_X11)
+/* useful */
 /* title_do */
-static char * _do_name(Title * title, Window window);
-static char * _do_name_text(Title * title, Window window, Atom property);
-static char * _do_name_utf8(Title * title, Window window, Atom property);
-
 static void _title_do(Title * title)
 {
-	unsigned long cnt = 0;
-	Window * window;
-	char * name;
+	Window window;
+	char const * name = NULL;
 
 # ifdef DEBUG
 	fprintf(stderr, "DEBUG: %s()\n", __func__);
 # endif
-	if(_title_get_window_property(title, GDK_WINDOW_XID(title->root),
-				title->atom_active, XA_WINDOW, &cnt,
-				(void*)&window) != 0 || cnt != 1)
+	if((window = panel_clients_get_active(title->clients)) == None)
 	{
 		gtk_label_set_text(GTK_LABEL(title->widget), "");
 		return;
 	}
-	name = _do_name(title, *window);
-	XFree(window);
+	name = panel_clients_get_name(title->clients, window);
 	gtk_label_set_text(GTK_LABEL(title->widget), (name != NULL)
-			? name : "");
-	free(name);
-}
-
-static char * _do_name(Title * title, Window window)
-{
-	char * ret;
-
-	if((ret = _do_name_utf8(title, window, title->atom_visible_name))
-			!= NULL)
-		return ret;
-	if((ret = _do_name_utf8(title, window, title->atom_name)) != NULL)
-		return ret;
-	if((ret = _do_name_text(title, window, XA_WM_NAME)) != NULL)
-		return ret;
-	return g_strdup(_("(Untitled)"));
-}
-
-static char * _do_name_text(Title * title, Window window, Atom property)
-{
-	char * ret = NULL;
-
-	if(_title_get_text_property(title, window, property, (void*)&ret) != 0)
-		return NULL;
-	return ret;
-}
-
-static char * _do_name_utf8(Title * title, Window window, Atom property)
-{
-	char * ret = NULL;
-	char * str = NULL;
-	unsigned long cnt = 0;
-
-	if(_title_get_window_property(title, window, property,
-				title->atom_utf8_string, &cnt, (void*)&str)
-			!= 0)
-		return NULL;
-	if(g_utf8_validate(str, cnt, NULL))
-		ret = g_strndup(str, cnt);
-	XFree(str);
-	return ret;
+			? name : _("(Untitled)"));
 }
 
 
 /* callbacks */
-/* title_on_filter */
-static GdkFilterReturn _title_on_filter(GdkXEvent * xevent, GdkEvent * event,
-		gpointer data)
+/* title_on_clients */
+static void _title_on_clients(void * data, PanelClientsEvent event,
+		Window window, PanelClientsAtom property)
 {
 	Title * title = data;
-	XEvent * xev = xevent;
-	(void) event;
 
-	if(xev->type != PropertyNotify)
-		return GDK_FILTER_CONTINUE;
-	if(xev->xproperty.atom != title->atom_active)
-		return GDK_FILTER_CONTINUE;
-	_title_do(title);
-	return GDK_FILTER_CONTINUE;
+	if(event != PANEL_CLIENTS_EVENT_CHANGED)
+		return;
+	/* the active window, or its name */
+	if(property == PANEL_CLIENTS_ATOM__NET_ACTIVE_WINDOW
+			|| (property == PANEL_CLIENTS_ATOM__NET_WM_NAME
+				&& window == panel_clients_get_active(
+					title->clients)))
+		_title_do(title);
 }
 
 
@@ -318,29 +221,21 @@ static void _title_on_screen_changed(GtkWidget * widget, GdkScreen * previous,
 		gpointer data)
 {
 	Title * title = data;
-	GdkEventMask events;
+	PanelClients * clients;
 	(void) previous;
 
 # ifdef DEBUG
 	fprintf(stderr, "DEBUG: %s()\n", __func__);
 # endif
-	if(title->root != NULL)
-		gdk_window_remove_filter(title->root, _title_on_filter, title);
-	title->screen = gtk_widget_get_screen(widget);
-	title->display = gdk_screen_get_display(title->screen);
-	title->root = gdk_screen_get_root_window(title->screen);
-	events = gdk_window_get_events(title->root);
-	gdk_window_set_events(title->root, events
-			| GDK_PROPERTY_CHANGE_MASK);
-	gdk_window_add_filter(title->root, _title_on_filter, title);
-	title->atom_active = gdk_x11_get_xatom_by_name_for_display(
-			title->display, "_NET_ACTIVE_WINDOW");
-	title->atom_name = gdk_x11_get_xatom_by_name_for_display(
-			title->display, "_NET_WM_NAME");
-	title->atom_utf8_string = gdk_x11_get_xatom_by_name_for_display(
-			title->display, "UTF8_STRING");
-	title->atom_visible_name = gdk_x11_get_xatom_by_name_for_display(
-			title->display, "_NET_WM_VISIBLE_NAME");
-	_title_do(title);
+	if((clients = panel_clients_acquire(gtk_widget_get_screen(widget)))
+			== NULL)
+		return;
+	if(title->clients != NULL)
+	{
+		_title_suspend(title);
+		panel_clients_release(title->clients);
+	}
+	title->clients = clients;
+	_title_resume(title);
 }
 #endif
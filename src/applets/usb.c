@@ -101,7 +101,8 @@ static USB * _usb_init(PanelAppletHelper * helper, GtkWidget ** widget)
 		gtk_widget_set_tooltip_text(usb->image, tooltip);
 #endif
 	usb->timeout = (_usb_on_timeout(usb) == TRUE)
-		? g_timeout_add(timeout, _usb_on_timeout, usb) : 0;
+		? helper->timeout_add(helper->panel, timeout, _usb_on_timeout,
+				usb) : 0;
 	gtk_widget_set_no_show_all(usb->image, TRUE);
 	*widget = usb->image;
 	return usb;
@@ -112,7 +113,7 @@ static USB * _usb_init(PanelAppletHelper * helper, GtkWidget ** widget)
 static void _usb_destroy(USB * usb)
 {
 	if(usb->timeout > 0)
-		g_source_remove(usb->timeout);
+		usb->helper->timeout_remove(usb->helper->panel, usb->timeout);
 #if defined(__NetBSD__) || defined(__linux__)
 	if(usb->fd >= 0)
 		close(usb->fd);
@@ -1,5 +1,5 @@
 /* $Id$ */
-/* Copyright (c) 2011-2024 Pierre Pronchery <khorben@defora.org> */
+/* Copyright (c) 2011-2026 Pierre Pronchery <khorben@defora.org> */
 /* This file is part of DeforaOS Desktop Panel */
 /* This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -155,6 +155,7 @@ typedef struct _PanelApplet
 	PanelAppletHelper * helper;
 
 	guint source;
+	gboolean suspended;
 	WPAChannel channel[2];
 
 	/* configuration */
@@ -188,6 +189,8 @@ typedef struct _PanelApplet
 /* plug-in */
 static WPA * _wpa_init(PanelAppletHelper * helper, GtkWidget ** widget);
 static void _wpa_destroy(WPA * wpa);
+static void _wpa_resume(WPA * wpa);
+static void _wpa_suspend(WPA * wpa);
 
 /* accessors */
 static GdkPixbuf * _wpa_get_icon(WPA * wpa, gint size, guint level,
@@ -221,6 +224,7 @@ static void _wpa_stop(WPA * wpa);
 /* callbacks */
 static void _on_clicked(gpointer data);
 static gboolean _on_timeout(gpointer data);
+static gboolean _start_timeout(gpointer data);
 static gboolean _on_watch_can_read(GIOChannel * source, GIOCondition condition,
 		gpointer data);
 static gboolean _on_watch_can_write(GIOChannel * source, GIOCondition condition,
@@ -238,7 +242,9 @@ PanelAppletDefinition applet =
 	_wpa_destroy,
 	NULL,
 	FALSE,
-	TRUE
+	TRUE,
+	_wpa_suspend,
+	_wpa_resume
 };
 
 
@@ -258,6 +264,7 @@ static WPA * _wpa_init(PanelAppletHelper * helper, GtkWidget ** widget)
 		return NULL;
 	wpa->helper = helper;
 	wpa->source = 0;
+	wpa->suspended = FALSE;
 	_init_channel(&wpa->channel[0]);
 	_init_channel(&wpa->channel[1]);
 	wpa->networks = NULL;
@@ -344,6 +351,43 @@ static void _wpa_destroy(WPA * wpa)
 }
 
 
+/* wpa_resume */
+static void _wpa_resume(WPA * wpa)
+{
+	const unsigned int timeout = 5000;
+
+#ifdef DEBUG
+	fprintf(stderr, "DEBUG: %s()\n", __func__);
+#endif
+	wpa->suspended = FALSE;
+	if(wpa->source != 0)
+		return;
+	if(wpa->channel[0].channel == NULL)
+	{
+		/* reconnect to the daemon */
+		wpa->source = g_idle_add(_start_timeout, wpa);
+		return;
+	}
+	/* catch up with the current status */
+	_on_timeout(wpa);
+	wpa->source = g_timeout_add(timeout, _on_timeout, wpa);
+}
+
+
+/* wpa_suspend */
+static void _wpa_suspend(WPA * wpa)
+{
+#ifdef DEBUG
+	fprintf(stderr, "DEBUG: %s()\n", __func__);
+#endif
+	/* stop polling, but keep listening to events */
+	wpa->suspended = TRUE;
+	if(wpa->source != 0)
+		g_source_remove(wpa->source);
+	wpa->source = 0;
+}
+
+
 /* accessors */
 /* wpa_get_icon */
 static GdkPixbuf * _wpa_get_icon(WPA * wpa, gint size, guint level,
@@ -918,7 +962,6 @@ static int _wpa_reset(WPA * wpa)
 
 
 /* wpa_start */
-static gboolean _start_timeout(gpointer data);
 static int _timeout_channel(WPA * wpa, WPAChannel * channel);
 static int _timeout_channel_interface(WPA * wpa, WPAChannel * channel,
 		char const * path, char const * interface);
@@ -942,6 +985,12 @@ static gboolean _start_timeout(gpointer data)
 #ifdef DEBUG
 	fprintf(stderr, "DEBUG: %s()\n", __func__);
 #endif
+	if(wpa->suspended)
+	{
+		/* connect again once resumed */
+		wpa->source = 0;
+		return FALSE;
+	}
 	if(_timeout_channel(wpa, &wpa->channel[0]) != 0
 			|| _timeout_channel(wpa, &wpa->channel[1]) != 0)
 	{
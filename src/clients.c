@@ -0,0 +1,1112 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Panel */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#include <System.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#ifdef DEBUG
+# include <stdio.h>
+#endif
+#include <gtk/gtk.h>
+#if defined(GDK_WINDOWING_X11)
+# if GTK_CHECK_VERSION(3, 0, 0)
+#  include <gtk/gtkx.h>
+# else
+#  include <gdk/gdkx.h>
+# endif
+# include <X11/Xatom.h>
+#endif
+#include "../include/Panel/clients.h"
+#include "../include/Panel/properties.h"
+#include "window.h"
+
+#if !GTK_CHECK_VERSION(3, 0, 0)
+# define gdk_error_trap_pop_ignored() gdk_error_trap_pop()
+#endif
+
+
+/* PanelClients */
+/* private */
+/* types */
+typedef enum _PanelClientsScreen
+{
+	PANEL_CLIENTS_SCREEN_ACTIVE		= 0x01,
+	PANEL_CLIENTS_SCREEN_CLIENT_LIST	= 0x02,
+	PANEL_CLIENTS_SCREEN_CURRENT_DESKTOP	= 0x04,
+	PANEL_CLIENTS_SCREEN_DESKTOP_NAMES	= 0x08,
+	PANEL_CLIENTS_SCREEN_NUMBER_OF_DESKTOPS	= 0x10
+} PanelClientsScreen;
+#define PANEL_CLIENTS_SCREEN_ALL	0x1f
+
+typedef enum _PanelClientsProperty
+{
+	PANEL_CLIENTS_PROPERTY_DESKTOP	= 0x01,
+	PANEL_CLIENTS_PROPERTY_NAME	= 0x02,
+	PANEL_CLIENTS_PROPERTY_STATE	= 0x04,
+	PANEL_CLIENTS_PROPERTY_TYPE	= 0x08
+} PanelClientsProperty;
+#define PANEL_CLIENTS_PROPERTY_ALL	0x0f
+
+typedef enum _PanelClientsRequest
+{
+	PANEL_CLIENTS_REQUEST_DESKTOP = 0,
+	PANEL_CLIENTS_REQUEST_STATE,
+	PANEL_CLIENTS_REQUEST_TYPE,
+	PANEL_CLIENTS_REQUEST_VISIBLE_NAME,
+	PANEL_CLIENTS_REQUEST_NAME,
+	PANEL_CLIENTS_REQUEST_WM_NAME
+} PanelClientsRequest;
+#define PANEL_CLIENTS_REQUEST_LAST	PANEL_CLIENTS_REQUEST_WM_NAME
+#define PANEL_CLIENTS_REQUEST_COUNT	(PANEL_CLIENTS_REQUEST_LAST + 1)
+
+typedef struct _PanelClientsWindow
+{
+	Window window;
+	unsigned int dirty;		/* to be fetched again		*/
+	unsigned int changed;		/* to be notified		*/
+	gboolean added;
+	gboolean listed;
+	int index[PANEL_CLIENTS_REQUEST_COUNT];
+
+	/* cached properties */
+	int desktop;
+	char * name;
+	Atom * state;
+	size_t state_cnt;
+	Atom type;
+} PanelClientsWindow;
+
+typedef struct _PanelClientsSubscriber
+{
+	PanelWindow * window;		/* accounts for the applet	*/
+	PanelClientsCallback callback;	/* NULL once unsubscribed	*/
+	void * data;
+} PanelClientsSubscriber;
+
+struct _PanelClients
+{
+	unsigned int refcount;
+	GdkScreen * screen;
+	GdkDisplay * display;
+	GdkWindow * root;
+	Atom atoms[PANEL_CLIENTS_ATOM_COUNT];
+
+	/* screen */
+	unsigned int dirty;
+	Window active;
+	Window * list;
+	size_t list_cnt;
+	int desktop;
+	unsigned int desktops;
+	char ** names;
+	size_t names_cnt;
+
+	/* windows */
+	GHashTable * windows;		/* Window to PanelClientsWindow	*/
+
+	PanelClientsSubscriber * subscribers;
+	size_t subscribers_cnt;
+	gboolean notifying;
+	guint source;
+};
+
+
+/* constants */
+static const char * _panel_clients_atom[PANEL_CLIENTS_ATOM_COUNT] =
+{
+	"_NET_ACTIVE_WINDOW",
+	"_NET_CLIENT_LIST",
+	"_NET_CLOSE_WINDOW",
+	"_NET_CURRENT_DESKTOP",
+	"_NET_DESKTOP_NAMES",
+	"_NET_NUMBER_OF_DESKTOPS",
+	"_NET_WM_ACTION_CHANGE_DESKTOP",
+	"_NET_WM_ACTION_CLOSE",
+	"_NET_WM_ACTION_MOVE",
+	"_NET_WM_ACTION_RESIZE",
+	"_NET_WM_ACTION_MINIMIZE",
+	"_NET_WM_ACTION_SHADE",
+	"_NET_WM_ACTION_STICK",
+	"_NET_WM_ACTION_MAXIMIZE_HORZ",
+	"_NET_WM_ACTION_MAXIMIZE_VERT",
+	"_NET_WM_ACTION_FULLSCREEN",
+	"_NET_WM_ALLOWED_ACTIONS",
+	"_NET_WM_DESKTOP",
+	"_NET_WM_ICON",
+	"_NET_WM_MOVERESIZE",
+	"_NET_WM_NAME",
+	"_NET_WM_STATE",
+	"_NET_WM_STATE_FULLSCREEN",
+	"_NET_WM_STATE_MAXIMIZED_HORZ",
+	"_NET_WM_STATE_MAXIMIZED_VERT",
+	"_NET_WM_STATE_SHADED",
+	"_NET_WM_STATE_SKIP_TASKBAR",
+	"_NET_WM_STATE_STICKY",
+	"_NET_WM_STATE_TOGGLE",
+	"_NET_WM_VISIBLE_NAME",
+	"_NET_WM_WINDOW_TYPE",
+	"_NET_WM_WINDOW_TYPE_NORMAL",
+	"UTF8_STRING",
+	"WM_NAME"
+};
+
+
+/* variables */
+/* one model per screen */
+static PanelClients ** _clients = NULL;
+static size_t _clients_cnt = 0;
+
+
+/* prototypes */
+static void _panel_clients_notify(PanelClients * clients,
+		PanelClientsEvent event, Window window,
+		PanelClientsAtom property);
+static void _panel_clients_refresh(PanelClients * clients);
+static void _panel_clients_schedule(PanelClients * clients);
+static void _panel_clients_start(PanelClients * clients);
+static void _panel_clients_stop(PanelClients * clients);
+
+static PanelClientsWindow * _panel_clients_window_new(PanelClients * clients,
+		Window window);
+static void _panel_clients_window_delete(PanelClientsWindow * window);
+
+/* callbacks */
+#if defined(GDK_WINDOWING_X11)
+static GdkFilterReturn _panel_clients_on_filter(GdkXEvent * xevent,
+		GdkEvent * event, gpointer data);
+#endif
+static gboolean _panel_clients_on_idle(gpointer data);
+
+
+/* public */
+/* functions */
+/* panel_clients_acquire */
+PanelClients * panel_clients_acquire(GdkScreen * screen)
+{
+#if defined(GDK_WINDOWING_X11)
+	PanelClients ** p;
+	PanelClients * clients;
+	size_t i;
+
+	for(i = 0; i < _clients_cnt; i++)
+		if(_clients[i]->screen == screen)
+		{
+			_clients[i]->refcount++;
+			return _clients[i];
+		}
+# if GTK_CHECK_VERSION(3, 0, 0)
+	if(!GDK_IS_X11_DISPLAY(gdk_screen_get_display(screen)))
+	{
+		error_set_code(-ENOSYS, "%s", "X11 support not detected");
+		return NULL;
+	}
+# endif
+	if((p = realloc(_clients, sizeof(*p) * (_clients_cnt + 1))) == NULL)
+	{
+		error_set_code(1, "%s", strerror(errno));
+		return NULL;
+	}
+	_clients = p;
+	if((clients = object_new(sizeof(*clients))) == NULL)
+		return NULL;
+	clients->refcount = 1;
+	clients->screen = screen;
+	clients->display = gdk_screen_get_display(screen);
+	clients->root = gdk_screen_get_root_window(screen);
+	/* intern every atom in a single round-trip */
+	if(XInternAtoms(GDK_DISPLAY_XDISPLAY(clients->display),
+				(char **)_panel_clients_atom,
+				PANEL_CLIENTS_ATOM_COUNT, False,
+				clients->atoms) == 0)
+	{
+		object_delete(clients);
+		error_set_code(1, "%s", "Could not intern the atoms");
+		return NULL;
+	}
+	clients->dirty = PANEL_CLIENTS_SCREEN_ALL;
+	clients->active = None;
+	clients->list = NULL;
+	clients->list_cnt = 0;
+	clients->desktop = -1;
+	clients->desktops = 0;
+	clients->names = NULL;
+	clients->names_cnt = 0;
+	clients->windows = g_hash_table_new(g_direct_hash, g_direct_equal);
+	clients->subscribers = NULL;
+	clients->subscribers_cnt = 0;
+	clients->notifying = FALSE;
+	clients->source = 0;
+	_clients[_clients_cnt++] = clients;
+	return clients;
+#else
+	(void) screen;
+
+	error_set_code(-ENOSYS, "%s", "X11 support not detected");
+	return NULL;
+#endif
+}
+
+
+/* panel_clients_release */
+void panel_clients_release(PanelClients * clients)
+{
+	size_t i;
+	GHashTableIter iter;
+	gpointer value;
+
+	for(i = 0; i < _clients_cnt; i++)
+		if(_clients[i] == clients)
+			break;
+	if(i == _clients_cnt || --clients->refcount > 0)
+		return;
+	memmove(&_clients[i], &_clients[i + 1],
+			sizeof(*_clients) * (--_clients_cnt - i));
+	if(clients->subscribers_cnt > 0)
+		_panel_clients_stop(clients);
+	g_hash_table_iter_init(&iter, clients->windows);
+	while(g_hash_table_iter_next(&iter, NULL, &value))
+		_panel_clients_window_delete(value);
+	g_hash_table_destroy(clients->windows);
+	free(clients->subscribers);
+	for(i = 0; i < clients->names_cnt; i++)
+		g_free(clients->names[i]);
+	free(clients->names);
+	free(clients->list);
+	object_delete(clients);
+	if(_clients_cnt == 0)
+	{
+		free(_clients);
+		_clients = NULL;
+	}
+}
+
+
+/* accessors */
+/* panel_clients_get_active */
+Window panel_clients_get_active(PanelClients * clients)
+{
+	return clients->active;
+}
+
+
+/* panel_clients_get_atoms */
+Atom const * panel_clients_get_atoms(PanelClients * clients)
+{
+	return clients->atoms;
+}
+
+
+/* panel_clients_get_clients */
+Window const * panel_clients_get_clients(PanelClients * clients,
+		size_t * cnt)
+{
+	*cnt = clients->list_cnt;
+	return clients->list;
+}
+
+
+/* panel_clients_get_current_desktop */
+int panel_clients_get_current_desktop(PanelClients * clients)
+{
+	return clients->desktop;
+}
+
+
+/* panel_clients_get_desktop */
+int panel_clients_get_desktop(PanelClients * clients, Window window)
+{
+	PanelClientsWindow * w;
+
+	if((w = g_hash_table_lookup(clients->windows,
+					GSIZE_TO_POINTER(window))) == NULL)
+		return -1;
+	return w->desktop;
+}
+
+
+/* panel_clients_get_desktop_name */
+char const * panel_clients_get_desktop_name(PanelClients * clients,
+		unsigned int desktop)
+{
+	return (desktop < clients->names_cnt) ? clients->names[desktop] : NULL;
+}
+
+
+/* panel_clients_get_desktops */
+unsigned int panel_clients_get_desktops(PanelClients * clients)
+{
+	return clients->desktops;
+}
+
+
+/* panel_clients_get_display */
+GdkDisplay * panel_clients_get_display(PanelClients * clients)
+{
+	return clients->display;
+}
+
+
+/* panel_clients_get_name */
+char const * panel_clients_get_name(PanelClients * clients, Window window)
+{
+	PanelClientsWindow * w;
+
+	if((w = g_hash_table_lookup(clients->windows,
+					GSIZE_TO_POINTER(window))) == NULL)
+		return NULL;
+	return w->name;
+}
+
+
+/* panel_clients_get_root */
+Window panel_clients_get_root(PanelClients * clients)
+{
+#if defined(GDK_WINDOWING_X11)
+	return GDK_WINDOW_XID(clients->root);
+#else
+	(void) clients;
+
+	return None;
+#endif
+}
+
+
+/* panel_clients_get_state */
+gboolean panel_clients_get_state(PanelClients * clients, Window window,
+		PanelClientsAtom state)
+{
+	PanelClientsWindow * w;
+	size_t i;
+
+	if((w = g_hash_table_lookup(clients->windows,
+					GSIZE_TO_POINTER(window))) == NULL)
+		return FALSE;
+	for(i = 0; i < w->state_cnt; i++)
+		if(w->state[i] == clients->atoms[state])
+			return TRUE;
+	return FALSE;
+}
+
+
+/* panel_clients_get_typehint_normal */
+gboolean panel_clients_get_typehint_normal(PanelClients * clients,
+		Window window)
+{
+	PanelClientsWindow * w;
+
+	if((w = g_hash_table_lookup(clients->windows,
+					GSIZE_TO_POINTER(window))) == NULL)
+		return FALSE;
+	/* FIXME return FALSE if WM_TRANSIENT_FOR is set */
+	return (w->type == None || w->type == clients->atoms[
+			PANEL_CLIENTS_ATOM__NET_WM_WINDOW_TYPE_NORMAL])
+		? TRUE : FALSE;
+}
+
+
+/* useful */
+/* panel_clients_subscribe */
+int panel_clients_subscribe(PanelClients * clients, PanelWindow * window,
+		PanelClientsCallback callback, void * data)
+{
+	PanelClientsSubscriber * p;
+
+	if((p = realloc(clients->subscribers, sizeof(*p)
+					* (clients->subscribers_cnt + 1)))
+			== NULL)
+		return -error_set_code(1, "%s", strerror(errno));
+	clients->subscribers = p;
+	/* catch up with the changes missed so far */
+	if(clients->subscribers_cnt == 0)
+		_panel_clients_start(clients);
+	p = &clients->subscribers[clients->subscribers_cnt++];
+	p->window = window;
+	p->callback = callback;
+	p->data = data;
+	return 0;
+}
+
+
+/* panel_clients_unsubscribe */
+void panel_clients_unsubscribe(PanelClients * clients,
+		PanelClientsCallback callback, void * data)
+{
+	size_t i;
+
+	for(i = 0; i < clients->subscribers_cnt; i++)
+	{
+		if(clients->subscribers[i].callback != callback
+				|| clients->subscribers[i].data != data)
+			continue;
+		if(clients->notifying)
+		{
+			/* removed once the notifications are done */
+			clients->subscribers[i].callback = NULL;
+			return;
+		}
+		memmove(&clients->subscribers[i], &clients->subscribers[i + 1],
+				sizeof(*clients->subscribers)
+				* (--clients->subscribers_cnt - i));
+		/* stop tracking the changes with the last subscriber */
+		if(clients->subscribers_cnt == 0)
+			_panel_clients_stop(clients);
+		return;
+	}
+}
+
+
+/* private */
+/* functions */
+/* panel_clients_notify */
+static void _panel_clients_notify(PanelClients * clients,
+		PanelClientsEvent event, Window window,
+		PanelClientsAtom property)
+{
+	gboolean notifying = clients->notifying;
+	size_t i;
+	size_t cnt;
+	PanelClientsSubscriber s;
+	PanelUsage * usage;
+	PanelUsageCall call;
+
+	clients->notifying = TRUE;
+	/* the callbacks may subscribe more */
+	for(i = 0; i < clients->subscribers_cnt; i++)
+	{
+		if((s = clients->subscribers[i]).callback == NULL)
+			continue;
+		/* account for the time spent per applet */
+		usage = (s.window != NULL) ? panel_window_get_usage(s.window)
+			: NULL;
+		if(usage != NULL)
+			panel_usage_begin(&call);
+		s.callback(s.data, event, window, property);
+		if(usage != NULL)
+			panel_usage_end(usage, s.data, "clients", &call);
+	}
+	if((clients->notifying = notifying) == TRUE)
+		return;
+	for(i = 0, cnt = 0; i < clients->subscribers_cnt; i++)
+		if(clients->subscribers[i].callback != NULL)
+			clients->subscribers[cnt++] = clients->subscribers[i];
+	if(cnt == clients->subscribers_cnt)
+		return;
+	clients->subscribers_cnt = cnt;
+	if(cnt == 0)
+		_panel_clients_stop(clients);
+}
+
+
+/* panel_clients_refresh */
+static void _refresh_screen_request(PanelClients * clients,
+		PanelProperties * properties, int * index);
+static unsigned int _refresh_screen(PanelClients * clients,
+		PanelProperties * properties, int const * index);
+static void _refresh_screen_names(PanelClients * clients,
+		PanelProperties * properties, int index);
+static void _refresh_list(PanelClients * clients,
+		PanelProperties * properties, PanelClientsWindow *** removed,
+		size_t * removed_cnt);
+static void _refresh_window_request(PanelClients * clients,
+		PanelProperties * properties, PanelClientsWindow * window);
+static void _refresh_window(PanelClients * clients,
+		PanelProperties * properties, PanelClientsWindow * window);
+static void _refresh_window_notify(PanelClients * clients,
+		PanelClientsWindow * window);
+
+static void _panel_clients_refresh(PanelClients * clients)
+{
+	PanelProperties * properties;
+	int index[5];
+	GHashTableIter iter;
+	gpointer value;
+	unsigned int changed;
+	PanelClientsWindow ** removed = NULL;
+	size_t removed_cnt = 0;
+	PanelClientsWindow * w;
+	size_t i;
+
+	if((properties = panel_properties_new(clients->display)) == NULL)
+		return;
+	/* request everything outdated at once */
+	_refresh_screen_request(clients, properties, index);
+	g_hash_table_iter_init(&iter, clients->windows);
+	while(g_hash_table_iter_next(&iter, NULL, &value))
+		_refresh_window_request(clients, properties, value);
+	changed = _refresh_screen(clients, properties, index);
+	/* the windows added are requested along */
+	if(changed & PANEL_CLIENTS_SCREEN_CLIENT_LIST)
+		_refresh_list(clients, properties, &removed, &removed_cnt);
+	g_hash_table_iter_init(&iter, clients->windows);
+	while(g_hash_table_iter_next(&iter, NULL, &value))
+		_refresh_window(clients, properties, value);
+	panel_properties_delete(properties);
+	/* notify the subscribers */
+	for(i = 0; i < removed_cnt; i++)
+	{
+		_panel_clients_notify(clients, PANEL_CLIENTS_EVENT_REMOVED,
+				removed[i]->window,
+				PANEL_CLIENTS_ATOM__NET_CLIENT_LIST);
+		_panel_clients_window_delete(removed[i]);
+	}
+	free(removed);
+	for(i = 0; i < clients->list_cnt; i++)
+		if((w = g_hash_table_lookup(clients->windows, GSIZE_TO_POINTER(
+							clients->list[i])))
+				!= NULL)
+			_refresh_window_notify(clients, w);
+	if(changed & PANEL_CLIENTS_SCREEN_ACTIVE)
+		_panel_clients_notify(clients, PANEL_CLIENTS_EVENT_CHANGED,
+				panel_clients_get_root(clients),
+				PANEL_CLIENTS_ATOM__NET_ACTIVE_WINDOW);
+	if(changed & PANEL_CLIENTS_SCREEN_NUMBER_OF_DESKTOPS)
+		_panel_clients_notify(clients, PANEL_CLIENTS_EVENT_CHANGED,
+				panel_clients_get_root(clients),
+				PANEL_CLIENTS_ATOM__NET_NUMBER_OF_DESKTOPS);
+	if(changed & PANEL_CLIENTS_SCREEN_DESKTOP_NAMES)
+		_panel_clients_notify(clients, PANEL_CLIENTS_EVENT_CHANGED,
+				panel_clients_get_root(clients),
+				PANEL_CLIENTS_ATOM__NET_DESKTOP_NAMES);
+	if(changed & PANEL_CLIENTS_SCREEN_CURRENT_DESKTOP)
+		_panel_clients_notify(clients, PANEL_CLIENTS_EVENT_CHANGED,
+				panel_clients_get_root(clients),
+				PANEL_CLIENTS_ATOM__NET_CURRENT_DESKTOP);
+	if(changed & PANEL_CLIENTS_SCREEN_CLIENT_LIST)
+		_panel_clients_notify(clients, PANEL_CLIENTS_EVENT_CHANGED,
+				panel_clients_get_root(clients),
+				PANEL_CLIENTS_ATOM__NET_CLIENT_LIST);
+}
+
+static void _refresh_screen_request(PanelClients * clients,
+		PanelProperties * properties, int * index)
+{
+	Window root;
+	size_t i;
+
+	root = panel_clients_get_root(clients);
+	for(i = 0; i < 5; i++)
+		index[i] = -1;
+	if(clients->dirty & PANEL_CLIENTS_SCREEN_ACTIVE)
+		index[0] = panel_properties_add(properties, root,
+				clients->atoms[
+				PANEL_CLIENTS_ATOM__NET_ACTIVE_WINDOW],
+				XA_WINDOW);
+	if(clients->dirty & PANEL_CLIENTS_SCREEN_CLIENT_LIST)
+		index[1] = panel_properties_add(properties, root,
+				clients->atoms[
+				PANEL_CLIENTS_ATOM__NET_CLIENT_LIST],
+				XA_WINDOW);
+	if(clients->dirty & PANEL_CLIENTS_SCREEN_CURRENT_DESKTOP)
+		index[2] = panel_properties_add(properties, root,
+				clients->atoms[
+				PANEL_CLIENTS_ATOM__NET_CURRENT_DESKTOP],
+				XA_CARDINAL);
+	if(clients->dirty & PANEL_CLIENTS_SCREEN_DESKTOP_NAMES)
+		index[3] = panel_properties_add(properties, root,
+				clients->atoms[
+				PANEL_CLIENTS_ATOM__NET_DESKTOP_NAMES],
+				clients->atoms[PANEL_CLIENTS_ATOM_UTF8_STRING]);
+	if(clients->dirty & PANEL_CLIENTS_SCREEN_NUMBER_OF_DESKTOPS)
+		index[4] = panel_properties_add(properties, root,
+				clients->atoms[
+				PANEL_CLIENTS_ATOM__NET_NUMBER_OF_DESKTOPS],
+				XA_CARDINAL);
+}
+
+static unsigned int _refresh_screen(PanelClients * clients,
+		PanelProperties * properties, int const * index)
+{
+	unsigned int ret = 0;
+	unsigned long cnt;
+	unsigned long * p;
+	Window active;
+	int desktop;
+	unsigned int desktops;
+	Window * list;
+
+	if(clients->dirty & PANEL_CLIENTS_SCREEN_ACTIVE)
+	{
+		active = (panel_properties_get(properties, index[0], &cnt,
+					(void *)&p) == 0 && cnt == 1)
+			? p[0] : None;
+		if(active != clients->active)
+			ret |= PANEL_CLIENTS_SCREEN_ACTIVE;
+		clients->active = active;
+	}
+	if(clients->dirty & PANEL_CLIENTS_SCREEN_CLIENT_LIST)
+	{
+		if(panel_properties_get(properties, index[1], &cnt, (void *)&p)
+				!= 0)
+			cnt = 0;
+		if(cnt != clients->list_cnt || (cnt > 0 && memcmp(p,
+						clients->list,
+						sizeof(*p) * cnt) != 0))
+		{
+			if(cnt == 0)
+			{
+				free(clients->list);
+				clients->list = NULL;
+				clients->list_cnt = 0;
+				ret |= PANEL_CLIENTS_SCREEN_CLIENT_LIST;
+			}
+			else if((list = realloc(clients->list, sizeof(*list)
+							* cnt)) != NULL)
+			{
+				memcpy(list, p, sizeof(*list) * cnt);
+				clients->list = list;
+				clients->list_cnt = cnt;
+				ret |= PANEL_CLIENTS_SCREEN_CLIENT_LIST;
+			}
+		}
+	}
+	if(clients->dirty & PANEL_CLIENTS_SCREEN_CURRENT_DESKTOP)
+	{
+		desktop = (panel_properties_get(properties, index[2], &cnt,
+					(void *)&p) == 0 && cnt == 1)
+			? (int)p[0] : -1;
+		if(desktop != clients->desktop)
+			ret |= PANEL_CLIENTS_SCREEN_CURRENT_DESKTOP;
+		clients->desktop = desktop;
+	}
+	if(clients->dirty & PANEL_CLIENTS_SCREEN_DESKTOP_NAMES)
+	{
+		_refresh_screen_names(clients, properties, index[3]);
+		ret |= PANEL_CLIENTS_SCREEN_DESKTOP_NAMES;
+	}
+	if(clients->dirty & PANEL_CLIENTS_SCREEN_NUMBER_OF_DESKTOPS)
+	{
+		desktops = (panel_properties_get(properties, index[4], &cnt,
+					(void *)&p) == 0 && cnt == 1)
+			? p[0] : 0;
+		if(desktops != clients->desktops)
+			ret |= PANEL_CLIENTS_SCREEN_NUMBER_OF_DESKTOPS;
+		clients->desktops = desktops;
+	}
+	clients->dirty = 0;
+	return ret;
+}
+
+static void _refresh_screen_names(PanelClients * clients,
+		PanelProperties * properties, int index)
+{
+	unsigned long cnt;
+	char * p;
+	unsigned long i;
+	unsigned long last = 0;
+	char ** q;
+
+	for(i = 0; i < clients->names_cnt; i++)
+		g_free(clients->names[i]);
+	free(clients->names);
+	clients->names = NULL;
+	clients->names_cnt = 0;
+	if(panel_properties_get(properties, index, &cnt, (void *)&p) != 0)
+		return;
+	/* the last name may not be terminated */
+	for(i = 0; i <= cnt; i++)
+	{
+		if(i < cnt && p[i] != '\0')
+			continue;
+		if(i == cnt && i == last)
+			break;
+		if((q = realloc(clients->names, sizeof(*q)
+						* (clients->names_cnt + 1)))
+				== NULL)
+			return;
+		clients->names = q;
+		clients->names[clients->names_cnt++] = g_utf8_validate(
+				&p[last], i - last, NULL)
+			? g_strndup(&p[last], i - last) : NULL;
+		last = i + 1;
+	}
+}
+
+static void _refresh_list(PanelClients * clients,
+		PanelProperties * properties, PanelClientsWindow *** removed,
+		size_t * removed_cnt)
+{
+	GHashTableIter iter;
+	gpointer value;
+	PanelClientsWindow * w;
+	PanelClientsWindow ** p;
+	size_t i;
+
+	g_hash_table_iter_init(&iter, clients->windows);
+	while(g_hash_table_iter_next(&iter, NULL, &value))
+		((PanelClientsWindow *)value)->listed = FALSE;
+	for(i = 0; i < clients->list_cnt; i++)
+	{
+		if((w = g_hash_table_lookup(clients->windows, GSIZE_TO_POINTER(
+							clients->list[i])))
+				!= NULL)
+		{
+			w->listed = TRUE;
+			continue;
+		}
+		if((w = _panel_clients_window_new(clients, clients->list[i]))
+				== NULL)
+			continue;
+		g_hash_table_insert(clients->windows,
+				GSIZE_TO_POINTER(w->window), w);
+		_refresh_window_request(clients, properties, w);
+	}
+	g_hash_table_iter_init(&iter, clients->windows);
+	while(g_hash_table_iter_next(&iter, NULL, &value))
+	{
+		w = value;
+		if(w->listed)
+			continue;
+		if((p = realloc(*removed, sizeof(*p) * (*removed_cnt + 1)))
+				== NULL)
+		{
+			_panel_clients_window_delete(w);
+			g_hash_table_iter_remove(&iter);
+			continue;
+		}
+		*removed = p;
+		(*removed)[(*removed_cnt)++] = w;
+		g_hash_table_iter_remove(&iter);
+	}
+}
+
+static void _refresh_window_request(PanelClients * clients,
+		PanelProperties * properties, PanelClientsWindow * window)
+{
+	Atom utf8 = clients->atoms[PANEL_CLIENTS_ATOM_UTF8_STRING];
+
+	if(window->dirty & PANEL_CLIENTS_PROPERTY_DESKTOP)
+		window->index[PANEL_CLIENTS_REQUEST_DESKTOP]
+			= panel_properties_add(properties, window->window,
+					clients->atoms[
+					PANEL_CLIENTS_ATOM__NET_WM_DESKTOP],
+					XA_CARDINAL);
+	if(window->dirty & PANEL_CLIENTS_PROPERTY_STATE)
+		window->index[PANEL_CLIENTS_REQUEST_STATE]
+			= panel_properties_add(properties, window->window,
+					clients->atoms[
+					PANEL_CLIENTS_ATOM__NET_WM_STATE],
+					XA_ATOM);
+	if(window->dirty & PANEL_CLIENTS_PROPERTY_TYPE)
+		window->index[PANEL_CLIENTS_REQUEST_TYPE]
+			= panel_properties_add(properties, window->window,
+					clients->atoms[
+					PANEL_CLIENTS_ATOM__NET_WM_WINDOW_TYPE],
+					XA_ATOM);
+	if(window->dirty & PANEL_CLIENTS_PROPERTY_NAME)
+	{
+		/* by order of preference */
+		window->index[PANEL_CLIENTS_REQUEST_VISIBLE_NAME]
+			= panel_properties_add(properties, window->window,
+					clients->atoms[
+					PANEL_CLIENTS_ATOM__NET_WM_VISIBLE_NAME],
+					utf8);
+		window->index[PANEL_CLIENTS_REQUEST_NAME]
+			= panel_properties_add(properties, window->window,
+					clients->atoms[
+					PANEL_CLIENTS_ATOM__NET_WM_NAME],
+					utf8);
+		window->index[PANEL_CLIENTS_REQUEST_WM_NAME]
+			= panel_properties_add(properties, window->window,
+					XA_WM_NAME, AnyPropertyType);
+	}
+}
+
+static void _refresh_window(PanelClients * clients,
+		PanelProperties * properties, PanelClientsWindow * window)
+{
+	unsigned long cnt;
+	unsigned long * p;
+	int desktop;
+	Atom * state;
+	Atom type;
+	char * name = NULL;
+	size_t i;
+	(void) clients;
+
+	if(window->dirty & PANEL_CLIENTS_PROPERTY_DESKTOP)
+	{
+		desktop = (panel_properties_get(properties, window->index[
+					PANEL_CLIENTS_REQUEST_DESKTOP], &cnt,
+					(void *)&p) == 0 && cnt == 1)
+			? (int)p[0] : -1;
+		if(desktop != window->desktop)
+			window->changed |= PANEL_CLIENTS_PROPERTY_DESKTOP;
+		window->desktop = desktop;
+	}
+	if(window->dirty & PANEL_CLIENTS_PROPERTY_STATE)
+	{
+		if(panel_properties_get(properties, window->index[
+					PANEL_CLIENTS_REQUEST_STATE], &cnt,
+					(void *)&p) != 0)
+			cnt = 0;
+		if(cnt != window->state_cnt || (cnt > 0 && memcmp(p,
+						window->state,
+						sizeof(*p) * cnt) != 0))
+		{
+			if(cnt == 0)
+			{
+				free(window->state);
+				window->state = NULL;
+				window->state_cnt = 0;
+				window->changed |= PANEL_CLIENTS_PROPERTY_STATE;
+			}
+			else if((state = realloc(window->state, sizeof(*state)
+							* cnt)) != NULL)
+			{
+				memcpy(state, p, sizeof(*state) * cnt);
+				window->state = state;
+				window->state_cnt = cnt;
+				window->changed |= PANEL_CLIENTS_PROPERTY_STATE;
+			}
+		}
+	}
+	if(window->dirty & PANEL_CLIENTS_PROPERTY_TYPE)
+	{
+		type = (panel_properties_get(properties, window->index[
+					PANEL_CLIENTS_REQUEST_TYPE], &cnt,
+					(void *)&p) == 0 && cnt > 0)
+			? p[0] : None;
+		if(type != window->type)
+			window->changed |= PANEL_CLIENTS_PROPERTY_TYPE;
+		window->type = type;
+	}
+	if(window->dirty & PANEL_CLIENTS_PROPERTY_NAME)
+	{
+		for(i = PANEL_CLIENTS_REQUEST_VISIBLE_NAME; name == NULL
+				&& i <= PANEL_CLIENTS_REQUEST_WM_NAME; i++)
+			name = panel_properties_get_text(properties,
+					window->index[i]);
+		if(g_strcmp0(name, window->name) != 0)
+			window->changed |= PANEL_CLIENTS_PROPERTY_NAME;
+		g_free(window->name);
+		window->name = name;
+	}
+	window->dirty = 0;
+}
+
+static void _refresh_window_notify(PanelClients * clients,
+		PanelClientsWindow * window)
+{
+	unsigned int changed = window->changed;
+	Window w = window->window;
+
+	window->changed = 0;
+	if(window->added)
+	{
+		window->added = FALSE;
+		_panel_clients_notify(clients, PANEL_CLIENTS_EVENT_ADDED, w,
+				PANEL_CLIENTS_ATOM__NET_CLIENT_LIST);
+		return;
+	}
+	if(changed & PANEL_CLIENTS_PROPERTY_TYPE)
+		_panel_clients_notify(clients, PANEL_CLIENTS_EVENT_CHANGED, w,
+				PANEL_CLIENTS_ATOM__NET_WM_WINDOW_TYPE);
+	if(changed & PANEL_CLIENTS_PROPERTY_DESKTOP)
+		_panel_clients_notify(clients, PANEL_CLIENTS_EVENT_CHANGED, w,
+				PANEL_CLIENTS_ATOM__NET_WM_DESKTOP);
+	if(changed & PANEL_CLIENTS_PROPERTY_STATE)
+		_panel_clients_notify(clients, PANEL_CLIENTS_EVENT_CHANGED, w,
+				PANEL_CLIENTS_ATOM__NET_WM_STATE);
+	if(changed & PANEL_CLIENTS_PROPERTY_NAME)
+		_panel_clients_notify(clients, PANEL_CLIENTS_EVENT_CHANGED, w,
+				PANEL_CLIENTS_ATOM__NET_WM_NAME);
+}
+
+
+/* panel_clients_schedule */
+static void _panel_clients_schedule(PanelClients * clients)
+{
+	/* fetched once for a burst of changes, before the next redraw */
+	if(clients->source == 0)
+		clients->source = g_idle_add_full(G_PRIORITY_HIGH_IDLE,
+				_panel_clients_on_idle, clients, NULL);
+}
+
+
+/* panel_clients_start */
+static void _panel_clients_start(PanelClients * clients)
+{
+	GdkEventMask events;
+	GHashTableIter iter;
+	gpointer value;
+
+	/* be notified of the changes before looking at the properties */
+	events = gdk_window_get_events(clients->root);
+	gdk_window_set_events(clients->root, events
+			| GDK_PROPERTY_CHANGE_MASK);
+#if defined(GDK_WINDOWING_X11)
+	/* the client windows are not known to Gtk+ */
+	gdk_window_add_filter(NULL, _panel_clients_on_filter, clients);
+#endif
+	clients->dirty = PANEL_CLIENTS_SCREEN_ALL;
+	g_hash_table_iter_init(&iter, clients->windows);
+	while(g_hash_table_iter_next(&iter, NULL, &value))
+		((PanelClientsWindow *)value)->dirty
+			= PANEL_CLIENTS_PROPERTY_ALL;
+	_panel_clients_refresh(clients);
+}
+
+
+/* panel_clients_stop */
+static void _panel_clients_stop(PanelClients * clients)
+{
+#if defined(GDK_WINDOWING_X11)
+	gdk_window_remove_filter(NULL, _panel_clients_on_filter, clients);
+#endif
+	if(clients->source != 0)
+		g_source_remove(clients->source);
+	clients->source = 0;
+}
+
+
+/* panel_clients_window_new */
+static PanelClientsWindow * _panel_clients_window_new(PanelClients * clients,
+		Window window)
+{
+	PanelClientsWindow * w;
+#if defined(GDK_WINDOWING_X11)
+	GdkWindow * gw;
+#endif
+
+	if((w = malloc(sizeof(*w))) == NULL)
+		return NULL;
+	w->window = window;
+	w->dirty = PANEL_CLIENTS_PROPERTY_ALL;
+	w->changed = 0;
+	w->added = TRUE;
+	w->listed = TRUE;
+	w->desktop = -1;
+	w->name = NULL;
+	w->state = NULL;
+	w->state_cnt = 0;
+	w->type = None;
+#if defined(GDK_WINDOWING_X11)
+	/* be notified of the changes before looking at the properties */
+# if GTK_CHECK_VERSION(2, 24, 0)
+	if((gw = gdk_x11_window_lookup_for_display(clients->display, window))
+			!= NULL)
+# else
+	if((gw = gdk_window_lookup_for_display(clients->display, window))
+			!= NULL)
+# endif
+		/* do not override the events selected by Gtk+ */
+		gdk_window_set_events(gw, gdk_window_get_events(gw)
+				| GDK_PROPERTY_CHANGE_MASK);
+	else
+	{
+		gdk_error_trap_push();
+		XSelectInput(GDK_DISPLAY_XDISPLAY(clients->display), window,
+				PropertyChangeMask);
+		gdk_error_trap_pop_ignored();
+	}
+#endif
+	return w;
+}
+
+
+/* panel_clients_window_delete */
+static void _panel_clients_window_delete(PanelClientsWindow * window)
+{
+	g_free(window->name);
+	free(window->state);
+	free(window);
+}
+
+
+/* callbacks */
+#if defined(GDK_WINDOWING_X11)
+/* panel_clients_on_filter */
+static GdkFilterReturn _panel_clients_on_filter(GdkXEvent * xevent,
+		GdkEvent * event, gpointer data)
+{
+	PanelClients * clients = data;
+	XEvent * xev = xevent;
+	Atom property;
+	PanelClientsWindow * w;
+	size_t i;
+	(void) event;
+
+	if(xev->type != PropertyNotify)
+		return GDK_FILTER_CONTINUE;
+	property = xev->xproperty.atom;
+	if(xev->xproperty.window == GDK_WINDOW_XID(clients->root))
+	{
+		if(property == clients->atoms[
+				PANEL_CLIENTS_ATOM__NET_ACTIVE_WINDOW])
+			clients->dirty |= PANEL_CLIENTS_SCREEN_ACTIVE;
+		else if(property == clients->atoms[
+				PANEL_CLIENTS_ATOM__NET_CLIENT_LIST])
+			clients->dirty |= PANEL_CLIENTS_SCREEN_CLIENT_LIST;
+		else if(property == clients->atoms[
+				PANEL_CLIENTS_ATOM__NET_CURRENT_DESKTOP])
+			clients->dirty |= PANEL_CLIENTS_SCREEN_CURRENT_DESKTOP;
+		else if(property == clients->atoms[
+				PANEL_CLIENTS_ATOM__NET_DESKTOP_NAMES])
+			clients->dirty |= PANEL_CLIENTS_SCREEN_DESKTOP_NAMES;
+		else if(property == clients->atoms[
+				PANEL_CLIENTS_ATOM__NET_NUMBER_OF_DESKTOPS])
+			clients->dirty |= PANEL_CLIENTS_SCREEN_NUMBER_OF_DESKTOPS;
+		else
+			return GDK_FILTER_CONTINUE;
+		_panel_clients_schedule(clients);
+		return GDK_FILTER_CONTINUE;
+	}
+	if((w = g_hash_table_lookup(clients->windows, GSIZE_TO_POINTER(
+						xev->xproperty.window))) == NULL)
+		return GDK_FILTER_CONTINUE;
+	if(property == clients->atoms[PANEL_CLIENTS_ATOM__NET_WM_DESKTOP])
+		w->dirty |= PANEL_CLIENTS_PROPERTY_DESKTOP;
+	else if(property == clients->atoms[
+			PANEL_CLIENTS_ATOM__NET_WM_VISIBLE_NAME]
+			|| property == clients->atoms[
+			PANEL_CLIENTS_ATOM__NET_WM_NAME]
+			|| property == XA_WM_NAME)
+		w->dirty |= PANEL_CLIENTS_PROPERTY_NAME;
+	else if(property == clients->atoms[PANEL_CLIENTS_ATOM__NET_WM_STATE])
+		w->dirty |= PANEL_CLIENTS_PROPERTY_STATE;
+	else if(property == clients->atoms[
+			PANEL_CLIENTS_ATOM__NET_WM_WINDOW_TYPE])
+		w->dirty |= PANEL_CLIENTS_PROPERTY_TYPE;
+	else
+	{
+		/* not cached, but the subscribers may fetch it */
+		for(i = 0; i < PANEL_CLIENTS_ATOM_COUNT; i++)
+			if(clients->atoms[i] == property)
+			{
+				_panel_clients_notify(clients,
+						PANEL_CLIENTS_EVENT_CHANGED,
+						w->window, i);
+				break;
+			}
+		return GDK_FILTER_CONTINUE;
+	}
+	_panel_clients_schedule(clients);
+	return GDK_FILTER_CONTINUE;
+}
+#endif
+
+
+/* panel_clients_on_idle */
+static gboolean _panel_clients_on_idle(gpointer data)
+{
+	PanelClients * clients = data;
+
+	clients->source = 0;
+	_panel_clients_refresh(clients);
+	return FALSE;
+}
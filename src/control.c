@@ -0,0 +1,398 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Panel */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <System.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#ifdef DEBUG
+# include <stdio.h>
+#endif
+#include <gdk/gdk.h>
+#include "control.h"
+#include "../config.h"
+
+
+/* PanelControl */
+/* private */
+/* types */
+typedef struct _PanelControlClient
+{
+	PanelControl * control;
+	int fd;
+	GIOChannel * channel;
+	guint source;			/* G_IO_IN, or G_IO_OUT		*/
+
+	char buf[PANEL_CONTROL_LINE];
+	size_t buf_cnt;
+	GString * output;
+	size_t output_pos;
+	gboolean closing;
+} PanelControlClient;
+
+struct _PanelControl
+{
+	PanelControlCallback callback;
+	void * data;
+
+	String * path;
+	int fd;
+	GIOChannel * channel;
+	guint source;
+
+	PanelControlClient ** clients;
+	size_t clients_cnt;
+};
+
+
+/* prototypes */
+static int _panel_control_bind(PanelControl * control);
+
+static void _panel_control_client_delete(PanelControlClient * client);
+static void _panel_control_client_process(PanelControlClient * client);
+static void _panel_control_client_watch(PanelControlClient * client,
+		GIOCondition condition);
+
+/* callbacks */
+static gboolean _panel_control_on_accept(GIOChannel * channel,
+		GIOCondition condition, gpointer data);
+static gboolean _panel_control_on_client(GIOChannel * channel,
+		GIOCondition condition, gpointer data);
+
+
+/* public */
+/* functions */
+/* panel_control_new */
+PanelControl * panel_control_new(PanelControlCallback callback, void * data)
+{
+	PanelControl * control;
+
+	if((control = object_new(sizeof(*control))) == NULL)
+		return NULL;
+	control->callback = callback;
+	control->data = data;
+	control->path = panel_control_get_path();
+	control->fd = -1;
+	control->channel = NULL;
+	control->source = 0;
+	control->clients = NULL;
+	control->clients_cnt = 0;
+	if(control->path == NULL || _panel_control_bind(control) != 0)
+	{
+		panel_control_delete(control);
+		return NULL;
+	}
+	control->channel = g_io_channel_unix_new(control->fd);
+	control->source = g_io_add_watch(control->channel, G_IO_IN,
+			_panel_control_on_accept, control);
+	return control;
+}
+
+
+/* panel_control_delete */
+void panel_control_delete(PanelControl * control)
+{
+	while(control->clients_cnt > 0)
+		_panel_control_client_delete(control->clients[0]);
+	free(control->clients);
+	if(control->source != 0)
+		g_source_remove(control->source);
+	if(control->channel != NULL)
+		g_io_channel_unref(control->channel);
+	if(control->fd >= 0)
+	{
+		close(control->fd);
+		unlink(control->path);
+	}
+	string_delete(control->path);
+	object_delete(control);
+}
+
+
+/* useful */
+/* panel_control_get_path */
+String * panel_control_get_path(void)
+{
+	String * ret;
+	GdkDisplay * display;
+	String * name;
+	size_t i;
+
+	/* one socket per user and per display */
+	if((display = gdk_display_get_default()) == NULL)
+	{
+		error_set_code(1, "%s", "Could not open the display");
+		return NULL;
+	}
+	if((name = string_new(gdk_display_get_name(display))) == NULL)
+		return NULL;
+	for(i = 0; name[i] != '\0'; i++)
+		if(name[i] == '/')
+			name[i] = '_';
+	ret = string_new_append(g_get_user_runtime_dir(), "/" PACKAGE ".",
+			name, NULL);
+	string_delete(name);
+	return ret;
+}
+
+
+/* private */
+/* functions */
+/* panel_control_bind */
+static int _panel_control_bind(PanelControl * control)
+{
+	struct sockaddr_un sa;
+	mode_t mask;
+	int res;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sun_family = AF_UNIX;
+	if(string_get_length(control->path) >= sizeof(sa.sun_path))
+		return -error_set_code(1, "%s: %s", control->path,
+				strerror(ENAMETOOLONG));
+	strcpy(sa.sun_path, control->path);
+	if((control->fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+		return -error_set_code(1, "%s: %s", "socket", strerror(errno));
+	/* only allow the current user to connect */
+	mask = umask(077);
+	if((res = bind(control->fd, (struct sockaddr *)&sa, sizeof(sa))) != 0
+			&& errno == EADDRINUSE
+			&& connect(control->fd, (struct sockaddr *)&sa,
+				sizeof(sa)) != 0)
+	{
+		/* remove the socket left over by a previous instance */
+		close(control->fd);
+		unlink(control->path);
+		if((control->fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+		{
+			umask(mask);
+			return -error_set_code(1, "%s: %s", "socket",
+					strerror(errno));
+		}
+		res = bind(control->fd, (struct sockaddr *)&sa, sizeof(sa));
+	}
+	umask(mask);
+	if(res != 0 || listen(control->fd, PANEL_CONTROL_CLIENTS) != 0
+			|| fcntl(control->fd, F_SETFL, O_NONBLOCK) != 0)
+	{
+		error_set_code(1, "%s: %s", control->path, strerror(errno));
+		close(control->fd);
+		control->fd = -1;
+		return -1;
+	}
+	return 0;
+}
+
+
+/* panel_control_client_delete */
+static void _panel_control_client_delete(PanelControlClient * client)
+{
+	PanelControl * control = client->control;
+	size_t i;
+
+	for(i = 0; i < control->clients_cnt; i++)
+		if(control->clients[i] == client)
+		{
+			memmove(&control->clients[i], &control->clients[i + 1],
+					sizeof(*control->clients)
+					* (--control->clients_cnt - i));
+			break;
+		}
+	if(client->source != 0)
+		g_source_remove(client->source);
+	g_io_channel_unref(client->channel);
+	close(client->fd);
+	g_string_free(client->output, TRUE);
+	free(client);
+}
+
+
+/* panel_control_client_process */
+static void _panel_control_client_process(PanelControlClient * client)
+{
+	PanelControl * control = client->control;
+	char * p;
+	size_t len;
+
+	while((p = memchr(client->buf, '\n', client->buf_cnt)) != NULL)
+	{
+		*p = '\0';
+		len = p - client->buf;
+		if(len > 0 && client->buf[len - 1] == '\r')
+			client->buf[len - 1] = '\0';
+#ifdef DEBUG
+		fprintf(stderr, "DEBUG: %s() \"%s\"\n", __func__, client->buf);
+#endif
+		if(control->callback(control->data, client->buf,
+					client->output) == 0)
+			g_string_append(client->output,
+					PANEL_CONTROL_OK "\n");
+		else
+			g_string_append_printf(client->output,
+					PANEL_CONTROL_ERROR ": %s\n",
+					error_get(NULL));
+		memmove(client->buf, &p[1], client->buf_cnt - len - 1);
+		client->buf_cnt -= len + 1;
+	}
+	if(client->buf_cnt == sizeof(client->buf))
+	{
+		/* the request is too long */
+		g_string_append_printf(client->output,
+				PANEL_CONTROL_ERROR ": %s\n",
+				strerror(E2BIG));
+		client->buf_cnt = 0;
+		client->closing = TRUE;
+	}
+}
+
+
+/* panel_control_client_watch */
+static void _panel_control_client_watch(PanelControlClient * client,
+		GIOCondition condition)
+{
+	if(client->source != 0)
+		g_source_remove(client->source);
+	client->source = g_io_add_watch(client->channel, condition,
+			_panel_control_on_client, client);
+}
+
+
+/* callbacks */
+/* panel_control_on_accept */
+static gboolean _panel_control_on_accept(GIOChannel * channel,
+		GIOCondition condition, gpointer data)
+{
+	PanelControl * control = data;
+	PanelControlClient ** p;
+	PanelControlClient * client;
+	int fd;
+#ifdef SO_NOSIGPIPE
+	const int one = 1;
+#endif
+	(void) channel;
+	(void) condition;
+
+	if((fd = accept(control->fd, NULL, NULL)) < 0)
+		return TRUE;
+#ifdef SO_NOSIGPIPE
+	setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+	/* do not let the clients block the panel */
+	if(control->clients_cnt >= PANEL_CONTROL_CLIENTS
+			|| fcntl(fd, F_SETFL, O_NONBLOCK) != 0
+			|| (p = realloc(control->clients, sizeof(*p)
+					* (control->clients_cnt + 1))) == NULL)
+	{
+		close(fd);
+		return TRUE;
+	}
+	control->clients = p;
+	if((client = malloc(sizeof(*client))) == NULL)
+	{
+		close(fd);
+		return TRUE;
+	}
+	client->control = control;
+	client->fd = fd;
+	client->channel = g_io_channel_unix_new(fd);
+	client->source = 0;
+	client->buf_cnt = 0;
+	client->output = g_string_new(NULL);
+	client->output_pos = 0;
+	client->closing = FALSE;
+	control->clients[control->clients_cnt++] = client;
+	_panel_control_client_watch(client, G_IO_IN | G_IO_HUP | G_IO_ERR);
+	return TRUE;
+}
+
+
+/* panel_control_on_client */
+static gboolean _panel_control_on_client(GIOChannel * channel,
+		GIOCondition condition, gpointer data)
+{
+	PanelControlClient * client = data;
+	ssize_t res;
+	(void) channel;
+
+	if(condition & (G_IO_HUP | G_IO_ERR) && !(condition & G_IO_IN))
+	{
+		client->source = 0;
+		_panel_control_client_delete(client);
+		return FALSE;
+	}
+	if(condition & G_IO_OUT)
+	{
+		/* the client may be gone already */
+#ifdef MSG_NOSIGNAL
+		if((res = send(client->fd, &client->output->str[
+						client->output_pos],
+						client->output->len
+						- client->output_pos,
+						MSG_NOSIGNAL)) < 0)
+#else
+		if((res = write(client->fd, &client->output->str[
+						client->output_pos],
+						client->output->len
+						- client->output_pos)) < 0)
+#endif
+		{
+			if(errno == EAGAIN || errno == EINTR)
+				return TRUE;
+			client->source = 0;
+			_panel_control_client_delete(client);
+			return FALSE;
+		}
+		if((client->output_pos += res) < client->output->len)
+			return TRUE;
+		g_string_truncate(client->output, 0);
+		client->output_pos = 0;
+		client->source = 0;
+		if(client->closing)
+			_panel_control_client_delete(client);
+		else
+			_panel_control_client_watch(client, G_IO_IN
+					| G_IO_HUP | G_IO_ERR);
+		return FALSE;
+	}
+	if((res = read(client->fd, &client->buf[client->buf_cnt],
+					sizeof(client->buf) - client->buf_cnt))
+			< 0 && (errno == EAGAIN || errno == EINTR))
+		return TRUE;
+	if(res <= 0)
+		/* the client is done (or gone) */
+		client->closing = TRUE;
+	else
+	{
+		client->buf_cnt += res;
+		_panel_control_client_process(client);
+	}
+	client->source = 0;
+	if(client->output->len > 0)
+		_panel_control_client_watch(client, G_IO_OUT);
+	else if(client->closing)
+		_panel_control_client_delete(client);
+	else
+		_panel_control_client_watch(client, G_IO_IN | G_IO_HUP
+				| G_IO_ERR);
+	return FALSE;
+}
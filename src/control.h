@@ -0,0 +1,50 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Panel */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#ifndef PANEL_CONTROL_H
+# define PANEL_CONTROL_H
+
+# include <System/string.h>
+# include <glib.h>
+
+
+/* PanelControl */
+/* types */
+typedef struct _PanelControl PanelControl;
+
+/* returns 0 on success, or sets the error otherwise */
+typedef int (*PanelControlCallback)(void * data, char const * request,
+		GString * response);
+
+
+/* constants */
+# define PANEL_CONTROL_CLIENTS		8
+# define PANEL_CONTROL_LINE		256	/* longest request	*/
+
+/* the last line of every response */
+# define PANEL_CONTROL_ERROR		"ERROR"
+# define PANEL_CONTROL_OK		"OK"
+
+
+/* functions */
+PanelControl * panel_control_new(PanelControlCallback callback, void * data);
+void panel_control_delete(PanelControl * control);
+
+/* useful */
+String * panel_control_get_path(void);
+
+#endif /* !PANEL_CONTROL_H */
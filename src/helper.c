@@ -46,6 +46,10 @@ static void _panel_helper_lock(Panel * panel);
 static void _panel_helper_lock_dialog(Panel * panel);
 static void _panel_helper_logout(Panel * panel);
 static void _panel_helper_logout_dialog(Panel * panel);
+#ifdef HELPER_LOCK
+static void _panel_helper_pause(Panel * panel, PanelPause reason,
+		gboolean pause);
+#endif
 #ifndef HELPER_POSITION_MENU_WIDGET
 static void _panel_helper_position_menu(Panel * panel, GtkMenu * menu, gint * x,
 		gint * y, gboolean * push_in, PanelPosition position);
@@ -63,6 +67,9 @@ static void _panel_helper_shutdown(Panel * panel, gboolean reboot);
 static void _panel_helper_shutdown_dialog(Panel * panel);
 static void _panel_helper_suspend(Panel * panel);
 static void _panel_helper_suspend_dialog(Panel * panel);
+static guint _panel_helper_timeout_add(Panel * panel, guint interval,
+		GSourceFunc callback, PanelApplet * applet);
+static void _panel_helper_timeout_remove(Panel * panel, guint id);
 
 
 /* functions */
@@ -203,7 +210,12 @@ static gboolean _lock_on_idle(gpointer data)
 	{
 		_panel_helper_error(panel, error->message, 1);
 		g_error_free(error);
+		return FALSE;
 	}
+#ifdef HELPER_LOCK
+	/* the locking commands usually return at once */
+	_panel_lock(panel);
+#endif
 	return FALSE;
 }
 
@@ -362,6 +374,41 @@ static void _logout_dialog_on_response(GtkWidget * widget, gint response,
 }
 
 
+#ifdef HELPER_LOCK
+/* panel_helper_pause */
+static void _panel_helper_pause(Panel * panel, PanelPause reason,
+		gboolean pause)
+{
+	size_t i;
+#ifdef HELPER_MONITORS
+	size_t j;
+	PanelWindow * window;
+#endif
+
+#ifdef DEBUG
+	fprintf(stderr, "DEBUG: %s(0x%x, %s)\n", __func__, reason,
+			pause ? "TRUE" : "FALSE");
+#endif
+	if(pause)
+		panel->paused |= reason;
+	else
+		panel->paused &= ~reason;
+	for(i = 0; i < sizeof(panel->windows) / sizeof(*panel->windows); i++)
+		if(panel->windows[i] != NULL)
+			panel_window_suspend(panel->windows[i],
+					(panel->paused != 0) ? TRUE : FALSE);
+#ifdef HELPER_MONITORS
+	for(i = 0; i < panel->monitors_cnt; i++)
+		for(j = 0; j < PANEL_POSITION_COUNT; j++)
+			if((window = panel->monitors[i]->windows[j]) != NULL)
+				panel_window_suspend(window,
+						(panel->paused != 0)
+						? TRUE : FALSE);
+#endif
+}
+#endif
+
+
 #ifndef HELPER_POSITION_MENU_WIDGET
 /* panel_helper_position_menu */
 static void _panel_helper_position_menu(Panel * panel, GtkMenu * menu, gint * x,
@@ -369,6 +416,7 @@ static void _panel_helper_position_menu(Panel * panel, GtkMenu * menu, gint * x,
 {
 	GtkRequisition req;
 	PanelWindow * window = panel->windows[position];
+	GdkRectangle rect;
 
 	if(window == NULL)
 		return;
@@ -383,20 +431,24 @@ static void _panel_helper_position_menu(Panel * panel, GtkMenu * menu, gint * x,
 #endif
 	if(req.height <= 0)
 		return;
+	/* the panel may be on any monitor, use the one of the pointer */
+	gdk_screen_get_monitor_geometry(panel->screen,
+			gdk_screen_get_monitor_at_point(panel->screen, *x, *y),
+			&rect);
 	switch(position)
 	{
 		case PANEL_POSITION_TOP:
-			*y = panel_window_get_height(window);
+			*y = rect.y + panel_window_get_height(window);
 			break;
 		case PANEL_POSITION_BOTTOM:
-			*y = panel->root_height
+			*y = rect.y + rect.height
 				- panel_window_get_height(window) - req.height;
 			break;
 		case PANEL_POSITION_LEFT:
-			*x = panel_window_get_width(window);
+			*x = rect.x + panel_window_get_width(window);
 			break;
 		case PANEL_POSITION_RIGHT:
-			*x = panel->root_width
+			*x = rect.x + rect.width
 				- panel_window_get_width(window) - req.width;
 			break;
 	}
@@ -676,3 +728,23 @@ static void _suspend_dialog_on_response(GtkWidget * widget, gint response,
 	if(response == TRUE)
 		_panel_helper_suspend(panel);
 }
+
+
+/* panel_helper_timeout_add */
+static guint _panel_helper_timeout_add(Panel * panel, guint interval,
+		GSourceFunc callback, PanelApplet * applet)
+{
+	guint ret;
+
+	if((ret = panel_timer_add(panel->timer, interval, callback, applet))
+			== 0)
+		_panel_helper_error(NULL, error_get(NULL), 1);
+	return ret;
+}
+
+
+/* panel_helper_timeout_remove */
+static void _panel_helper_timeout_remove(Panel * panel, guint id)
+{
+	panel_timer_remove(panel->timer, id);
+}
@@ -0,0 +1,379 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Panel */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#include <System.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#if defined(__SSE2__)
+# include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON) && !defined(__ARM_BIG_ENDIAN) \
+	&& ULONG_MAX > 0xffffffffUL
+# include <arm_neon.h>
+# define PANEL_IMAGE_NEON
+#endif
+#include "../include/Panel/image.h"
+
+
+/* PanelImage */
+/* private */
+/* prototypes */
+static void _image_accumulate(uint32_t * acc, unsigned char const * row,
+		size_t cnt);
+static unsigned int _image_div255(unsigned int value);
+static size_t _image_unpack(unsigned char * rgba, unsigned long const * argb,
+		size_t cnt, unsigned int flags);
+
+
+/* public */
+/* functions */
+/* panel_image_unpack */
+void panel_image_unpack(unsigned char * rgba, unsigned long const * argb,
+		size_t cnt, unsigned int flags)
+{
+	size_t i;
+	unsigned long p;
+	unsigned int a;
+
+	/* the vector code only handles complete blocks of pixels */
+	for(i = _image_unpack(rgba, argb, cnt, flags), rgba += i * 4; i < cnt;
+			i++, rgba += 4)
+	{
+		p = argb[i];
+		a = (p >> 24) & 0xff;
+		rgba[0] = (p >> 16) & 0xff; /* red */
+		rgba[1] = (p >> 8) & 0xff; /* green */
+		rgba[2] = p & 0xff; /* blue */
+		rgba[3] = a; /* alpha */
+		if(flags & PANEL_IMAGE_PREMULTIPLIED)
+		{
+			rgba[0] = _image_div255(rgba[0] * a);
+			rgba[1] = _image_div255(rgba[1] * a);
+			rgba[2] = _image_div255(rgba[2] * a);
+		}
+	}
+}
+
+
+/* panel_image_unpremultiply */
+void panel_image_unpremultiply(unsigned char * rgba, size_t cnt)
+{
+	size_t i;
+	unsigned int a;
+	unsigned int c;
+	unsigned int v;
+
+	for(i = 0; i < cnt; i++, rgba += 4)
+	{
+		if((a = rgba[3]) == 255)
+			continue;
+		for(c = 0; c < 3; c++)
+		{
+			v = (a == 0) ? 0 : (rgba[c] * 255 + a / 2) / a;
+			rgba[c] = (v > 255) ? 255 : v;
+		}
+	}
+}
+
+
+/* panel_image_scale */
+int panel_image_scale(unsigned char * dst, int dst_width, int dst_height,
+		unsigned char const * src, int src_width, int src_height)
+{
+	size_t stride = (size_t)src_width * 4;
+	uint32_t * acc;
+	size_t x;
+	size_t y;
+	size_t x0;
+	size_t x1;
+	size_t y0;
+	size_t y1;
+	size_t i;
+	size_t area;
+	uint32_t sum[4];
+
+	if(dst_width <= 0 || dst_height <= 0 || dst_width > src_width
+			|| dst_height > src_height)
+		return -error_set_code(1, "%s", strerror(ERANGE));
+	if((acc = malloc(sizeof(*acc) * stride)) == NULL)
+		return -error_set_code(1, "%s", strerror(errno));
+	for(y = 0; y < (size_t)dst_height; y++)
+	{
+		/* sum the source rows covered vertically first */
+		y0 = y * src_height / dst_height;
+		y1 = (y + 1) * src_height / dst_height;
+		memset(acc, 0, sizeof(*acc) * stride);
+		for(i = y0; i < y1; i++)
+			_image_accumulate(acc, &src[i * stride], stride);
+		/* then average them horizontally */
+		for(x = 0, x1 = 0; x < (size_t)dst_width; x++)
+		{
+			x0 = x1;
+			x1 = (x + 1) * src_width / dst_width;
+			area = (x1 - x0) * (y1 - y0);
+			memset(sum, 0, sizeof(sum));
+			for(i = x0; i < x1; i++)
+			{
+				sum[0] += acc[i * 4];
+				sum[1] += acc[i * 4 + 1];
+				sum[2] += acc[i * 4 + 2];
+				sum[3] += acc[i * 4 + 3];
+			}
+			for(i = 0; i < 4; i++)
+				*(dst++) = (sum[i] + area / 2) / area;
+		}
+	}
+	free(acc);
+	return 0;
+}
+
+
+/* panel_image_new_pixbuf */
+GdkPixbuf * panel_image_new_pixbuf(unsigned long const * argb, int width,
+		int height, int pixbuf_width, int pixbuf_height)
+{
+	GdkPixbuf * ret;
+	size_t cnt = (size_t)width * height;
+	unsigned char * src;
+	unsigned char * dst;
+	GdkPixbuf * p;
+
+	if(width <= 0 || height <= 0 || pixbuf_width <= 0 || pixbuf_height <= 0)
+	{
+		error_set_code(1, "%s", strerror(ERANGE));
+		return NULL;
+	}
+	if((src = malloc(cnt * 4)) == NULL)
+	{
+		error_set_code(1, "%s", strerror(errno));
+		return NULL;
+	}
+	if(pixbuf_width > width || pixbuf_height > height)
+	{
+		/* the box filter only downscales */
+		panel_image_unpack(src, argb, cnt, 0);
+		p = gdk_pixbuf_new_from_data(src, GDK_COLORSPACE_RGB, TRUE, 8,
+				width, height, width * 4,
+				(GdkPixbufDestroyNotify)free, NULL);
+		ret = gdk_pixbuf_scale_simple(p, pixbuf_width, pixbuf_height,
+				GDK_INTERP_BILINEAR);
+		g_object_unref(p);
+		return ret;
+	}
+	if(pixbuf_width == width && pixbuf_height == height)
+		panel_image_unpack(src, argb, cnt, 0);
+	else
+	{
+		/* average with premultiplied alpha, to avoid dark fringes */
+		panel_image_unpack(src, argb, cnt, PANEL_IMAGE_PREMULTIPLIED);
+		cnt = (size_t)pixbuf_width * pixbuf_height;
+		if((dst = malloc(cnt * 4)) == NULL
+				|| panel_image_scale(dst, pixbuf_width,
+					pixbuf_height, src, width, height)
+				!= 0)
+		{
+			if(dst == NULL)
+				error_set_code(1, "%s", strerror(errno));
+			free(dst);
+			free(src);
+			return NULL;
+		}
+		free(src);
+		src = dst;
+		panel_image_unpremultiply(src, cnt);
+	}
+	return gdk_pixbuf_new_from_data(src, GDK_COLORSPACE_RGB, TRUE, 8,
+			pixbuf_width, pixbuf_height, pixbuf_width * 4,
+			(GdkPixbufDestroyNotify)free, NULL);
+}
+
+
+/* private */
+/* functions */
+/* image_accumulate */
+static void _image_accumulate(uint32_t * acc, unsigned char const * row,
+		size_t cnt)
+{
+	size_t i = 0;
+#if defined(__SSE2__)
+	const __m128i zero = _mm_setzero_si128();
+	__m128i v;
+	__m128i l;
+	__m128i h;
+	__m128i * a;
+
+	for(; i + 16 <= cnt; i += 16)
+	{
+		v = _mm_loadu_si128((__m128i const *)&row[i]);
+		l = _mm_unpacklo_epi8(v, zero);
+		h = _mm_unpackhi_epi8(v, zero);
+		a = (__m128i *)&acc[i];
+		_mm_storeu_si128(&a[0], _mm_add_epi32(_mm_loadu_si128(&a[0]),
+					_mm_unpacklo_epi16(l, zero)));
+		_mm_storeu_si128(&a[1], _mm_add_epi32(_mm_loadu_si128(&a[1]),
+					_mm_unpackhi_epi16(l, zero)));
+		_mm_storeu_si128(&a[2], _mm_add_epi32(_mm_loadu_si128(&a[2]),
+					_mm_unpacklo_epi16(h, zero)));
+		_mm_storeu_si128(&a[3], _mm_add_epi32(_mm_loadu_si128(&a[3]),
+					_mm_unpackhi_epi16(h, zero)));
+	}
+#elif defined(PANEL_IMAGE_NEON)
+	uint8x16_t v;
+	uint16x8_t l;
+	uint16x8_t h;
+
+	for(; i + 16 <= cnt; i += 16)
+	{
+		v = vld1q_u8(&row[i]);
+		l = vmovl_u8(vget_low_u8(v));
+		h = vmovl_u8(vget_high_u8(v));
+		vst1q_u32(&acc[i], vaddw_u16(vld1q_u32(&acc[i]),
+					vget_low_u16(l)));
+		vst1q_u32(&acc[i + 4], vaddw_u16(vld1q_u32(&acc[i + 4]),
+					vget_high_u16(l)));
+		vst1q_u32(&acc[i + 8], vaddw_u16(vld1q_u32(&acc[i + 8]),
+					vget_low_u16(h)));
+		vst1q_u32(&acc[i + 12], vaddw_u16(vld1q_u32(&acc[i + 12]),
+					vget_high_u16(h)));
+	}
+#endif
+	for(; i < cnt; i++)
+		acc[i] += row[i];
+}
+
+
+/* image_div255 */
+static unsigned int _image_div255(unsigned int value)
+{
+	/* rounds exactly for value <= 255 * 255, as the vector code does */
+	value += 128;
+	return (value + (value >> 8)) >> 8;
+}
+
+
+/* image_unpack */
+/* returns the number of pixels converted, a multiple of 4 */
+#if defined(__SSE2__)
+static __m128i _unpack_premultiply(__m128i v);
+
+static size_t _image_unpack(unsigned char * rgba, unsigned long const * argb,
+		size_t cnt, unsigned int flags)
+{
+	const __m128i rb = _mm_set1_epi32(0x00ff00ff);
+	const __m128i ga = _mm_set1_epi32(0xff00ff00);
+	const __m128i zero = _mm_setzero_si128();
+	size_t i;
+	__m128i v;
+	__m128i t;
+# if ULONG_MAX > 0xffffffffUL
+	__m128i h;
+# endif
+
+	for(i = 0; i + 4 <= cnt; i += 4)
+	{
+# if ULONG_MAX > 0xffffffffUL
+		/* keep the lower half of every long */
+		v = _mm_loadu_si128((__m128i const *)&argb[i]);
+		h = _mm_loadu_si128((__m128i const *)&argb[i + 2]);
+		v = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 1, 2, 0));
+		h = _mm_shuffle_epi32(h, _MM_SHUFFLE(3, 1, 2, 0));
+		v = _mm_unpacklo_epi64(v, h);
+# else
+		v = _mm_loadu_si128((__m128i const *)&argb[i]);
+# endif
+		/* swap red and blue: 0xAARRGGBB becomes 0xAABBGGRR */
+		t = _mm_and_si128(v, rb);
+		t = _mm_or_si128(_mm_srli_epi32(t, 16), _mm_slli_epi32(t, 16));
+		v = _mm_or_si128(_mm_and_si128(v, ga), t);
+		if(flags & PANEL_IMAGE_PREMULTIPLIED)
+			v = _mm_packus_epi16(
+					_unpack_premultiply(
+						_mm_unpacklo_epi8(v, zero)),
+					_unpack_premultiply(
+						_mm_unpackhi_epi8(v, zero)));
+		_mm_storeu_si128((__m128i *)&rgba[i * 4], v);
+	}
+	return i;
+}
+
+static __m128i _unpack_premultiply(__m128i v)
+{
+	/* the alpha channel is multiplied by 255 (and left unchanged) */
+	const __m128i mask = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+	const __m128i opaque = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+	const __m128i half = _mm_set1_epi16(128);
+	__m128i a;
+
+	a = _mm_shufflelo_epi16(v, _MM_SHUFFLE(3, 3, 3, 3));
+	a = _mm_shufflehi_epi16(a, _MM_SHUFFLE(3, 3, 3, 3));
+	a = _mm_or_si128(_mm_andnot_si128(mask, a), opaque);
+	v = _mm_add_epi16(_mm_mullo_epi16(v, a), half);
+	return _mm_srli_epi16(_mm_add_epi16(v, _mm_srli_epi16(v, 8)), 8);
+}
+#elif defined(PANEL_IMAGE_NEON)
+static size_t _image_unpack(unsigned char * rgba, unsigned long const * argb,
+		size_t cnt, unsigned int flags)
+{
+	static const uint8_t swap[16] = { 2, 1, 0, 3, 6, 5, 4, 7,
+		10, 9, 8, 11, 14, 13, 12, 15 };
+	/* the indices out of range select 0 */
+	static const uint8_t alpha[16] = { 3, 3, 3, 0xff, 7, 7, 7, 0xff,
+		11, 11, 11, 0xff, 15, 15, 15, 0xff };
+	static const uint8_t opaque[16] = { 0, 0, 0, 0xff, 0, 0, 0, 0xff,
+		0, 0, 0, 0xff, 0, 0, 0, 0xff };
+	const uint16x8_t half = vdupq_n_u16(128);
+	size_t i;
+	uint8x16_t v;
+	uint8x16_t a;
+	uint16x8_t l;
+	uint16x8_t h;
+
+	for(i = 0; i + 4 <= cnt; i += 4)
+	{
+		/* keep the lower half of every long */
+		v = vreinterpretq_u8_u32(vld2q_u32((uint32_t const *)&argb[i])
+				.val[0]);
+		/* swap red and blue */
+		v = vqtbl1q_u8(v, vld1q_u8(swap));
+		if(flags & PANEL_IMAGE_PREMULTIPLIED)
+		{
+			a = vorrq_u8(vqtbl1q_u8(v, vld1q_u8(alpha)),
+					vld1q_u8(opaque));
+			l = vaddq_u16(vmull_u8(vget_low_u8(v),
+						vget_low_u8(a)), half);
+			h = vaddq_u16(vmull_high_u8(v, a), half);
+			v = vcombine_u8(vshrn_n_u16(vsraq_n_u16(l, l, 8), 8),
+					vshrn_n_u16(vsraq_n_u16(h, h, 8), 8));
+		}
+		vst1q_u8(&rgba[i * 4], v);
+	}
+	return i;
+}
+#else
+static size_t _image_unpack(unsigned char * rgba, unsigned long const * argb,
+		size_t cnt, unsigned int flags)
+{
+	(void) rgba;
+	(void) argb;
+	(void) cnt;
+	(void) flags;
+
+	return 0;
+}
+#endif
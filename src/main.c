@@ -1,5 +1,5 @@
 /* $Id$ */
-/* Copyright (c) 2011-2018 Pierre Pronchery <khorben@defora.org> */
+/* Copyright (c) 2011-2026 Pierre Pronchery <khorben@defora.org> */
 /* This file is part of DeforaOS Desktop Panel */
 /* This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -23,7 +23,9 @@
 #include <locale.h>
 #include <libintl.h>
 #include <gtk/gtk.h>
+#include <System/error.h>
 #include "panel.h"
+#include "profile.h"
 #include "../config.h"
 #define _(string) gettext(string)
 
@@ -61,9 +63,10 @@ static int _error(char const * message, int ret)
 /* usage */
 static int _usage(void)
 {
-	fprintf(stderr, _("Usage: %s [-L|-S|-x][-m monitor]\n"
+	fprintf(stderr, _("Usage: %s [-L|-S|-x][-m monitor][-p]\n"
 "  -L	Use icons the size of a large toolbar\n"
-"  -m	Monitor to use (default: 0)\n"
+"  -m	Monitor to use (default: 0, or \"all\")\n"
+"  -p	Profile the startup of the panel\n"
 "  -S	Use icons the size of a small toolbar\n"
 "  -x	Use icons the size of menus\n"), PROGNAME_PANEL);
 	return 1;
@@ -77,7 +80,11 @@ int main(int argc, char * argv[])
 	Panel * panel;
 	PanelPrefs prefs;
 	char * p;
+	gint64 begin;
+	char const * profile;
+	gboolean pflag = FALSE;
 
+	begin = g_get_monotonic_time();
 	if(setlocale(LC_ALL, "") == NULL)
 		_error("setlocale", 1);
 	bindtextdomain(PACKAGE, LOCALEDIR);
@@ -85,7 +92,7 @@ int main(int argc, char * argv[])
 	gtk_init(&argc, &argv);
 	prefs.iconsize = PANEL_ICON_SIZE_UNSET;
 	prefs.monitor = -1;
-	while((o = getopt(argc, argv, "Lm:Sx")) != -1)
+	while((o = getopt(argc, argv, "Lm:pSx")) != -1)
 		switch(o)
 		{
 			case 'L':
@@ -93,9 +100,14 @@ int main(int argc, char * argv[])
 				break;
 			case 'm':
 				prefs.monitor = strtol(optarg, &p, 10);
-				if(optarg[0] == '\0' || *p != '\0')
+				if(strcmp(optarg, "all") == 0)
+					prefs.monitor = PANEL_MONITOR_ALL;
+				else if(optarg[0] == '\0' || *p != '\0')
 					return _usage();
 				break;
+			case 'p':
+				pflag = TRUE;
+				break;
 			case 'S':
 				prefs.iconsize = PANEL_ICON_SIZE_SMALL;
 				break;
@@ -107,9 +119,27 @@ int main(int argc, char * argv[])
 		}
 	if(optind != argc)
 		return _usage();
+	/* the report is output to a file if set in the environment */
+	if((profile = getenv(PANEL_PROFILE_ENVIRONMENT)) != NULL
+			|| pflag)
+	{
+		if(profile != NULL && profile[0] == '\0')
+			profile = NULL;
+		if(panel_profile_init(profile, begin) != 0)
+		{
+			error_print(PROGNAME_PANEL);
+			return 2;
+		}
+		panel_profile_end(begin, PROGNAME_PANEL, "gtk_init");
+	}
+	begin = panel_profile_begin();
 	if((panel = panel_new(&prefs)) == NULL)
 		return 2;
+	panel_profile_end(begin, PROGNAME_PANEL, "panel_new");
 	gtk_main();
 	panel_delete(panel);
+	if(panel_profile_report() != 0)
+		error_print(PROGNAME_PANEL);
+	panel_profile_destroy();
 	return 0;
 }
@@ -1,5 +1,5 @@
 /* $Id$ */
-/* Copyright (c) 2009-2023 Pierre Pronchery <khorben@defora.org> */
+/* Copyright (c) 2009-2026 Pierre Pronchery <khorben@defora.org> */
 /* This file is part of DeforaOS Desktop Panel */
 /* This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -18,6 +18,8 @@
 #include <System.h>
 #include <Desktop.h>
 #include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/resource.h>
 #ifdef __NetBSD__
 # include <sys/param.h>
 # include <sys/sysctl.h>
@@ -30,13 +32,25 @@
 #include <stdio.h>
 #include <string.h>
 #include <limits.h>
+#include <signal.h>
 #include <errno.h>
 #include <libintl.h>
+#include <gmodule.h>
+#if GLIB_CHECK_VERSION(2, 36, 0)
+# include <glib-unix.h>
+#endif
 #include <gtk/gtk.h>
 #ifdef GDK_WINDOWING_X11
 # include <gdk/gdkx.h>
+# include <X11/extensions/scrnsaver.h>
 #endif
 #include <X11/X.h>
+#include "control.h"
+#include "profile.h"
+#include "registry.h"
+#include "timer.h"
+#include "usage.h"
+#include "watch.h"
 #include "window.h"
 #include "panel.h"
 #include "../config.h"
@@ -53,24 +67,100 @@
 #ifndef LIBDIR
 # define LIBDIR		PREFIX "/lib"
 #endif
+#ifndef SYSCONFDIR
+# define SYSCONFDIR	PREFIX "/etc"
+#endif
+#define PANEL_CONFIGURE_DELAY	16	/* one frame, in milliseconds	*/
+#define PANEL_LOCK_WAIT		10	/* in seconds, for the lock	*/
 
 
 /* Panel */
 /* private */
 /* types */
+typedef struct _PanelLoad
+{
+	PanelWindow * window;
+	String * applet;
+} PanelLoad;
+
+#if GLIB_CHECK_VERSION(2, 32, 0)
+typedef struct _PanelPrefetch
+{
+	GThread * thread;
+	gint cancel;
+	GMutex mutex;
+	GCond cond;
+	size_t done;			/* plug-ins mapped so far	*/
+
+	String ** paths;
+	GModule ** modules;
+	size_t cnt;
+} PanelPrefetch;
+#endif
+
+typedef struct _PanelMonitor
+{
+	GdkRectangle geometry;
+	PanelAppletHelper helpers[PANEL_POSITION_COUNT];
+	PanelWindow * windows[PANEL_POSITION_COUNT];
+} PanelMonitor;
+
+typedef struct _PanelReload
+{
+	Panel * panel;
+	Config * config;
+	String const * section;
+	gboolean changed;
+
+	/* sections changed */
+	String ** sections;
+	size_t sections_cnt;
+
+	/* variables removed */
+	String ** variables;
+	size_t variables_cnt;
+} PanelReload;
+
 struct _Panel
 {
 	Config * config;
+	PanelWatch * watch;
+	PanelControl * control;
 
 	PanelPrefs prefs;
+	PanelPrefs user;		/* from the command line	*/
 
 	PanelAppletHelper helpers[PANEL_POSITION_COUNT];
 	PanelWindow * windows[PANEL_POSITION_COUNT];
 
+	/* duplicates on the other monitors */
+	PanelMonitor ** monitors;
+	size_t monitors_cnt;
+
+	/* applets being loaded */
+	PanelLoad * loads;
+	size_t loads_cnt;
+	size_t loads_placeholder;	/* next placeholder to display	*/
+	size_t loads_cur;		/* next applet to initialize	*/
+	guint loads_source;
+#if GLIB_CHECK_VERSION(2, 32, 0)
+	PanelPrefetch * prefetch;
+#endif
+
+	PanelTimer * timer;
+	PanelUsage * usage;
+	guint report;			/* reports the usage on SIGUSR1	*/
+	unsigned int paused;
+	int screensaver;		/* first screen saver event	*/
+	guint lock;			/* waits for the lock to start	*/
+
 	GdkScreen * screen;
 	GdkWindow * root;
 	gint root_width;		/* width of the root window	*/
 	gint root_height;		/* height of the root window	*/
+	GdkRectangle monitor;		/* last geometry applied	*/
+	guint configure;
+	unsigned int configure_suppressed;
 	guint source;
 #if 1 /* XXX for tests */
 	guint timeout;
@@ -134,9 +224,19 @@ static char const * _panel_get_applets(Panel * panel, PanelPosition position);
 static char const * _panel_get_section(Panel * panel, PanelPosition position);
 
 /* useful */
+static void _panel_load_cleanup(Panel * panel);
+static void _panel_lock(Panel * panel);
+static void _panel_monitor_delete(PanelMonitor * monitor);
+static gboolean _panel_monitors_changed(Panel * panel);
+#if GLIB_CHECK_VERSION(2, 32, 0)
+static void _panel_prefetch_delete(PanelPrefetch * prefetch);
+#endif
 static void _panel_reset(Panel * panel, GdkRectangle * rect);
+static void _panel_reset_timer(Panel * panel);
 
 /* helpers */
+#define HELPER_LOCK
+#define HELPER_MONITORS
 #include "helper.c"
 
 
@@ -144,33 +244,98 @@ static void _panel_reset(Panel * panel, GdkRectangle * rect);
 /* panel_new */
 static int _new_config(Panel * panel);
 static void _new_helper(Panel * panel, PanelPosition position);
+#ifdef GDK_WINDOWING_X11
+static void _new_screensaver(Panel * panel);
+#endif
 static void _new_prefs(Config * config, GdkScreen * screen, PanelPrefs * prefs,
 		PanelPrefs const * user);
+static void _new_watch(Panel * panel);
+static void _new_control(Panel * panel);
 /* callbacks */
+static void _new_on_watch(void * data);
+static int _new_on_control(void * data, char const * request,
+		GString * response);
+static int _new_on_control_applets(Panel * panel, GString * response);
+static int _new_on_control_help(Panel * panel, GString * response);
+static int _new_on_control_memory(Panel * panel, GString * response);
+static int _new_on_control_reload(Panel * panel, GString * response);
+static int _new_on_control_stats(Panel * panel, GString * response);
+static int _new_on_control_usage(Panel * panel, GString * response);
+static int _new_on_control_windows(Panel * panel, GString * response);
 static int _new_on_message(void * data, uint32_t value1, uint32_t value2,
 		uint32_t value3);
+static void _new_on_message_show(Panel * panel, PanelPosition position,
+		gboolean show);
+#if GLIB_CHECK_VERSION(2, 36, 0)
+static gboolean _new_on_report(gpointer data);
+#endif
 #ifdef GDK_WINDOWING_X11
 static GdkFilterReturn _on_root_event(GdkXEvent * xevent, GdkEvent * event,
 		gpointer data);
+static GdkFilterReturn _event_screensaver_notify(Panel * panel,
+		XScreenSaverNotifyEvent * xssne);
 #endif
 static GdkFilterReturn _event_configure_notify(Panel * panel);
+static gboolean _event_configure_on_timeout(gpointer data);
 
 Panel * panel_new(PanelPrefs const * prefs)
 {
 	Panel * panel;
 	size_t i;
+	gint64 begin;
 
 	if((panel = object_new(sizeof(*panel))) == NULL)
 		return NULL;
 	panel->screen = gdk_screen_get_default();
+	if((panel->timer = panel_timer_new()) == NULL)
+	{
+		object_delete(panel);
+		return NULL;
+	}
+	if((panel->usage = panel_usage_new()) == NULL)
+	{
+		panel_timer_delete(panel->timer);
+		object_delete(panel);
+		return NULL;
+	}
+	panel_timer_set_usage(panel->timer, panel->usage);
+	panel->report = 0;
+	panel->loads = NULL;
+	panel->loads_cnt = 0;
+	panel->loads_placeholder = 0;
+	panel->loads_cur = 0;
+	panel->loads_source = 0;
+#if GLIB_CHECK_VERSION(2, 32, 0)
+	panel->prefetch = NULL;
+#endif
+	panel->paused = 0;
+	panel->screensaver = -1;
+	panel->lock = 0;
+	panel->watch = NULL;
+	panel->control = NULL;
+	if(prefs != NULL)
+		memcpy(&panel->user, prefs, sizeof(panel->user));
+	else
+	{
+		panel->user.iconsize = PANEL_ICON_SIZE_DEFAULT;
+		panel->user.monitor = -1;
+	}
+	begin = panel_profile_begin();
 	if(_new_config(panel) == 0)
-		_new_prefs(panel->config, panel->screen, &panel->prefs, prefs);
+	{
+		_new_prefs(panel->config, panel->screen, &panel->prefs,
+				&panel->user);
+		_new_watch(panel);
+	}
+	panel_profile_end(begin, PROGNAME_PANEL, "config");
 	/* helpers */
 	for(i = 0; i < PANEL_POSITION_COUNT; i++)
 	{
 		panel->windows[i] = NULL;
 		_new_helper(panel, i);
 	}
+	panel->monitors = NULL;
+	panel->monitors_cnt = 0;
 	panel->pr_window = NULL;
 	panel->ab_window = NULL;
 	panel->lk_window = NULL;
@@ -185,6 +350,9 @@ Panel * panel_new(PanelPrefs const * prefs)
 	}
 	/* root window */
 	panel->root = gdk_screen_get_root_window(panel->screen);
+	memset(&panel->monitor, 0, sizeof(panel->monitor));
+	panel->configure = 0;
+	panel->configure_suppressed = 0;
 	panel->source = 0;
 	panel->timeout = 0;
 	/* panel windows */
@@ -197,20 +365,45 @@ Panel * panel_new(PanelPrefs const * prefs)
 	/* messages */
 	desktop_message_register(NULL, PANEL_CLIENT_MESSAGE, _new_on_message,
 			panel);
+	_new_control(panel);
 	/* manage root window events */
 	gdk_window_set_events(panel->root, gdk_window_get_events(panel->root)
 			| GDK_PROPERTY_CHANGE_MASK);
 #ifdef GDK_WINDOWING_X11
 	gdk_window_add_filter(panel->root, _on_root_event, panel);
+	_new_screensaver(panel);
+#endif
+#if GLIB_CHECK_VERSION(2, 36, 0)
+	panel->report = g_unix_signal_add(SIGUSR1, _new_on_report, panel);
 #endif
 	return panel;
 }
 
+#ifdef GDK_WINDOWING_X11
+static void _new_screensaver(Panel * panel)
+{
+	Display * display;
+	int error;
+
+	/* pause the applets while the screen is blanked */
+	display = GDK_DISPLAY_XDISPLAY(gdk_screen_get_display(panel->screen));
+	if(XScreenSaverQueryExtension(display, &panel->screensaver, &error)
+			!= True)
+	{
+		panel->screensaver = -1;
+		return;
+	}
+	XScreenSaverSelectInput(display, GDK_WINDOW_XID(panel->root),
+			ScreenSaverNotifyMask);
+}
+#endif
+
 static int _new_config(Panel * panel)
 {
 	size_t i;
 	gint width;
 	gint height;
+	gint64 begin;
 
 	for(i = 0; i < sizeof(_panel_sizes) / sizeof(*_panel_sizes); i++)
 	{
@@ -224,10 +417,13 @@ static int _new_config(Panel * panel)
 	}
 	if((panel->config = config_new()) == NULL)
 		return -1;
+	begin = panel_profile_begin();
 	if(config_load_preferences(panel->config, PANEL_CONFIG_VENDOR,
 				PACKAGE, PANEL_CONFIG_FILE) != 0)
 		/* we can ignore this error */
 		panel_error(NULL, _("Could not load configuration"), 1);
+	panel_profile_end(begin, PROGNAME_PANEL, "config_load_preferences");
+	_panel_reset_timer(panel);
 	return 0;
 }
 
@@ -278,6 +474,8 @@ static void _new_helper(Panel * panel, PanelPosition position)
 		&& ((p = panel_get_config(panel, NULL, "suspend")) == NULL
 				|| strtol(p, NULL, 0) != 0)
 		? _panel_helper_suspend_dialog : NULL;
+	helper->timeout_add = _panel_helper_timeout_add;
+	helper->timeout_remove = _panel_helper_timeout_remove;
 }
 
 static void _new_prefs(Config * config, GdkScreen * screen, PanelPrefs * prefs,
@@ -296,7 +494,9 @@ static void _new_prefs(Config * config, GdkScreen * screen, PanelPrefs * prefs,
 	if((p = config_get(config, NULL, "monitor")) != NULL)
 	{
 		prefs->monitor = strtol(p, &q, 0);
-		if(p[0] == '\0' || *q != '\0')
+		if(strcmp(p, "all") == 0)
+			prefs->monitor = PANEL_MONITOR_ALL;
+		else if(p[0] == '\0' || *q != '\0')
 			prefs->monitor = -1;
 	}
 #if GTK_CHECK_VERSION(2, 20, 0)
@@ -305,6 +505,202 @@ static void _new_prefs(Config * config, GdkScreen * screen, PanelPrefs * prefs,
 #endif
 }
 
+static void _new_watch(Panel * panel)
+{
+	char const * homedir;
+	String * p;
+
+	/* apply the changes to the preferences as they happen */
+	if((panel->watch = panel_watch_new(_new_on_watch, panel)) == NULL)
+	{
+		/* we can ignore this error */
+		error_print(PROGNAME_PANEL);
+		return;
+	}
+	if(panel_watch_add(panel->watch, SYSCONFDIR "/" PANEL_CONFIG_VENDOR
+				"/" PACKAGE "/" PANEL_CONFIG_FILE) != 0)
+		error_print(PROGNAME_PANEL);
+	if((homedir = getenv("HOME")) == NULL)
+		homedir = g_get_home_dir();
+	if((p = string_new_append(homedir, "/.config/" PANEL_CONFIG_VENDOR
+					"/" PACKAGE "/" PANEL_CONFIG_FILE,
+					NULL)) == NULL
+			|| panel_watch_add(panel->watch, p) != 0)
+		error_print(PROGNAME_PANEL);
+	string_delete(p);
+}
+
+static void _new_control(Panel * panel)
+{
+	String const * p;
+
+	/* queries from panelctl(1), or any other local client */
+	if((p = config_get(panel->config, NULL, "control")) != NULL
+			&& strtol(p, NULL, 0) == 0)
+		return;
+	if((panel->control = panel_control_new(_new_on_control, panel))
+			== NULL)
+		/* we can ignore this error */
+		error_print(PROGNAME_PANEL);
+}
+
+static void _new_on_watch(void * data)
+{
+	Panel * panel = data;
+
+	if(panel_reload(panel) != 0)
+		panel_error(NULL, NULL, 1);
+}
+
+static int _new_on_control(void * data, char const * request,
+		GString * response)
+{
+	const struct
+	{
+		char const * name;
+		int (*callback)(Panel * panel, GString * response);
+	} requests[] =
+	{
+		{ "applets",	_new_on_control_applets	},
+		{ "help",	_new_on_control_help	},
+		{ "memory",	_new_on_control_memory	},
+		{ "reload",	_new_on_control_reload	},
+		{ "stats",	_new_on_control_stats	},
+		{ "usage",	_new_on_control_usage	},
+		{ "windows",	_new_on_control_windows	}
+	};
+	Panel * panel = data;
+	size_t i;
+
+	for(i = 0; i < sizeof(requests) / sizeof(*requests); i++)
+		if(strcmp(requests[i].name, request) == 0)
+			return requests[i].callback(panel, response);
+	return -error_set_code(1, "%s: %s", request, _("Unknown request"));
+}
+
+static int _new_on_control_applets(Panel * panel, GString * response)
+{
+	size_t i;
+	size_t j;
+	size_t cnt;
+
+	for(i = 0; i < PANEL_POSITION_COUNT; i++)
+	{
+		if(panel->windows[i] == NULL)
+			continue;
+		cnt = panel_window_get_applet_count(panel->windows[i]);
+		for(j = 0; j < cnt; j++)
+			g_string_append_printf(response, "%s\t%zu\t%s\n",
+					_panel_get_section(panel, i), j,
+					panel_window_get_applet_name(
+						panel->windows[i], j));
+	}
+	return 0;
+}
+
+static int _new_on_control_help(Panel * panel, GString * response)
+{
+	(void) panel;
+
+	g_string_append(response, "applets\n" "help\n" "memory\n" "reload\n"
+			"stats\n" "usage\n" "windows\n");
+	return 0;
+}
+
+static int _new_on_control_memory(Panel * panel, GString * response)
+{
+	struct rusage ru;
+#if defined(__linux__)
+	FILE * fp;
+	unsigned long size;
+	unsigned long resident;
+#endif
+	(void) panel;
+
+	if(getrusage(RUSAGE_SELF, &ru) != 0)
+		return -error_set_code(1, "%s: %s", "getrusage",
+				strerror(errno));
+	/* in kilobytes */
+	g_string_append_printf(response, "maxrss\t%ld\n",
+			(long)ru.ru_maxrss);
+#if defined(__linux__)
+	if((fp = fopen("/proc/self/statm", "r")) == NULL)
+		return 0;
+	if(fscanf(fp, "%lu %lu", &size, &resident) == 2)
+		g_string_append_printf(response, "rss\t%lu\nvsz\t%lu\n",
+				resident * (sysconf(_SC_PAGESIZE) / 1024),
+				size * (sysconf(_SC_PAGESIZE) / 1024));
+	fclose(fp);
+#endif
+	return 0;
+}
+
+static int _new_on_control_reload(Panel * panel, GString * response)
+{
+	(void) response;
+
+	return panel_reload(panel);
+}
+
+static int _new_on_control_stats(Panel * panel, GString * response)
+{
+	g_string_append_printf(response, "wakeups\t%u\n",
+			panel_timer_get_wakeups(panel->timer));
+	g_string_append_printf(response, "suppressed_resets\t%u\n",
+			panel->configure_suppressed);
+	if(panel->watch != NULL)
+		g_string_append_printf(response, "config_changes\t%u\n",
+				panel_watch_get_changes(panel->watch));
+	g_string_append_printf(response, "paused\t%u\n", panel->paused);
+	g_string_append_printf(response, "monitors\t%zu\n",
+			panel->monitors_cnt + 1);
+	return 0;
+}
+
+static int _new_on_control_usage(Panel * panel, GString * response)
+{
+	PanelUsageStats stats;
+	size_t i;
+
+	/* in milliseconds */
+	g_string_append(response, "# applet\tcalls\twall\tcpu\tlast\tworst"
+			"\toverruns\n");
+	for(i = 0; panel_usage_get_stats(panel->usage, i, &stats) == 0; i++)
+		g_string_append_printf(response,
+				"%s\t%lu\t%.3f\t%.3f\t%.3f\t%.3f\t%lu\n",
+				stats.name, stats.calls, stats.wall / 1000.0,
+				stats.cpu / 1000.0, stats.last / 1000.0,
+				stats.worst / 1000.0, stats.overruns);
+	return 0;
+}
+
+static int _new_on_control_windows(Panel * panel, GString * response)
+{
+	size_t i;
+	size_t j;
+	PanelWindow * window;
+	gint x;
+	gint y;
+	gint width;
+	gint height;
+
+	for(i = 0; i <= panel->monitors_cnt; i++)
+		for(j = 0; j < PANEL_POSITION_COUNT; j++)
+		{
+			window = (i == 0) ? panel->windows[j]
+				: panel->monitors[i - 1]->windows[j];
+			if(window == NULL)
+				continue;
+			panel_window_get_position(window, &x, &y);
+			panel_window_get_size(window, &width, &height);
+			g_string_append_printf(response,
+					"%s\t%zu\t%d\t%d\t%d\t%d\n",
+					_panel_get_section(panel, j), i, x, y,
+					width, height);
+		}
+	return 0;
+}
+
 static int _new_on_message(void * data, uint32_t value1, uint32_t value2,
 		uint32_t value3)
 {
@@ -312,8 +708,6 @@ static int _new_on_message(void * data, uint32_t value1, uint32_t value2,
 	PanelMessage message = value1;
 	PanelMessageShow what;
 	gboolean show;
-	PanelPosition position;
-	PanelWindow * window;
 
 	switch(message)
 	{
@@ -321,29 +715,17 @@ static int _new_on_message(void * data, uint32_t value1, uint32_t value2,
 			what = value2;
 			show = value3;
 			if(what & PANEL_MESSAGE_SHOW_PANEL_BOTTOM)
-			{
-				position = PANEL_POSITION_BOTTOM;
-				if((window = panel->windows[position]) != NULL)
-					panel_window_show(window, show);
-			}
+				_new_on_message_show(panel,
+						PANEL_POSITION_BOTTOM, show);
 			if(what & PANEL_MESSAGE_SHOW_PANEL_LEFT)
-			{
-				position = PANEL_POSITION_LEFT;
-				if((window = panel->windows[position]) != NULL)
-					panel_window_show(window, show);
-			}
+				_new_on_message_show(panel,
+						PANEL_POSITION_LEFT, show);
 			if(what & PANEL_MESSAGE_SHOW_PANEL_RIGHT)
-			{
-				position = PANEL_POSITION_RIGHT;
-				if((window = panel->windows[position]) != NULL)
-					panel_window_show(window, show);
-			}
+				_new_on_message_show(panel,
+						PANEL_POSITION_RIGHT, show);
 			if(what & PANEL_MESSAGE_SHOW_PANEL_TOP)
-			{
-				position = PANEL_POSITION_TOP;
-				if((window = panel->windows[position]) != NULL)
-					panel_window_show(window, show);
-			}
+				_new_on_message_show(panel,
+						PANEL_POSITION_TOP, show);
 			if(what & PANEL_MESSAGE_SHOW_SETTINGS)
 				panel_show_preferences(panel, show);
 			break;
@@ -354,6 +736,31 @@ static int _new_on_message(void * data, uint32_t value1, uint32_t value2,
 	return 0;
 }
 
+static void _new_on_message_show(Panel * panel, PanelPosition position,
+		gboolean show)
+{
+	size_t i;
+
+	if(panel->windows[position] != NULL)
+		panel_window_show(panel->windows[position], show);
+	for(i = 0; i < panel->monitors_cnt; i++)
+		if(panel->monitors[i]->windows[position] != NULL)
+			panel_window_show(panel->monitors[i]->windows[position],
+					show);
+}
+
+#if GLIB_CHECK_VERSION(2, 36, 0)
+static gboolean _new_on_report(gpointer data)
+{
+	Panel * panel = data;
+
+	/* the time spent per applet, on demand */
+	if(panel_usage_report(panel->usage, stderr) != 0)
+		panel_error(NULL, NULL, 1);
+	return TRUE;
+}
+#endif
+
 #ifdef GDK_WINDOWING_X11
 static GdkFilterReturn _on_root_event(GdkXEvent * xevent, GdkEvent * event,
 		gpointer data)
@@ -364,20 +771,76 @@ static GdkFilterReturn _on_root_event(GdkXEvent * xevent, GdkEvent * event,
 
 	if(xe->type == ConfigureNotify)
 		return _event_configure_notify(panel);
+	if(panel->screensaver >= 0
+			&& xe->type == panel->screensaver + ScreenSaverNotify)
+		return _event_screensaver_notify(panel,
+				(XScreenSaverNotifyEvent *)xe);
+	return GDK_FILTER_CONTINUE;
+}
+
+static GdkFilterReturn _event_screensaver_notify(Panel * panel,
+		XScreenSaverNotifyEvent * xssne)
+{
+	if(xssne->state == ScreenSaverOn)
+	{
+		/* the lock requested is now reported by the screen saver */
+		if(panel->lock != 0)
+			g_source_remove(panel->lock);
+		panel->lock = 0;
+		_panel_helper_pause(panel, PANEL_PAUSE_SCREENSAVER, TRUE);
+		return GDK_FILTER_CONTINUE;
+	}
+	_panel_helper_pause(panel, PANEL_PAUSE_SCREENSAVER, FALSE);
+	/* the screen is unlocked, unless still waiting for the lock */
+	if(panel->lock == 0)
+		_panel_helper_pause(panel, PANEL_PAUSE_LOCK, FALSE);
 	return GDK_FILTER_CONTINUE;
 }
 #endif
 
 static GdkFilterReturn _event_configure_notify(Panel * panel)
 {
+	/* coalesce the bursts of events to at most one reset per frame */
+	if(panel->configure != 0)
+		panel->configure_suppressed++;
+	else
+		panel->configure = g_timeout_add(PANEL_CONFIGURE_DELAY,
+				_event_configure_on_timeout, panel);
+	return GDK_FILTER_CONTINUE;
+}
+
+static gboolean _event_configure_on_timeout(gpointer data)
+{
+	Panel * panel = data;
+	GdkRectangle previous;
 	GdkRectangle rect;
 	size_t i;
 
+	panel->configure = 0;
+	memcpy(&previous, &panel->monitor, sizeof(previous));
 	_panel_reset(panel, &rect);
+	/* the geometry of the monitors may not have changed at all */
+	if(rect.x == previous.x && rect.y == previous.y
+			&& rect.width == previous.width
+			&& rect.height == previous.height)
+	{
+		if(_panel_monitors_changed(panel) == FALSE)
+			panel->configure_suppressed++;
+		else if(panel_reset(panel) != 0)
+			panel_error(NULL, NULL, 1);
+		return FALSE;
+	}
+#ifdef DEBUG
+	fprintf(stderr, "DEBUG: %s() %dx%d+%d+%d (%u suppressed)\n", __func__,
+			rect.width, rect.height, rect.x, rect.y,
+			panel->configure_suppressed);
+#endif
 	for(i = 0; i < sizeof(panel->windows) / sizeof(*panel->windows); i++)
 		if(panel->windows[i] != NULL)
 			panel_window_reset(panel->windows[i], &rect);
-	return GDK_FILTER_CONTINUE;
+	if(_panel_monitors_changed(panel) && panel_reset(panel) != 0)
+		panel_error(NULL, NULL, 1);
+	return FALSE;
 }
 
 
@@ -388,13 +851,31 @@ void panel_delete(Panel * panel)
 
 	if(panel->timeout != 0)
 		g_source_remove(panel->timeout);
+	if(panel->configure != 0)
+		g_source_remove(panel->configure);
 	if(panel->source != 0)
 		g_source_remove(panel->source);
+	if(panel->loads_source != 0)
+		g_source_remove(panel->loads_source);
+	if(panel->lock != 0)
+		g_source_remove(panel->lock);
+	if(panel->report != 0)
+		g_source_remove(panel->report);
+	_panel_load_cleanup(panel);
+	for(i = 0; i < panel->monitors_cnt; i++)
+		_panel_monitor_delete(panel->monitors[i]);
+	free(panel->monitors);
 	for(i = 0; i < sizeof(panel->windows) / sizeof(*panel->windows); i++)
 		if(panel->windows[i] != NULL)
 			panel_window_delete(panel->windows[i]);
+	if(panel->control != NULL)
+		panel_control_delete(panel->control);
+	if(panel->watch != NULL)
+		panel_watch_delete(panel->watch);
 	if(panel->config != NULL)
 		config_delete(panel->config);
+	panel_timer_delete(panel->timer);
+	panel_usage_delete(panel->usage);
 	object_delete(panel);
 }
 
@@ -409,6 +890,13 @@ char const * panel_get_config(Panel * panel, char const * section,
 }
 
 
+/* panel_get_suppressed_resets */
+unsigned int panel_get_suppressed_resets(Panel * panel)
+{
+	return panel->configure_suppressed;
+}
+
+
 /* useful */
 /* panel_error */
 static int _error_text(char const * message, int ret);
@@ -491,15 +979,252 @@ int panel_load(Panel * panel, PanelPosition position, char const * applet)
 }
 
 
+/* panel_reload */
+static void _reload_foreach(String const * section, void * data);
+static void _reload_foreach_variable(String const * variable,
+		String const * value, void * data);
+static void _reload_foreach_removed(String const * section, void * data);
+static void _reload_foreach_removed_variable(String const * variable,
+		String const * value, void * data);
+static int _reload_changed(PanelReload * reload, String const * section);
+static void _reload_applets(Panel * panel, PanelReload * reload);
+static void _reload_applets_window(PanelReload * reload, PanelWindow * window);
+static void _reload_cleanup(PanelReload * reload);
+
+int panel_reload(Panel * panel)
+{
+	PanelReload reload;
+	PanelPrefs prefs;
+	size_t i;
+	GdkRectangle rect;
+
+	memset(&reload, 0, sizeof(reload));
+	reload.panel = panel;
+	if((reload.config = config_new()) == NULL)
+		return -1;
+	if(config_load_preferences(reload.config, PANEL_CONFIG_VENDOR,
+				PACKAGE, PANEL_CONFIG_FILE) != 0)
+	{
+		config_delete(reload.config);
+		return -1;
+	}
+	/* only update the values actually changed, in place */
+	config_foreach(panel->config, _reload_foreach_removed, &reload);
+	for(i = 0; i + 1 < reload.variables_cnt; i += 2)
+		if(config_set(panel->config, reload.variables[i],
+					reload.variables[i + 1], NULL) != 0)
+			error_print(PROGNAME_PANEL);
+	reload.section = NULL;
+	config_foreach(reload.config, _reload_foreach, &reload);
+	if(reload.changed == FALSE)
+	{
+		_reload_cleanup(&reload);
+		return 0;
+	}
+#ifdef DEBUG
+	fprintf(stderr, "DEBUG: %s() %lu section(s) changed\n", __func__,
+			(unsigned long)reload.sections_cnt);
+#endif
+	_panel_reset_timer(panel);
+	memcpy(&prefs, &panel->prefs, sizeof(prefs));
+	/* the command line still takes precedence over the defaults */
+	_new_prefs(panel->config, panel->screen, &panel->prefs, &panel->user);
+	if(panel->prefs.monitor != prefs.monitor)
+	{
+		_panel_reset(panel, &rect);
+		for(i = 0; i < sizeof(panel->windows) / sizeof(*panel->windows);
+				i++)
+			if(panel->windows[i] != NULL)
+				panel_window_reset(panel->windows[i], &rect);
+	}
+	_reload_applets(panel, &reload);
+	_reload_cleanup(&reload);
+	return panel_reset(panel);
+}
+
+static void _reload_foreach(String const * section, void * data)
+{
+	PanelReload * reload = data;
+
+	reload->section = section;
+	config_foreach_section(reload->config, section,
+			_reload_foreach_variable, reload);
+}
+
+static void _reload_foreach_variable(String const * variable,
+		String const * value, void * data)
+{
+	PanelReload * reload = data;
+	Panel * panel;
+	String const * p;
+
+	panel = reload->panel;
+	if((p = config_get(panel->config, reload->section, variable)) != NULL
+			&& value != NULL && strcmp(p, value) == 0)
+		return;
+	if(config_set(panel->config, reload->section, variable, value) != 0
+			|| _reload_changed(reload, reload->section) != 0)
+		error_print(PROGNAME_PANEL);
+}
+
+static void _reload_foreach_removed(String const * section, void * data)
+{
+	PanelReload * reload = data;
+
+	reload->section = section;
+	config_foreach_section(reload->panel->config, section,
+			_reload_foreach_removed_variable, reload);
+}
+
+static void _reload_foreach_removed_variable(String const * variable,
+		String const * value, void * data)
+{
+	PanelReload * reload = data;
+	String ** p;
+	(void) value;
+
+	if(config_get(reload->config, reload->section, variable) != NULL)
+		return;
+	/* the configuration cannot be modified while going through it */
+	if((p = realloc(reload->variables, sizeof(*p)
+					* (reload->variables_cnt + 2))) == NULL)
+	{
+		error_set_code(1, "%s", strerror(errno));
+		error_print(PROGNAME_PANEL);
+		return;
+	}
+	reload->variables = p;
+	if((p[reload->variables_cnt] = string_new(reload->section)) == NULL)
+	{
+		error_print(PROGNAME_PANEL);
+		return;
+	}
+	if((p[reload->variables_cnt + 1] = string_new(variable)) == NULL)
+	{
+		string_delete(p[reload->variables_cnt]);
+		error_print(PROGNAME_PANEL);
+		return;
+	}
+	reload->variables_cnt += 2;
+	if(_reload_changed(reload, reload->section) != 0)
+		error_print(PROGNAME_PANEL);
+}
+
+static int _reload_changed(PanelReload * reload, String const * section)
+{
+	String ** p;
+	size_t i;
+
+	reload->changed = TRUE;
+	for(i = 0; i < reload->sections_cnt; i++)
+		if(strcmp(reload->sections[i], section) == 0)
+			return 0;
+	if((p = realloc(reload->sections, sizeof(*p)
+					* (reload->sections_cnt + 1))) == NULL)
+		return -error_set_code(1, "%s", strerror(errno));
+	reload->sections = p;
+	if((p[reload->sections_cnt] = string_new(section)) == NULL)
+		return -1;
+	reload->sections_cnt++;
+	return 0;
+}
+
+static void _reload_applets(Panel * panel, PanelReload * reload)
+{
+	size_t i;
+	size_t j;
+
+	/* re-initialize the applets whose settings changed */
+	for(i = 0; i < sizeof(panel->windows) / sizeof(*panel->windows); i++)
+		if(panel->windows[i] != NULL)
+			_reload_applets_window(reload, panel->windows[i]);
+	for(i = 0; i < panel->monitors_cnt; i++)
+		for(j = 0; j < PANEL_POSITION_COUNT; j++)
+			if(panel->monitors[i]->windows[j] != NULL)
+				_reload_applets_window(reload,
+						panel->monitors[i]->windows[j]);
+}
+
+static void _reload_applets_window(PanelReload * reload, PanelWindow * window)
+{
+	const char prefix[] = "applet::";
+	size_t i;
+	size_t j;
+	char const * p;
+	String * name;
+
+	for(i = 0; (p = panel_window_get_applet_name(window, i)) != NULL;)
+	{
+		/* the applets are configured in their own section */
+		for(j = 0; j < reload->sections_cnt; j++)
+			if(strncmp(reload->sections[j], prefix,
+						sizeof(prefix) - 1) == 0
+					&& strcmp(&reload->sections[j][
+						sizeof(prefix) - 1], p) == 0)
+				break;
+		if(j == reload->sections_cnt)
+		{
+			i++;
+			continue;
+		}
+		if((name = string_new(p)) == NULL)
+		{
+			error_print(PROGNAME_PANEL);
+			i++;
+			continue;
+		}
+		panel_window_remove(window, i);
+		/* ignore errors, the next applet is now at this index */
+		if(panel_window_insert(window, i, name) != 0)
+			error_print(PROGNAME_PANEL);
+		else
+			i++;
+		string_delete(name);
+	}
+}
+
+static void _reload_cleanup(PanelReload * reload)
+{
+	size_t i;
+
+	for(i = 0; i < reload->sections_cnt; i++)
+		string_delete(reload->sections[i]);
+	free(reload->sections);
+	for(i = 0; i < reload->variables_cnt; i++)
+		string_delete(reload->variables[i]);
+	free(reload->variables);
+	config_delete(reload->config);
+}
+
+
 /* panel_reset */
 static GtkIconSize _reset_iconsize(Panel * panel, String const * section);
 static void _reset_window_delete(Panel * panel, PanelPosition position);
 static int _reset_window_new(Panel * panel, PanelAppletHelper * helper,
 		PanelPosition position, GtkIconSize iconsize,
 		GdkRectangle * rect, gboolean focus, gboolean above);
+static int _reset_monitors(Panel * panel, gboolean focus, gboolean above);
+static int _reset_monitors_window(Panel * panel, PanelMonitor * monitor,
+		PanelPosition position, gboolean focus, gboolean above);
+static int _reset_queue(Panel * panel, PanelWindow * window,
+		char const * applet);
+static void _reset_queue_applets(Panel * panel, PanelWindow * window,
+		PanelPosition position);
+static void _reset_update_applets(Panel * panel, PanelWindow * window,
+		PanelPosition position);
+static int _reset_update_applet(PanelWindow * window, size_t index,
+		char const * applet);
+#if GLIB_CHECK_VERSION(2, 32, 0)
+static void _reset_prefetch(Panel * panel);
+static gpointer _reset_prefetch_thread(gpointer data);
+static void _reset_prefetch_wait(Panel * panel, size_t index);
+#endif
 /* callbacks */
 static gboolean _reset_on_idle(gpointer data);
-static void _reset_on_idle_load(Panel * panel, PanelPosition position);
+static gboolean _reset_on_idle_load(gpointer data);
+static void _reset_on_idle_window(Panel * panel, PanelWindow * window,
+		PanelPosition position);
+static void _reset_on_idle_placeholder(PanelLoad * load);
 
 int panel_reset(Panel * panel)
 {
@@ -514,6 +1239,7 @@ int panel_reset(Panel * panel)
 	String const * p;
 	String * s;
 
+	_panel_load_cleanup(panel);
 	_panel_reset(panel, &rect);
 	focus = ((p = panel_get_config(panel, NULL, "accept_focus")) == NULL
 			|| strcmp(p, "1") == 0) ? TRUE : FALSE;
@@ -555,10 +1281,12 @@ int panel_reset(Panel * panel)
 					iconsize, &rect, focus, above) != 0)
 			return -1;
 	}
+	if(_reset_monitors(panel, focus, above) != 0)
+		return -1;
 	/* load applets when idle */
-	if(panel->source != 0)
-		g_source_remove(panel->source);
-	panel->source = g_idle_add(_reset_on_idle, panel);
+	if(panel->loads_source != 0)
+		g_source_remove(panel->loads_source);
+	panel->loads_source = g_idle_add(_reset_on_idle, panel);
 	return 0;
 }
 
@@ -587,6 +1315,10 @@ static int _reset_window_new(Panel * panel, PanelAppletHelper * helper,
 					iconsize, rect)) == NULL)
 		return -1;
 	panel->helpers[position].window = panel->windows[position];
+	panel_window_set_timer(panel->windows[position], panel->timer);
+	panel_window_set_usage(panel->windows[position], panel->usage);
+	panel_window_suspend(panel->windows[position],
+			(panel->paused != 0) ? TRUE : FALSE);
 	panel_window_set_accept_focus(panel->windows[position], focus);
 	panel_window_set_keep_above(panel->windows[position], above);
 	return 0;
@@ -600,21 +1332,105 @@ static void _reset_window_delete(Panel * panel, PanelPosition position)
 	panel->helpers[position].window = NULL;
 }
 
-static gboolean _reset_on_idle(gpointer data)
+static int _reset_monitors(Panel * panel, gboolean focus, gboolean above)
 {
-	Panel * panel = data;
+	size_t cnt = 0;
+	size_t i;
+	PanelMonitor ** p;
+	PanelMonitor * monitor;
 	PanelPosition position;
 
-	panel->source = 0;
-	if(panel->pr_window == NULL)
-		panel_show_preferences(panel, FALSE);
-	for(position = 0; position < PANEL_POSITION_COUNT; position++)
-		if(panel->windows[position] != NULL)
-			_reset_on_idle_load(panel, position);
-	return FALSE;
+	/* duplicate the panels on every other monitor if requested */
+	if(panel->prefs.monitor == PANEL_MONITOR_ALL)
+		cnt = gdk_screen_get_n_monitors(panel->screen) - 1;
+	while(panel->monitors_cnt > cnt)
+		_panel_monitor_delete(panel->monitors[--panel->monitors_cnt]);
+	if(cnt == 0)
+	{
+		free(panel->monitors);
+		panel->monitors = NULL;
+		return 0;
+	}
+	if((p = realloc(panel->monitors, sizeof(*p) * cnt)) == NULL)
+		return -error_set_code(1, "%s", strerror(errno));
+	panel->monitors = p;
+	for(; panel->monitors_cnt < cnt; panel->monitors_cnt++)
+	{
+		if((monitor = object_new(sizeof(*monitor))) == NULL)
+			return -1;
+		for(position = 0; position < PANEL_POSITION_COUNT; position++)
+			monitor->windows[position] = NULL;
+		panel->monitors[panel->monitors_cnt] = monitor;
+	}
+	for(i = 0; i < cnt; i++)
+	{
+		monitor = panel->monitors[i];
+		gdk_screen_get_monitor_geometry(panel->screen, i + 1,
+				&monitor->geometry);
+		for(position = 0; position < PANEL_POSITION_COUNT; position++)
+			if(_reset_monitors_window(panel, monitor, position,
+						focus, above) != 0)
+				return -1;
+	}
+	return 0;
 }
 
-static void _reset_on_idle_load(Panel * panel, PanelPosition position)
+static int _reset_monitors_window(Panel * panel, PanelMonitor * monitor,
+		PanelPosition position, gboolean focus, gboolean above)
+{
+	PanelWindow * window;
+
+	/* follow the panels of the main monitor */
+	if(panel->windows[position] == NULL)
+	{
+		if(monitor->windows[position] != NULL)
+			panel_window_delete(monitor->windows[position]);
+		monitor->windows[position] = NULL;
+		return 0;
+	}
+	if((window = monitor->windows[position]) != NULL)
+		panel_window_reset(window, &monitor->geometry);
+	else
+	{
+		memcpy(&monitor->helpers[position], &panel->helpers[position],
+				sizeof(monitor->helpers[position]));
+		if((window = panel_window_new(&monitor->helpers[position],
+						PANEL_WINDOW_TYPE_NORMAL,
+						position,
+						panel_window_get_icon_size(
+							panel->windows[position]),
+						&monitor->geometry)) == NULL)
+			return -1;
+		monitor->windows[position] = window;
+		monitor->helpers[position].window = window;
+	}
+	panel_window_set_timer(window, panel->timer);
+	panel_window_set_usage(window, panel->usage);
+	panel_window_suspend(window, (panel->paused != 0) ? TRUE : FALSE);
+	panel_window_set_accept_focus(window, focus);
+	panel_window_set_keep_above(window, above);
+	return 0;
+}
+
+static int _reset_queue(Panel * panel, PanelWindow * window,
+		char const * applet)
+{
+	PanelLoad * load;
+
+	if((load = realloc(panel->loads, sizeof(*load)
+					* (panel->loads_cnt + 1))) == NULL)
+		return -error_set_code(1, "%s", strerror(errno));
+	panel->loads = load;
+	load = &panel->loads[panel->loads_cnt];
+	if((load->applet = string_new(applet)) == NULL)
+		return -1;
+	load->window = window;
+	panel->loads_cnt++;
+	return 0;
+}
+
+static void _reset_queue_applets(Panel * panel, PanelWindow * window,
+		PanelPosition position)
 {
 	char const * applets;
 	char * p;
@@ -633,7 +1449,7 @@ static void _reset_on_idle_load(Panel * panel, PanelPosition position)
 	{
 		if(q[i] == '\0')
 		{
-			if(panel_load(panel, position, q) != 0)
+			if(_reset_queue(panel, window, q) != 0)
 				/* ignore errors */
 				error_print(PROGNAME_PANEL);
 			break;
@@ -641,7 +1457,7 @@ static void _reset_on_idle_load(Panel * panel, PanelPosition position)
 		if(q[i++] != ',')
 			continue;
 		q[i - 1] = '\0';
-		if(panel_load(panel, position, q) != 0)
+		if(_reset_queue(panel, window, q) != 0)
 			/* ignore errors */
 			error_print(PROGNAME_PANEL);
 		q += i;
@@ -650,12 +1466,261 @@ static void _reset_on_idle_load(Panel * panel, PanelPosition position)
 	free(p);
 }
 
+static void _reset_update_applets(Panel * panel, PanelWindow * window,
+		PanelPosition position)
+{
+	char const * applets;
+	char * p = NULL;
+	char * q;
+	size_t i;
+	size_t index = 0;
+
+	/* only update what differs from the applets already loaded */
+	if((applets = _panel_get_applets(panel, position)) != NULL
+			&& strlen(applets) > 0
+			&& (p = string_new(applets)) == NULL)
+	{
+		panel_error(panel, NULL, FALSE);
+		return;
+	}
+	for(q = p, i = 0; q != NULL;)
+	{
+		if(q[i] == '\0')
+		{
+			if(_reset_update_applet(window, index, q) == 0)
+				index++;
+			break;
+		}
+		if(q[i++] != ',')
+			continue;
+		q[i - 1] = '\0';
+		if(_reset_update_applet(window, index, q) == 0)
+			index++;
+		q += i;
+		i = 0;
+	}
+	free(p);
+	/* remove the applets left over */
+	for(i = panel_window_get_applet_count(window); i > index; i--)
+		panel_window_remove(window, i - 1);
+}
+
+static int _reset_update_applet(PanelWindow * window, size_t index,
+		char const * applet)
+{
+	size_t i;
+	size_t cnt;
+	char const * p;
+
+	cnt = panel_window_get_applet_count(window);
+	for(i = index; i < cnt; i++)
+		if((p = panel_window_get_applet_name(window, i)) != NULL
+				&& strcmp(p, applet) == 0)
+			break;
+	if(i == index)
+		/* already in place */
+		return 0;
+	if(i < cnt)
+		return panel_window_move(window, i, index);
+	if(panel_window_insert(window, index, applet) == 0)
+		return 0;
+	/* ignore errors */
+	error_print(PROGNAME_PANEL);
+	return -1;
+}
+
+#if GLIB_CHECK_VERSION(2, 32, 0)
+static void _reset_prefetch(Panel * panel)
+{
+#ifdef __APPLE__
+	char const ext[] = ".dylib";
+#else
+	char const ext[] = ".so";
+#endif
+	PanelPrefetch * prefetch;
+	size_t i;
+
+	if(panel->loads_cnt == 0
+			|| (prefetch = object_new(sizeof(*prefetch))) == NULL)
+		return;
+	prefetch->cancel = 0;
+	g_mutex_init(&prefetch->mutex);
+	g_cond_init(&prefetch->cond);
+	prefetch->done = 0;
+	prefetch->paths = malloc(sizeof(*prefetch->paths) * panel->loads_cnt);
+	prefetch->modules = malloc(sizeof(*prefetch->modules)
+			* panel->loads_cnt);
+	prefetch->cnt = 0;
+	if(prefetch->paths != NULL && prefetch->modules != NULL)
+		for(i = 0; i < panel->loads_cnt; i++)
+		{
+			if((prefetch->paths[i] = string_new_append(
+							LIBDIR "/" PACKAGE
+							"/applets/",
+							panel->loads[i].applet,
+							ext, NULL)) == NULL)
+				break;
+			prefetch->modules[i] = NULL;
+			prefetch->cnt++;
+		}
+	prefetch->thread = NULL;
+	if(prefetch->cnt == 0 || (prefetch->thread = g_thread_try_new(
+					"prefetch", _reset_prefetch_thread,
+					prefetch, NULL)) == NULL)
+	{
+		/* this is only an optimization */
+		_panel_prefetch_delete(prefetch);
+		return;
+	}
+	panel->prefetch = prefetch;
+}
+
+static gpointer _reset_prefetch_thread(gpointer data)
+{
+	PanelPrefetch * prefetch = data;
+	size_t i;
+	GModule * module;
+
+	/* map the plug-ins ahead of the main thread */
+	for(i = 0; i < prefetch->cnt && g_atomic_int_get(&prefetch->cancel)
+			== 0; i++)
+	{
+		module = g_module_open(prefetch->paths[i],
+				G_MODULE_BIND_LAZY | G_MODULE_BIND_LOCAL);
+		g_mutex_lock(&prefetch->mutex);
+		prefetch->modules[i] = module;
+		prefetch->done = i + 1;
+		g_cond_broadcast(&prefetch->cond);
+		g_mutex_unlock(&prefetch->mutex);
+	}
+	/* the plug-ins left are not waited for anymore */
+	g_mutex_lock(&prefetch->mutex);
+	prefetch->done = prefetch->cnt;
+	g_cond_broadcast(&prefetch->cond);
+	g_mutex_unlock(&prefetch->mutex);
+	return NULL;
+}
+
+static void _reset_prefetch_wait(Panel * panel, size_t index)
+{
+	PanelPrefetch * prefetch = panel->prefetch;
+
+	/* the plug-in is then already mapped when initializing the applet */
+	if(prefetch == NULL || index >= prefetch->cnt)
+		return;
+	g_mutex_lock(&prefetch->mutex);
+	while(prefetch->done <= index)
+		g_cond_wait(&prefetch->cond, &prefetch->mutex);
+	g_mutex_unlock(&prefetch->mutex);
+}
+#endif
+
+static gboolean _reset_on_idle(gpointer data)
+{
+	Panel * panel = data;
+	PanelPosition position;
+	size_t i;
+
+	panel->loads_source = 0;
+	for(position = 0; position < PANEL_POSITION_COUNT; position++)
+		_reset_on_idle_window(panel, panel->windows[position],
+				position);
+	/* the other monitors follow the main one */
+	for(i = 0; i < panel->monitors_cnt; i++)
+		for(position = 0; position < PANEL_POSITION_COUNT; position++)
+			_reset_on_idle_window(panel,
+					panel->monitors[i]->windows[position],
+					position);
+#if GLIB_CHECK_VERSION(2, 32, 0)
+	_reset_prefetch(panel);
+#endif
+	/* insert the applets one at a time */
+	panel->loads_source = g_idle_add(_reset_on_idle_load, panel);
+	return FALSE;
+}
+
+static gboolean _reset_on_idle_load(gpointer data)
+{
+	Panel * panel = data;
+	PanelLoad * load;
+#if GLIB_CHECK_VERSION(2, 32, 0)
+	gint64 begin;
+#endif
+
+	/* display every placeholder first */
+	if(panel->loads_placeholder < panel->loads_cnt)
+	{
+		load = &panel->loads[panel->loads_placeholder++];
+		_reset_on_idle_placeholder(load);
+		return TRUE;
+	}
+	if(panel->loads_cur < panel->loads_cnt)
+	{
+#if GLIB_CHECK_VERSION(2, 32, 0)
+		begin = panel_profile_begin();
+		_reset_prefetch_wait(panel, panel->loads_cur);
+		panel_profile_end(begin, panel->loads[panel->loads_cur].applet,
+				"prefetch");
+#endif
+		load = &panel->loads[panel->loads_cur++];
+		if(panel_window_append(load->window, load->applet) != 0)
+			/* ignore errors */
+			error_print(PROGNAME_PANEL);
+		else
+			panel_window_show(load->window, TRUE);
+		if(panel->loads_cur < panel->loads_cnt)
+			return TRUE;
+	}
+	panel->loads_source = 0;
+	_panel_load_cleanup(panel);
+	panel_profile_mark(PROGNAME_PANEL, "applets loaded");
+	if(panel_profile_report() != 0)
+		error_print(PROGNAME_PANEL);
+	if(panel->pr_window == NULL)
+		panel_show_preferences(panel, FALSE);
+	return FALSE;
+}
+
+static void _reset_on_idle_window(Panel * panel, PanelWindow * window,
+		PanelPosition position)
+{
+	if(window == NULL)
+		return;
+	if(panel_window_get_applet_count(window) == 0)
+		_reset_queue_applets(panel, window, position);
+	else
+	{
+		_reset_update_applets(panel, window, position);
+		panel_window_show(window, TRUE);
+	}
+}
+
+static void _reset_on_idle_placeholder(PanelLoad * load)
+{
+	PanelWindow * window = load->window;
+	gint64 begin;
+
+	begin = panel_profile_begin();
+	/* only reserve the space, the plug-in is still being mapped */
+	if(panel_window_append_placeholder(window, NULL) != 0)
+		/* ignore errors */
+		error_print(PROGNAME_PANEL);
+	panel_window_show(window, TRUE);
+	panel_profile_end(begin, load->applet, "placeholder");
+}
+
 
 /* panel_save */
 int panel_save(Panel * panel)
 {
-	return config_save_preferences_user(panel->config, PANEL_CONFIG_VENDOR,
+	int ret;
+
+	ret = config_save_preferences_user(panel->config, PANEL_CONFIG_VENDOR,
 			PACKAGE, PANEL_CONFIG_FILE);
+	/* this change is already applied */
+	if(ret == 0 && panel->watch != NULL)
+		panel_watch_update(panel->watch);
+	return ret;
 }
 
 
@@ -948,19 +2013,13 @@ static GtkWidget * _preferences_window_panels(Panel * panel)
 static void _preferences_window_panels_add(GtkListStore * store,
 		char const * name)
 {
-	Plugin * p;
 	PanelAppletDefinition * pad;
 	GtkTreeIter iter;
 	GtkIconTheme * theme;
 	GdkPixbuf * pixbuf = NULL;
 
-	if((p = plugin_new(LIBDIR, PACKAGE, "applets", name)) == NULL)
-		return;
-	if((pad = plugin_lookup(p, "applet")) == NULL)
-	{
-		plugin_delete(p);
+	if((pad = panel_registry_acquire(name)) == NULL)
 		return;
-	}
 	theme = gtk_icon_theme_get_default();
 	if(pad->icon != NULL)
 		pixbuf = gtk_icon_theme_load_icon(theme, pad->icon, 24, 0,
@@ -971,7 +2030,7 @@ static void _preferences_window_panels_add(GtkListStore * store,
 	gtk_list_store_append(store, &iter);
 	gtk_list_store_set(store, &iter, 0, name, 1, pixbuf, 2, _(pad->name),
 			-1);
-	plugin_delete(p);
+	panel_registry_release(pad);
 }
 
 static GtkListStore * _preferences_window_panels_model(void)
@@ -1068,10 +2127,6 @@ static void _preferences_on_response_apply(gpointer data)
 			continue;
 		pad->settings(pa, TRUE, FALSE);
 	}
-	/* remove the applets from every active panel */
-	for(j = 0; j < sizeof(panel->windows) / sizeof(*panel->windows); j++)
-		if(panel->windows[j] != NULL)
-			panel_window_remove_all(panel->windows[j]);
 	panel_reset(panel);
 }
 
@@ -1490,6 +2545,148 @@ static char const * _panel_get_section(Panel * panel, PanelPosition position)
 
 
 /* useful */
+/* panel_load_cleanup */
+static void _panel_load_cleanup(Panel * panel)
+{
+	size_t i;
+	size_t j;
+
+#if GLIB_CHECK_VERSION(2, 32, 0)
+	if(panel->prefetch != NULL)
+		_panel_prefetch_delete(panel->prefetch);
+	panel->prefetch = NULL;
+#endif
+	for(i = 0; i < panel->loads_cnt; i++)
+		string_delete(panel->loads[i].applet);
+	free(panel->loads);
+	panel->loads = NULL;
+	panel->loads_cnt = 0;
+	panel->loads_placeholder = 0;
+	panel->loads_cur = 0;
+	/* the applets interrupted will not be loaded anymore */
+	for(i = 0; i < sizeof(panel->windows) / sizeof(*panel->windows); i++)
+		if(panel->windows[i] != NULL)
+			panel_window_remove_placeholders(panel->windows[i]);
+	for(i = 0; i < panel->monitors_cnt; i++)
+		for(j = 0; j < PANEL_POSITION_COUNT; j++)
+			if(panel->monitors[i]->windows[j] != NULL)
+				panel_window_remove_placeholders(
+						panel->monitors[i]->windows[j]);
+}
+
+
+/* panel_lock */
+static gboolean _lock_is_locked(Panel * panel);
+static gboolean _lock_on_timeout(gpointer data);
+
+static void _panel_lock(Panel * panel)
+{
+	/* the applets are paused for as long as the screen is locked */
+	_panel_helper_pause(panel, PANEL_PAUSE_LOCK, TRUE);
+	if(panel->lock != 0)
+		g_source_remove(panel->lock);
+	panel->lock = g_timeout_add_seconds(PANEL_LOCK_WAIT, _lock_on_timeout,
+			panel);
+}
+
+static gboolean _lock_is_locked(Panel * panel)
+{
+#ifdef GDK_WINDOWING_X11
+	Display * display;
+	XScreenSaverInfo * info;
+	int state = ScreenSaverOff;
+
+	if(panel->screensaver < 0
+			|| (info = XScreenSaverAllocInfo()) == NULL)
+		return FALSE;
+	display = GDK_DISPLAY_XDISPLAY(gdk_screen_get_display(panel->screen));
+	if(XScreenSaverQueryInfo(display, GDK_WINDOW_XID(panel->root), info)
+			!= 0)
+		state = info->state;
+	XFree(info);
+	return (state == ScreenSaverOn) ? TRUE : FALSE;
+#else
+	(void) panel;
+
+	return FALSE;
+#endif
+}
+
+static gboolean _lock_on_timeout(gpointer data)
+{
+	Panel * panel = data;
+
+	panel->lock = 0;
+	/* resumed once the screen saver stops */
+	if(_lock_is_locked(panel))
+		return FALSE;
+	/* nothing reported the lock in the meantime */
+	_panel_helper_pause(panel, PANEL_PAUSE_LOCK, FALSE);
+	return FALSE;
+}
+
+
+/* panel_monitor_delete */
+static void _panel_monitor_delete(PanelMonitor * monitor)
+{
+	size_t i;
+
+	for(i = 0; i < sizeof(monitor->windows) / sizeof(*monitor->windows);
+			i++)
+		if(monitor->windows[i] != NULL)
+			panel_window_delete(monitor->windows[i]);
+	object_delete(monitor);
+}
+
+
+/* panel_monitors_changed */
+static gboolean _panel_monitors_changed(Panel * panel)
+{
+	size_t cnt = 0;
+	size_t i;
+	GdkRectangle rect;
+
+	if(panel->prefs.monitor == PANEL_MONITOR_ALL)
+		cnt = gdk_screen_get_n_monitors(panel->screen) - 1;
+	if(cnt != panel->monitors_cnt)
+		return TRUE;
+	for(i = 0; i < cnt; i++)
+	{
+		gdk_screen_get_monitor_geometry(panel->screen, i + 1, &rect);
+		if(memcmp(&rect, &panel->monitors[i]->geometry, sizeof(rect))
+				!= 0)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+
+#if GLIB_CHECK_VERSION(2, 32, 0)
+/* panel_prefetch_delete */
+static void _panel_prefetch_delete(PanelPrefetch * prefetch)
+{
+	size_t i;
+
+	if(prefetch->thread != NULL)
+	{
+		g_atomic_int_set(&prefetch->cancel, 1);
+		g_thread_join(prefetch->thread);
+	}
+	for(i = 0; i < prefetch->cnt; i++)
+	{
+		if(prefetch->modules[i] != NULL)
+			g_module_close(prefetch->modules[i]);
+		string_delete(prefetch->paths[i]);
+	}
+	free(prefetch->modules);
+	free(prefetch->paths);
+	g_cond_clear(&prefetch->cond);
+	g_mutex_clear(&prefetch->mutex);
+	object_delete(prefetch);
+}
+#endif
+
+
 /* panel_reset */
 static void _panel_reset(Panel * panel, GdkRectangle * rect)
 {
@@ -1499,4 +2696,33 @@ static void _panel_reset(Panel * panel, GdkRectangle * rect)
 			? panel->prefs.monitor : 0, rect);
 	panel->root_height = rect->height;
 	panel->root_width = rect->width;
+	memcpy(&panel->monitor, rect, sizeof(*rect));
+}
+
+
+/* panel_reset_timer */
+static void _panel_reset_timer(Panel * panel)
+{
+	char const * p;
+	char * q;
+	unsigned long slack;
+	unsigned long budget;
+
+	/* allow the sampling of applets to be delayed to save wakeups */
+	if((p = config_get(panel->config, NULL, "timer_slack")) != NULL)
+	{
+		slack = strtoul(p, &q, 0);
+		if(p[0] != '\0' && *q == '\0')
+			panel_timer_set_slack(panel->timer, slack);
+	}
+	/* report the applets exceeding this budget, in milliseconds */
+	if((p = config_get(panel->config, NULL, "watchdog")) == NULL)
+		panel_usage_set_budget(panel->usage,
+				PANEL_USAGE_BUDGET_DEFAULT);
+	else
+	{
+		budget = strtoul(p, &q, 0);
+		if(p[0] != '\0' && *q == '\0')
+			panel_usage_set_budget(panel->usage, budget);
+	}
 }
@@ -1,5 +1,5 @@
 /* $Id$ */
-/* Copyright (c) 2009-2021 Pierre Pronchery <khorben@defora.org> */
+/* Copyright (c) 2009-2026 Pierre Pronchery <khorben@defora.org> */
 /* This file is part of DeforaOS Desktop Panel */
 /* This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -26,6 +26,12 @@
 
 /* Panel */
 /* types */
+typedef enum _PanelPause
+{
+	PANEL_PAUSE_LOCK	= 0x1,
+	PANEL_PAUSE_SCREENSAVER	= 0x2
+} PanelPause;
+
 typedef struct _PanelPrefs
 {
 	String const * iconsize;
@@ -45,6 +51,8 @@ typedef struct _PanelPrefs
 # define PANEL_ICON_SIZE_SMALLER	"panel-smaller"
 # define PANEL_ICON_SIZE_LARGE		"panel-large"
 
+# define PANEL_MONITOR_ALL		-2
+
 
 /* functions */
 Panel * panel_new(PanelPrefs const * prefs);
@@ -53,10 +61,12 @@ void panel_delete(Panel * panel);
 /* accessors */
 String const * panel_get_config(Panel * panel, String const * section,
 		String const * variable);
+unsigned int panel_get_suppressed_resets(Panel * panel);
 
 /* useful */
 int panel_error(Panel * panel, String const * message, int ret);
 int panel_load(Panel * panel, PanelPosition position, String const * applet);
+int panel_reload(Panel * panel);
 int panel_reset(Panel * panel);
 int panel_save(Panel * panel);
 
@@ -1,5 +1,5 @@
 /* $Id$ */
-/* Copyright (c) 2011-2018 Pierre Pronchery <khorben@defora.org> */
+/* Copyright (c) 2011-2026 Pierre Pronchery <khorben@defora.org> */
 /* This file is part of DeforaOS Desktop Panel */
 /* This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -15,13 +15,19 @@
 
 
 
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 #include <unistd.h>
 #include <stdio.h>
 #include <string.h>
+#include <errno.h>
 #include <locale.h>
 #include <libintl.h>
 #include <gtk/gtk.h>
+#include <System.h>
 #include <Desktop.h>
+#include "control.h"
 #include "panel.h"
 #include "../config.h"
 #define _(string) gettext(string)
@@ -45,6 +51,7 @@
 /* private */
 /* prototypes */
 static int _panelctl(PanelMessageShow what, gboolean show);
+static int _panelctl_query(char const * query);
 
 static int _error(char const * message, int ret);
 static int _usage(void);
@@ -59,6 +66,87 @@ static int _panelctl(PanelMessageShow what, gboolean show)
 }
 
 
+/* panelctl_query */
+static int _query_connect(void);
+static int _query_response(FILE * fp);
+
+static int _panelctl_query(char const * query)
+{
+	int ret;
+	int fd;
+	FILE * fp;
+
+	if((fd = _query_connect()) < 0)
+		return -1;
+	if((fp = fdopen(fd, "r+")) == NULL)
+	{
+		close(fd);
+		return -_error("fdopen", 1);
+	}
+	if(fprintf(fp, "%s\n", query) < 0 || fflush(fp) != 0)
+		ret = -_error("fprintf", 1);
+	else
+		ret = _query_response(fp);
+	fclose(fp);
+	return ret;
+}
+
+static int _query_connect(void)
+{
+	String * path;
+	struct sockaddr_un sa;
+	int fd;
+
+	if((path = panel_control_get_path()) == NULL)
+	{
+		error_print(PROGNAME_PANELCTL);
+		return -1;
+	}
+	memset(&sa, 0, sizeof(sa));
+	sa.sun_family = AF_UNIX;
+	snprintf(sa.sun_path, sizeof(sa.sun_path), "%s", path);
+	if((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+	{
+		string_delete(path);
+		return -_error("socket", 1);
+	}
+	if(connect(fd, (struct sockaddr *)&sa, sizeof(sa)) != 0)
+	{
+		_error(path, 1);
+		string_delete(path);
+		close(fd);
+		return -1;
+	}
+	string_delete(path);
+	return fd;
+}
+
+static int _query_response(FILE * fp)
+{
+	char buf[BUFSIZ];
+
+	/* output everything until the status line */
+	while(fgets(buf, sizeof(buf), fp) != NULL)
+	{
+		if(strcmp(buf, PANEL_CONTROL_OK "\n") == 0)
+			return 0;
+		if(strncmp(buf, PANEL_CONTROL_ERROR ": ",
+					sizeof(PANEL_CONTROL_ERROR ": ") - 1)
+				== 0)
+		{
+			fprintf(stderr, "%s: %s", PROGNAME_PANELCTL,
+					&buf[sizeof(PANEL_CONTROL_ERROR ": ")
+					- 1]);
+			return -1;
+		}
+		fputs(buf, stdout);
+	}
+	fprintf(stderr, "%s: %s\n", PROGNAME_PANELCTL,
+			_("Unexpected end of the response"));
+	return -1;
+}
+
+
 /* error */
 static int _error(char const * message, int ret)
 {
@@ -72,6 +160,7 @@ static int _error(char const * message, int ret)
 static int _usage(void)
 {
 	fprintf(stderr, _("Usage: %s [-B|-L|-R|-S|-T|-b|-l|-r|-t]\n"
+"       %s -q query\n"
 "  -B	Show the bottom panel\n"
 "  -L	Show the left panel\n"
 "  -R	Show the right panel\n"
@@ -79,8 +168,9 @@ static int _usage(void)
 "  -T	Show the top panel\n"
 "  -b	Hide the bottom panel\n"
 "  -l	Hide the left panel\n"
+"  -q	Query the panel (\"help\" for a list of queries)\n"
 "  -r	Hide the right panel\n"
-"  -t	Hide the top panel\n"), PROGNAME_PANELCTL);
+"  -t	Hide the top panel\n"), PROGNAME_PANELCTL, PROGNAME_PANELCTL);
 	return 1;
 }
 
@@ -93,13 +183,14 @@ int main(int argc, char * argv[])
 	int o;
 	unsigned int what = 0;
 	gboolean show = TRUE;
+	char const * query = NULL;
 
 	if(setlocale(LC_ALL, "") == NULL)
 		_error("setlocale", 1);
 	bindtextdomain(PACKAGE, LOCALEDIR);
 	textdomain(PACKAGE);
 	gtk_init(&argc, &argv);
-	while((o = getopt(argc, argv, "BLRSTblrt")) != -1)
+	while((o = getopt(argc, argv, "BLRSTblq:rt")) != -1)
 		switch(o)
 		{
 			case 'B':
@@ -142,6 +233,9 @@ int main(int argc, char * argv[])
 					: what | PANEL_MESSAGE_SHOW_PANEL_LEFT;
 				show = FALSE;
 				break;
+			case 'q':
+				query = optarg;
+				break;
 			case 'r':
 				what = show ? PANEL_MESSAGE_SHOW_PANEL_RIGHT
 					: what | PANEL_MESSAGE_SHOW_PANEL_RIGHT;
@@ -155,7 +249,11 @@ int main(int argc, char * argv[])
 			default:
 				return _usage();
 		}
-	if(argc != optind || what == 0)
+	if(argc != optind || (query != NULL && what != 0))
+		return _usage();
+	if(query != NULL)
+		return (_panelctl_query(query) == 0) ? 0 : 2;
+	if(what == 0)
 		return _usage();
 	return (_panelctl(what, show) == 0) ? 0 : 2;
 }
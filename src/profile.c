@@ -0,0 +1,192 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Panel */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#include <System.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include "profile.h"
+
+
+/* PanelProfile */
+/* private */
+/* types */
+typedef struct _PanelProfileRecord
+{
+	gint64 time;			/* since the start, in microseconds */
+	gint64 duration;		/* in microseconds		*/
+	String * subject;
+	char const * phase;
+} PanelProfileRecord;
+
+typedef struct _PanelProfile
+{
+	gboolean enabled;
+	gint64 start;			/* monotonic, in microseconds	*/
+	String * filename;		/* the standard error if NULL	*/
+
+	PanelProfileRecord * records;
+	size_t records_cnt;
+	size_t reported;
+} PanelProfile;
+
+
+/* variables */
+static PanelProfile _profile;
+
+
+/* prototypes */
+static void _panel_profile_record(gint64 time, gint64 duration,
+		char const * subject, char const * phase);
+
+
+/* public */
+/* functions */
+/* panel_profile_init */
+int panel_profile_init(char const * filename, gint64 start)
+{
+	if(_profile.enabled)
+		return 0;
+	memset(&_profile, 0, sizeof(_profile));
+	if(filename != NULL && (_profile.filename = string_new(filename))
+			== NULL)
+		return -1;
+	_profile.start = start;
+	_profile.enabled = TRUE;
+	return 0;
+}
+
+
+/* panel_profile_destroy */
+void panel_profile_destroy(void)
+{
+	size_t i;
+
+	if(_profile.enabled == FALSE)
+		return;
+	for(i = 0; i < _profile.records_cnt; i++)
+		string_delete(_profile.records[i].subject);
+	free(_profile.records);
+	string_delete(_profile.filename);
+	memset(&_profile, 0, sizeof(_profile));
+}
+
+
+/* accessors */
+/* panel_profile_is_enabled */
+gboolean panel_profile_is_enabled(void)
+{
+	return _profile.enabled;
+}
+
+
+/* useful */
+/* panel_profile_begin */
+gint64 panel_profile_begin(void)
+{
+	return _profile.enabled ? g_get_monotonic_time() : 0;
+}
+
+
+/* panel_profile_end */
+void panel_profile_end(gint64 begin, char const * subject, char const * phase)
+{
+	if(_profile.enabled == FALSE)
+		return;
+	_panel_profile_record(begin, g_get_monotonic_time() - begin, subject,
+			phase);
+}
+
+
+/* panel_profile_mark */
+void panel_profile_mark(char const * subject, char const * phase)
+{
+	if(_profile.enabled == FALSE)
+		return;
+	_panel_profile_record(g_get_monotonic_time(), 0, subject, phase);
+}
+
+
+/* panel_profile_report */
+int panel_profile_report(void)
+{
+	FILE * fp = stderr;
+	PanelProfileRecord * r;
+	size_t i;
+	size_t j;
+	gint64 total;
+
+	if(_profile.enabled == FALSE
+			|| _profile.reported == _profile.records_cnt)
+		return 0;
+	if(_profile.filename != NULL && (fp = fopen(_profile.filename,
+					(_profile.reported == 0) ? "w" : "a"))
+			== NULL)
+		return -error_set_code(1, "%s: %s", _profile.filename,
+				strerror(errno));
+	if(_profile.reported == 0)
+		fputs("# time (ms)\tduration (ms)\tsubject\tphase\n", fp);
+	for(i = _profile.reported; i < _profile.records_cnt; i++)
+	{
+		r = &_profile.records[i];
+		fprintf(fp, "%.3f\t%.3f\t%s\t%s\n", r->time / 1000.0,
+				r->duration / 1000.0, r->subject, r->phase);
+	}
+	/* breakdown per subject */
+	for(i = 0; i < _profile.records_cnt; i++)
+	{
+		r = &_profile.records[i];
+		for(j = 0; j < i; j++)
+			if(strcmp(_profile.records[j].subject, r->subject) == 0)
+				break;
+		if(j < i)
+			continue;
+		for(total = 0, j = i; j < _profile.records_cnt; j++)
+			if(strcmp(_profile.records[j].subject, r->subject) == 0)
+				total += _profile.records[j].duration;
+		fprintf(fp, "# total\t%.3f\t%s\n", total / 1000.0, r->subject);
+	}
+	_profile.reported = _profile.records_cnt;
+	if(fp != stderr && fclose(fp) != 0)
+		return -error_set_code(1, "%s: %s", _profile.filename,
+				strerror(errno));
+	return 0;
+}
+
+
+/* private */
+/* functions */
+/* panel_profile_record */
+static void _panel_profile_record(gint64 time, gint64 duration,
+		char const * subject, char const * phase)
+{
+	PanelProfileRecord * r;
+
+	if((r = realloc(_profile.records, sizeof(*r)
+					* (_profile.records_cnt + 1))) == NULL)
+		return;
+	_profile.records = r;
+	r = &_profile.records[_profile.records_cnt];
+	if((r->subject = string_new((subject != NULL) ? subject : ""))
+			== NULL)
+		return;
+	r->time = time - _profile.start;
+	r->duration = duration;
+	r->phase = phase;
+	_profile.records_cnt++;
+}
@@ -0,0 +1,43 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Panel */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#ifndef PANEL_PROFILE_H
+# define PANEL_PROFILE_H
+
+# include <glib.h>
+
+
+/* PanelProfile */
+/* constants */
+# define PANEL_PROFILE_ENVIRONMENT	"PANEL_PROFILE"
+
+
+/* functions */
+int panel_profile_init(char const * filename, gint64 start);
+void panel_profile_destroy(void);
+
+/* accessors */
+gboolean panel_profile_is_enabled(void);
+
+/* useful */
+gint64 panel_profile_begin(void);
+void panel_profile_end(gint64 begin, char const * subject, char const * phase);
+void panel_profile_mark(char const * subject, char const * phase);
+
+int panel_profile_report(void);
+
+#endif /* !PANEL_PROFILE_H */
@@ -0,0 +1,331 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Panel */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#include <System.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#ifdef DEBUG
+# include <stdio.h>
+#endif
+#include <gtk/gtk.h>
+#if defined(GDK_WINDOWING_X11)
+# if GTK_CHECK_VERSION(3, 0, 0)
+#  include <gtk/gtkx.h>
+# else
+#  include <gdk/gdkx.h>
+# endif
+# include <X11/Xlib-xcb.h>
+#endif
+#include "../include/Panel/properties.h"
+
+
+/* PanelProperties */
+/* private */
+/* types */
+typedef struct _PanelPropertiesRequest
+{
+	Atom type;
+#if defined(GDK_WINDOWING_X11)
+	xcb_get_property_cookie_t cookie;
+#endif
+	gboolean collected;
+
+	/* reply */
+	int res;			/* as for panel_properties_get() */
+	Atom actual;
+	int format;
+	unsigned long cnt;
+	unsigned long remaining;
+	void * data;
+} PanelPropertiesRequest;
+
+struct _PanelProperties
+{
+	GdkDisplay * display;
+#if defined(GDK_WINDOWING_X11)
+	xcb_connection_t * connection;
+#endif
+
+	PanelPropertiesRequest * requests;
+	size_t requests_cnt;
+};
+
+
+/* prototypes */
+static PanelPropertiesRequest * _panel_properties_collect(
+		PanelProperties * properties, int index);
+
+
+/* public */
+/* functions */
+/* panel_properties_new */
+PanelProperties * panel_properties_new(GdkDisplay * display)
+{
+#if defined(GDK_WINDOWING_X11)
+	PanelProperties * properties;
+
+# if GTK_CHECK_VERSION(3, 0, 0)
+	if(!GDK_IS_X11_DISPLAY(display))
+	{
+		error_set_code(-ENOSYS, "%s", "X11 support not detected");
+		return NULL;
+	}
+# endif
+	if((properties = object_new(sizeof(*properties))) == NULL)
+		return NULL;
+	properties->display = display;
+	/* shares the connection (and sequence numbers) of Xlib */
+	properties->connection = XGetXCBConnection(GDK_DISPLAY_XDISPLAY(
+				display));
+	properties->requests = NULL;
+	properties->requests_cnt = 0;
+	return properties;
+#else
+	(void) display;
+
+	error_set_code(-ENOSYS, "%s", "X11 support not detected");
+	return NULL;
+#endif
+}
+
+
+/* panel_properties_delete */
+void panel_properties_delete(PanelProperties * properties)
+{
+	size_t i;
+
+	for(i = 0; i < properties->requests_cnt; i++)
+	{
+#if defined(GDK_WINDOWING_X11)
+		/* the replies still pending are dropped by XCB */
+		if(properties->requests[i].collected == FALSE)
+			xcb_discard_reply(properties->connection,
+					properties->requests[i].cookie.sequence);
+#endif
+		free(properties->requests[i].data);
+	}
+	free(properties->requests);
+	object_delete(properties);
+}
+
+
+/* accessors */
+/* panel_properties_get */
+int panel_properties_get(PanelProperties * properties, int index,
+		unsigned long * cnt, void * data)
+{
+	PanelPropertiesRequest * request;
+
+	if((request = _panel_properties_collect(properties, index)) == NULL)
+		return -1;
+	if(request->res != 0)
+		return request->res;
+	*cnt = request->cnt;
+	*(void **)data = request->data;
+	return 0;
+}
+
+
+/* panel_properties_get_remaining */
+unsigned long panel_properties_get_remaining(PanelProperties * properties,
+		int index)
+{
+	PanelPropertiesRequest * request;
+
+	if((request = _panel_properties_collect(properties, index)) == NULL)
+		return 0;
+	return request->remaining;
+}
+
+
+/* panel_properties_get_text */
+char * panel_properties_get_text(PanelProperties * properties, int index)
+{
+#if defined(GDK_WINDOWING_X11)
+	PanelPropertiesRequest * request;
+	char * ret = NULL;
+	int cnt;
+	char ** list;
+
+	if((request = _panel_properties_collect(properties, index)) == NULL
+			|| request->res != 0 || request->format != 8)
+		return NULL;
+	if(request->actual == gdk_x11_get_xatom_by_name_for_display(
+				properties->display, "UTF8_STRING"))
+		return g_utf8_validate(request->data, request->cnt, NULL)
+			? g_strndup(request->data, request->cnt) : NULL;
+	/* convert from the encoding of the property */
+	if((cnt = gdk_text_property_to_utf8_list_for_display(
+					properties->display,
+					gdk_x11_xatom_to_atom_for_display(
+						properties->display,
+						request->actual),
+					request->format, request->data,
+					request->cnt, &list)) > 0)
+	{
+		ret = list[0];
+		list[0] = NULL;
+		g_strfreev(list);
+	}
+	return ret;
+#else
+	(void) properties;
+	(void) index;
+
+	return NULL;
+#endif
+}
+
+
+/* useful */
+/* panel_properties_add */
+int panel_properties_add(PanelProperties * properties, Window window,
+		Atom property, Atom type)
+{
+	return panel_properties_add_range(properties, window, property, type,
+			0, G_MAXINT32);
+}
+
+
+/* panel_properties_add_range */
+int panel_properties_add_range(PanelProperties * properties, Window window,
+		Atom property, Atom type, unsigned long offset,
+		unsigned long length)
+{
+#if defined(GDK_WINDOWING_X11)
+	PanelPropertiesRequest * p;
+
+# ifdef DEBUG
+	fprintf(stderr, "DEBUG: %s(properties, %lu, %lu, %lu, %lu, %lu)\n",
+			__func__, window, property, type, offset, length);
+# endif
+	if((p = realloc(properties->requests, sizeof(*p)
+					* (properties->requests_cnt + 1)))
+			== NULL)
+		return -error_set_code(1, "%s", strerror(errno));
+	properties->requests = p;
+	p = &properties->requests[properties->requests_cnt];
+	p->type = type;
+	/* the request is only sent, the reply is waited for when needed */
+	p->cookie = xcb_get_property(properties->connection, 0, window,
+			property, type, offset, length);
+	p->collected = FALSE;
+	p->res = -1;
+	p->actual = None;
+	p->format = 0;
+	p->cnt = 0;
+	p->remaining = 0;
+	p->data = NULL;
+	return properties->requests_cnt++;
+#else
+	(void) properties;
+	(void) window;
+	(void) property;
+	(void) type;
+	(void) offset;
+	(void) length;
+
+	return -error_set_code(1, "%s", strerror(ENOSYS));
+#endif
+}
+
+
+/* private */
+/* functions */
+/* panel_properties_collect */
+static PanelPropertiesRequest * _panel_properties_collect(
+		PanelProperties * properties, int index)
+{
+	PanelPropertiesRequest * request;
+#if defined(GDK_WINDOWING_X11)
+	xcb_get_property_reply_t * reply;
+	xcb_generic_error_t * error = NULL;
+	unsigned char * value;
+	int len;
+	unsigned long i;
+#endif
+
+	if(index < 0 || (size_t)index >= properties->requests_cnt)
+	{
+		error_set_code(1, "%s", strerror(ERANGE));
+		return NULL;
+	}
+	request = &properties->requests[index];
+	if(request->collected)
+		return request;
+	request->collected = TRUE;
+#if defined(GDK_WINDOWING_X11)
+	/* flushes the requests still pending, if any */
+	if((reply = xcb_get_property_reply(properties->connection,
+					request->cookie, &error)) == NULL)
+	{
+		free(error);
+		return request;
+	}
+	request->actual = reply->type;
+	request->format = reply->format;
+	request->remaining = reply->bytes_after;
+	if(request->type != AnyPropertyType && reply->type != request->type)
+	{
+		request->res = 1;
+		free(reply);
+		return request;
+	}
+	value = xcb_get_property_value(reply);
+	len = xcb_get_property_value_length(reply);
+	/* use the layout of XGetWindowProperty() for the callers */
+	switch(reply->format)
+	{
+		case 8:
+			request->cnt = len;
+			if((request->data = malloc(len + 1)) != NULL)
+			{
+				memcpy(request->data, value, len);
+				((char *)request->data)[len] = '\0';
+			}
+			break;
+		case 16:
+			request->cnt = len / sizeof(uint16_t);
+			if((request->data = malloc(sizeof(short)
+							* (request->cnt + 1)))
+					!= NULL)
+				for(i = 0; i < request->cnt; i++)
+					((short *)request->data)[i]
+						= ((uint16_t *)value)[i];
+			break;
+		case 32:
+			request->cnt = len / sizeof(uint32_t);
+			if((request->data = malloc(sizeof(long)
+							* (request->cnt + 1)))
+					!= NULL)
+				for(i = 0; i < request->cnt; i++)
+					((unsigned long *)request->data)[i]
+						= ((uint32_t *)value)[i];
+			break;
+		default:
+			/* the property does not exist */
+			request->cnt = 0;
+			request->data = malloc(1);
+			break;
+	}
+	free(reply);
+	if(request->data != NULL)
+		request->res = 0;
+#endif
+	return request;
+}
@@ -0,0 +1,132 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Panel */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#include <System.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#ifdef DEBUG
+# include <stdio.h>
+#endif
+#include "profile.h"
+#include "registry.h"
+#include "../config.h"
+
+/* constants */
+#ifndef PREFIX
+# define PREFIX		"/usr/local"
+#endif
+#ifndef LIBDIR
+# define LIBDIR		PREFIX "/lib"
+#endif
+
+
+/* PanelRegistry */
+/* private */
+/* types */
+typedef struct _PanelRegistryApplet
+{
+	String * name;
+	Plugin * plugin;
+	PanelAppletDefinition * pad;
+	unsigned int refcount;
+} PanelRegistryApplet;
+
+
+/* variables */
+static PanelRegistryApplet * _registry = NULL;
+static size_t _registry_cnt = 0;
+
+
+/* public */
+/* functions */
+/* panel_registry_acquire */
+PanelAppletDefinition * panel_registry_acquire(char const * applet)
+{
+	PanelRegistryApplet * pra;
+	size_t i;
+	gint64 begin;
+
+	for(i = 0; i < _registry_cnt; i++)
+		if(strcmp(_registry[i].name, applet) == 0)
+		{
+			_registry[i].refcount++;
+			return _registry[i].pad;
+		}
+	if((pra = realloc(_registry, sizeof(*pra) * (_registry_cnt + 1)))
+			== NULL)
+	{
+		error_set_code(1, "%s", strerror(errno));
+		return NULL;
+	}
+	_registry = pra;
+	pra = &_registry[_registry_cnt];
+	if((pra->name = string_new(applet)) == NULL)
+		return NULL;
+	begin = panel_profile_begin();
+	pra->plugin = plugin_new(LIBDIR, PACKAGE, "applets", applet);
+	panel_profile_end(begin, applet, "plugin_new");
+	if(pra->plugin == NULL)
+	{
+		string_delete(pra->name);
+		return NULL;
+	}
+	begin = panel_profile_begin();
+	pra->pad = plugin_lookup(pra->plugin, "applet");
+	panel_profile_end(begin, applet, "plugin_lookup");
+	if(pra->pad == NULL)
+	{
+		plugin_delete(pra->plugin);
+		string_delete(pra->name);
+		return NULL;
+	}
+	pra->refcount = 1;
+	_registry_cnt++;
+#ifdef DEBUG
+	fprintf(stderr, "DEBUG: %s(\"%s\") loaded\n", __func__, applet);
+#endif
+	return pra->pad;
+}
+
+
+/* panel_registry_release */
+void panel_registry_release(PanelAppletDefinition * pad)
+{
+	size_t i;
+	PanelRegistryApplet * pra;
+
+	for(i = 0; i < _registry_cnt; i++)
+		if(_registry[i].pad == pad)
+			break;
+	if(i == _registry_cnt)
+		return;
+	pra = &_registry[i];
+	if(--pra->refcount > 0)
+		return;
+	/* unload the plug-in along with its last instance */
+#ifdef DEBUG
+	fprintf(stderr, "DEBUG: %s(\"%s\") unloaded\n", __func__, pra->name);
+#endif
+	plugin_delete(pra->plugin);
+	string_delete(pra->name);
+	memmove(pra, &pra[1], sizeof(*pra) * (_registry_cnt - i - 1));
+	if(--_registry_cnt == 0)
+	{
+		free(_registry);
+		_registry = NULL;
+	}
+}
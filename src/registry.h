@@ -0,0 +1,29 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Panel */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#ifndef PANEL_REGISTRY_H
+# define PANEL_REGISTRY_H
+
+# include "../include/Panel/applet.h"
+
+
+/* PanelRegistry */
+/* functions */
+PanelAppletDefinition * panel_registry_acquire(char const * applet);
+void panel_registry_release(PanelAppletDefinition * pad);
+
+#endif /* !PANEL_REGISTRY_H */
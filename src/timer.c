@@ -0,0 +1,377 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Panel */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#include <System.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#ifdef DEBUG
+# include <stdio.h>
+#endif
+#include "timer.h"
+
+
+/* PanelTimer */
+/* private */
+/* types */
+typedef struct _PanelTimerSource
+{
+	guint id;
+	guint interval;			/* in milliseconds		*/
+	gint64 deadline;		/* monotonic, in microseconds	*/
+	GSourceFunc callback;		/* NULL once removed		*/
+	gpointer data;
+	gboolean suspended;
+} PanelTimerSource;
+
+struct _PanelTimer
+{
+	guint slack;			/* in milliseconds		*/
+	guint id;
+	unsigned int wakeups;
+	PanelUsage * usage;
+
+	PanelTimerSource * sources;
+	size_t sources_cnt;
+	gboolean dispatching;
+
+	/* the data suspended, for the sources added meanwhile */
+	gpointer * suspended;
+	size_t suspended_cnt;
+
+	/* the only actual timeout */
+	guint source;
+	gint64 source_deadline;
+};
+
+
+/* prototypes */
+static gint64 _panel_timer_align(gint64 deadline, guint interval);
+static void _panel_timer_cleanup(PanelTimer * timer);
+static gboolean _panel_timer_is_suspended(PanelTimer * timer, gpointer data);
+static void _panel_timer_schedule(PanelTimer * timer);
+
+/* callbacks */
+static gboolean _panel_timer_on_timeout(gpointer data);
+
+
+/* public */
+/* functions */
+/* panel_timer_new */
+PanelTimer * panel_timer_new(void)
+{
+	PanelTimer * timer;
+
+	if((timer = object_new(sizeof(*timer))) == NULL)
+		return NULL;
+	timer->slack = PANEL_TIMER_SLACK_DEFAULT;
+	timer->id = 0;
+	timer->wakeups = 0;
+	timer->usage = NULL;
+	timer->sources = NULL;
+	timer->sources_cnt = 0;
+	timer->dispatching = FALSE;
+	timer->suspended = NULL;
+	timer->suspended_cnt = 0;
+	timer->source = 0;
+	timer->source_deadline = 0;
+	return timer;
+}
+
+
+/* panel_timer_delete */
+void panel_timer_delete(PanelTimer * timer)
+{
+	if(timer->source != 0)
+		g_source_remove(timer->source);
+	free(timer->sources);
+	free(timer->suspended);
+	object_delete(timer);
+}
+
+
+/* accessors */
+/* panel_timer_get_wakeups */
+unsigned int panel_timer_get_wakeups(PanelTimer * timer)
+{
+	return timer->wakeups;
+}
+
+
+/* panel_timer_set_slack */
+void panel_timer_set_slack(PanelTimer * timer, guint slack)
+{
+	timer->slack = slack;
+}
+
+
+/* panel_timer_set_usage */
+void panel_timer_set_usage(PanelTimer * timer, PanelUsage * usage)
+{
+	timer->usage = usage;
+}
+
+
+/* useful */
+/* panel_timer_add */
+guint panel_timer_add(PanelTimer * timer, guint interval,
+		GSourceFunc callback, gpointer data)
+{
+	PanelTimerSource * s;
+
+	if(interval == 0 || callback == NULL)
+	{
+		error_set_code(1, "%s", strerror(EINVAL));
+		return 0;
+	}
+	if((s = realloc(timer->sources, sizeof(*s)
+					* (timer->sources_cnt + 1))) == NULL)
+	{
+		error_set_code(1, "%s", strerror(errno));
+		return 0;
+	}
+	timer->sources = s;
+	s = &timer->sources[timer->sources_cnt++];
+	if(++timer->id == 0)
+		timer->id++;
+	s->id = timer->id;
+	s->interval = interval;
+	s->deadline = _panel_timer_align(g_get_monotonic_time()
+			+ (gint64)interval * 1000, interval);
+	s->callback = callback;
+	s->data = data;
+	s->suspended = _panel_timer_is_suspended(timer, data);
+#ifdef DEBUG
+	fprintf(stderr, "DEBUG: %s(%u) => %u\n", __func__, interval, s->id);
+#endif
+	if(timer->dispatching == FALSE)
+		_panel_timer_schedule(timer);
+	return s->id;
+}
+
+
+/* panel_timer_remove */
+void panel_timer_remove(PanelTimer * timer, guint id)
+{
+	size_t i;
+
+	for(i = 0; i < timer->sources_cnt; i++)
+		if(timer->sources[i].id == id)
+		{
+			timer->sources[i].callback = NULL;
+			break;
+		}
+	/* the sources are collected once the dispatch is complete */
+	if(timer->dispatching)
+		return;
+	_panel_timer_cleanup(timer);
+	_panel_timer_schedule(timer);
+}
+
+
+/* panel_timer_resume */
+void panel_timer_resume(PanelTimer * timer, gpointer data)
+{
+	size_t i;
+	gint64 now;
+
+	for(i = 0; i < timer->suspended_cnt; i++)
+		if(timer->suspended[i] == data)
+		{
+			timer->suspended[i] = timer->suspended[
+				--timer->suspended_cnt];
+			break;
+		}
+	now = g_get_monotonic_time();
+	/* catch up once, as soon as possible */
+	for(i = 0; i < timer->sources_cnt; i++)
+		if(timer->sources[i].data == data
+				&& timer->sources[i].suspended)
+		{
+			timer->sources[i].suspended = FALSE;
+			timer->sources[i].deadline = now;
+		}
+	if(timer->dispatching == FALSE)
+		_panel_timer_schedule(timer);
+}
+
+
+/* panel_timer_suspend */
+void panel_timer_suspend(PanelTimer * timer, gpointer data)
+{
+	size_t i;
+	gpointer * p;
+
+	if(_panel_timer_is_suspended(timer, data) == FALSE)
+	{
+		if((p = realloc(timer->suspended, sizeof(*p)
+						* (timer->suspended_cnt + 1)))
+				== NULL)
+			/* only the sources already added are suspended */
+			error_set_code(1, "%s", strerror(errno));
+		else
+		{
+			timer->suspended = p;
+			timer->suspended[timer->suspended_cnt++] = data;
+		}
+	}
+	for(i = 0; i < timer->sources_cnt; i++)
+		if(timer->sources[i].data == data)
+			timer->sources[i].suspended = TRUE;
+	if(timer->dispatching == FALSE)
+		_panel_timer_schedule(timer);
+}
+
+
+/* private */
+/* functions */
+/* panel_timer_align */
+static gint64 _panel_timer_align(gint64 deadline, guint interval)
+{
+	gint64 offset;
+	gint64 grid;
+	guint a = interval;
+	guint b = 1000;
+	guint c;
+
+	/* align on the largest fraction of a second dividing the interval,
+	 * on the wall clock so that periodic sources fire together */
+	while(b != 0)
+	{
+		c = a % b;
+		a = b;
+		b = c;
+	}
+	grid = (gint64)a * 1000;
+	offset = g_get_real_time() - g_get_monotonic_time();
+	deadline += offset;
+	deadline = ((deadline + grid - 1) / grid) * grid;
+	return deadline - offset;
+}
+
+
+/* panel_timer_cleanup */
+static void _panel_timer_cleanup(PanelTimer * timer)
+{
+	size_t i;
+	size_t j;
+
+	for(i = 0, j = 0; i < timer->sources_cnt; i++)
+		if(timer->sources[i].callback != NULL)
+		{
+			if(i != j)
+				timer->sources[j] = timer->sources[i];
+			j++;
+		}
+	timer->sources_cnt = j;
+	if(j == 0)
+	{
+		free(timer->sources);
+		timer->sources = NULL;
+	}
+}
+
+
+/* panel_timer_is_suspended */
+static gboolean _panel_timer_is_suspended(PanelTimer * timer, gpointer data)
+{
+	size_t i;
+
+	for(i = 0; i < timer->suspended_cnt; i++)
+		if(timer->suspended[i] == data)
+			return TRUE;
+	return FALSE;
+}
+
+
+/* panel_timer_schedule */
+static void _panel_timer_schedule(PanelTimer * timer)
+{
+	size_t i;
+	gint64 deadline = 0;
+	gint64 now;
+	guint delay;
+
+	for(i = 0; i < timer->sources_cnt; i++)
+		if(timer->sources[i].callback != NULL
+				&& timer->sources[i].suspended == FALSE
+				&& (deadline == 0 || timer->sources[i].deadline
+					< deadline))
+			deadline = timer->sources[i].deadline;
+	if(timer->source != 0)
+	{
+		if(deadline == timer->source_deadline)
+			return;
+		g_source_remove(timer->source);
+		timer->source = 0;
+	}
+	if(deadline == 0)
+		return;
+	now = g_get_monotonic_time();
+	delay = (deadline > now) ? (deadline - now + 999) / 1000 : 0;
+	timer->source_deadline = deadline;
+	timer->source = g_timeout_add(delay, _panel_timer_on_timeout, timer);
+}
+
+
+/* callbacks */
+/* panel_timer_on_timeout */
+static gboolean _panel_timer_on_timeout(gpointer data)
+{
+	PanelTimer * timer = data;
+	PanelTimerSource * s;
+	gint64 now;
+	gint64 limit;
+	size_t i;
+	size_t cnt;
+	gboolean ret;
+
+	timer->source = 0;
+	timer->wakeups++;
+	now = g_get_monotonic_time();
+	/* fire every source due within the slack allowed */
+	limit = now + (gint64)timer->slack * 1000;
+	timer->dispatching = TRUE;
+	for(i = 0, cnt = timer->sources_cnt; i < cnt; i++)
+	{
+		s = &timer->sources[i];
+		if(s->callback == NULL || s->suspended || s->deadline > limit)
+			continue;
+		/* account for the time spent per applet */
+		ret = (timer->usage != NULL) ? panel_usage_call(timer->usage,
+				s->data, s->callback, s->data)
+			: s->callback(s->data);
+		if(ret == FALSE)
+		{
+			/* the array may have been moved by the callback */
+			timer->sources[i].callback = NULL;
+			continue;
+		}
+		s = &timer->sources[i];
+		if(s->callback == NULL)
+			continue;
+		/* keep the original phase unless ticks were missed */
+		s->deadline += (gint64)s->interval * 1000;
+		if(s->deadline <= now)
+			s->deadline = now + (gint64)s->interval * 1000;
+		s->deadline = _panel_timer_align(s->deadline, s->interval);
+	}
+	timer->dispatching = FALSE;
+	_panel_timer_cleanup(timer);
+	_panel_timer_schedule(timer);
+	return FALSE;
+}
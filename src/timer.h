@@ -0,0 +1,52 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Panel */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#ifndef PANEL_TIMER_H
+# define PANEL_TIMER_H
+
+# include <glib.h>
+# include "usage.h"
+
+
+/* PanelTimer */
+/* types */
+typedef struct _PanelTimer PanelTimer;
+
+
+/* constants */
+# define PANEL_TIMER_SLACK_DEFAULT	50
+
+
+/* functions */
+PanelTimer * panel_timer_new(void);
+void panel_timer_delete(PanelTimer * timer);
+
+/* accessors */
+unsigned int panel_timer_get_wakeups(PanelTimer * timer);
+
+void panel_timer_set_slack(PanelTimer * timer, guint slack);
+void panel_timer_set_usage(PanelTimer * timer, PanelUsage * usage);
+
+/* useful */
+guint panel_timer_add(PanelTimer * timer, guint interval,
+		GSourceFunc callback, gpointer data);
+void panel_timer_remove(PanelTimer * timer, guint id);
+
+void panel_timer_resume(PanelTimer * timer, gpointer data);
+void panel_timer_suspend(PanelTimer * timer, gpointer data);
+
+#endif /* !PANEL_TIMER_H */
@@ -0,0 +1,408 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Panel */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <System.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include "panel.h"
+#include "usage.h"
+
+
+/* PanelUsage */
+/* private */
+/* types */
+typedef struct _PanelUsageApplet
+{
+	String * name;
+	unsigned long calls;
+	gint64 wall;			/* in microseconds		*/
+	gint64 cpu;			/* in microseconds		*/
+	gint64 last;			/* in microseconds		*/
+	gint64 worst;			/* in microseconds		*/
+	unsigned long overruns;
+} PanelUsageApplet;
+
+typedef struct _PanelUsageInstance
+{
+	gpointer applet;
+	PanelUsageApplet * pua;
+} PanelUsageInstance;
+
+typedef struct _PanelUsageFilter
+{
+	PanelUsage * usage;
+	GdkWindow * window;
+	GdkFilterFunc filter;
+	gpointer applet;
+} PanelUsageFilter;
+
+struct _PanelUsage
+{
+	guint budget;			/* in milliseconds		*/
+
+	/* per name, to survive the re-creation of applets */
+	PanelUsageApplet ** applets;
+	size_t applets_cnt;
+
+	PanelUsageInstance * instances;
+	size_t instances_cnt;
+
+	PanelUsageFilter ** filters;
+	size_t filters_cnt;
+};
+
+
+/* prototypes */
+static void _panel_usage_account(PanelUsage * usage, gpointer applet,
+		char const * source, gint64 wall, gint64 cpu);
+static gint64 _panel_usage_cpu(void);
+static PanelUsageApplet * _panel_usage_lookup(PanelUsage * usage,
+		gpointer applet);
+
+/* callbacks */
+static GdkFilterReturn _panel_usage_on_filter(GdkXEvent * xevent,
+		GdkEvent * event, gpointer data);
+
+
+/* public */
+/* functions */
+/* panel_usage_new */
+PanelUsage * panel_usage_new(void)
+{
+	PanelUsage * usage;
+
+	if((usage = object_new(sizeof(*usage))) == NULL)
+		return NULL;
+	usage->budget = PANEL_USAGE_BUDGET_DEFAULT;
+	usage->applets = NULL;
+	usage->applets_cnt = 0;
+	usage->instances = NULL;
+	usage->instances_cnt = 0;
+	usage->filters = NULL;
+	usage->filters_cnt = 0;
+	return usage;
+}
+
+
+/* panel_usage_delete */
+void panel_usage_delete(PanelUsage * usage)
+{
+	size_t i;
+
+	for(i = 0; i < usage->filters_cnt; i++)
+	{
+		gdk_window_remove_filter(usage->filters[i]->window,
+				_panel_usage_on_filter, usage->filters[i]);
+		free(usage->filters[i]);
+	}
+	free(usage->filters);
+	free(usage->instances);
+	for(i = 0; i < usage->applets_cnt; i++)
+	{
+		string_delete(usage->applets[i]->name);
+		free(usage->applets[i]);
+	}
+	free(usage->applets);
+	object_delete(usage);
+}
+
+
+/* accessors */
+/* panel_usage_get_budget */
+guint panel_usage_get_budget(PanelUsage * usage)
+{
+	return usage->budget;
+}
+
+
+/* panel_usage_get_stats */
+int panel_usage_get_stats(PanelUsage * usage, size_t index,
+		PanelUsageStats * stats)
+{
+	PanelUsageApplet * pua;
+
+	if(index >= usage->applets_cnt)
+		return -error_set_code(1, "%s", strerror(ERANGE));
+	pua = usage->applets[index];
+	stats->name = pua->name;
+	stats->calls = pua->calls;
+	stats->wall = pua->wall;
+	stats->cpu = pua->cpu;
+	stats->last = pua->last;
+	stats->worst = pua->worst;
+	stats->overruns = pua->overruns;
+	return 0;
+}
+
+
+/* panel_usage_set_budget */
+void panel_usage_set_budget(PanelUsage * usage, guint budget)
+{
+	usage->budget = budget;
+}
+
+
+/* useful */
+/* panel_usage_register */
+int panel_usage_register(PanelUsage * usage, gpointer applet,
+		char const * name)
+{
+	PanelUsageApplet ** p;
+	PanelUsageApplet * pua = NULL;
+	PanelUsageInstance * pui;
+	size_t i;
+
+	for(i = 0; i < usage->applets_cnt; i++)
+		if(strcmp(usage->applets[i]->name, name) == 0)
+		{
+			pua = usage->applets[i];
+			break;
+		}
+	if((pui = realloc(usage->instances, sizeof(*pui)
+					* (usage->instances_cnt + 1))) == NULL)
+		return -error_set_code(1, "%s", strerror(errno));
+	usage->instances = pui;
+	if(pua == NULL)
+	{
+		if((p = realloc(usage->applets, sizeof(*p)
+						* (usage->applets_cnt + 1)))
+				== NULL)
+			return -error_set_code(1, "%s", strerror(errno));
+		usage->applets = p;
+		if((pua = malloc(sizeof(*pua))) == NULL)
+			return -error_set_code(1, "%s", strerror(errno));
+		if((pua->name = string_new(name)) == NULL)
+		{
+			free(pua);
+			return -1;
+		}
+		pua->calls = 0;
+		pua->wall = 0;
+		pua->cpu = 0;
+		pua->last = 0;
+		pua->worst = 0;
+		pua->overruns = 0;
+		usage->applets[usage->applets_cnt++] = pua;
+	}
+	pui = &usage->instances[usage->instances_cnt++];
+	pui->applet = applet;
+	pui->pua = pua;
+	return 0;
+}
+
+
+/* panel_usage_unregister */
+void panel_usage_unregister(PanelUsage * usage, gpointer applet)
+{
+	size_t i;
+
+	for(i = 0; i < usage->instances_cnt; i++)
+		if(usage->instances[i].applet == applet)
+		{
+			memmove(&usage->instances[i], &usage->instances[i + 1],
+					sizeof(*usage->instances)
+					* (--usage->instances_cnt - i));
+			break;
+		}
+}
+
+
+/* panel_usage_call */
+gboolean panel_usage_call(PanelUsage * usage, gpointer applet,
+		GSourceFunc callback, gpointer data)
+{
+	gboolean ret;
+	PanelUsageCall call;
+
+	panel_usage_begin(&call);
+	ret = callback(data);
+	panel_usage_end(usage, applet, "timer", &call);
+	return ret;
+}
+
+
+/* panel_usage_begin */
+void panel_usage_begin(PanelUsageCall * call)
+{
+	call->wall = g_get_monotonic_time();
+	call->cpu = _panel_usage_cpu();
+}
+
+
+/* panel_usage_end */
+void panel_usage_end(PanelUsage * usage, gpointer applet,
+		char const * source, PanelUsageCall const * call)
+{
+	_panel_usage_account(usage, applet, source,
+			g_get_monotonic_time() - call->wall,
+			_panel_usage_cpu() - call->cpu);
+}
+
+
+/* panel_usage_add_filter */
+int panel_usage_add_filter(PanelUsage * usage, GdkWindow * window,
+		GdkFilterFunc filter, gpointer applet)
+{
+	PanelUsageFilter ** p;
+	PanelUsageFilter * puf;
+
+	if((p = realloc(usage->filters, sizeof(*p) * (usage->filters_cnt + 1)))
+			== NULL)
+		return -error_set_code(1, "%s", strerror(errno));
+	usage->filters = p;
+	if((puf = malloc(sizeof(*puf))) == NULL)
+		return -error_set_code(1, "%s", strerror(errno));
+	puf->usage = usage;
+	puf->window = window;
+	puf->filter = filter;
+	puf->applet = applet;
+	usage->filters[usage->filters_cnt++] = puf;
+	gdk_window_add_filter(window, _panel_usage_on_filter, puf);
+	return 0;
+}
+
+
+/* panel_usage_remove_filter */
+void panel_usage_remove_filter(PanelUsage * usage, GdkWindow * window,
+		GdkFilterFunc filter, gpointer applet)
+{
+	PanelUsageFilter * puf;
+	size_t i;
+
+	for(i = 0; i < usage->filters_cnt; i++)
+	{
+		puf = usage->filters[i];
+		if(puf->window != window || puf->filter != filter
+				|| puf->applet != applet)
+			continue;
+		gdk_window_remove_filter(window, _panel_usage_on_filter, puf);
+		free(puf);
+		memmove(&usage->filters[i], &usage->filters[i + 1],
+				sizeof(*usage->filters)
+				* (--usage->filters_cnt - i));
+		break;
+	}
+}
+
+
+/* panel_usage_report */
+int panel_usage_report(PanelUsage * usage, FILE * fp)
+{
+	PanelUsageApplet * pua;
+	size_t i;
+
+	fputs("# applet\tcalls\twall (ms)\tcpu (ms)\tworst (ms)\toverruns\n",
+			fp);
+	for(i = 0; i < usage->applets_cnt; i++)
+	{
+		pua = usage->applets[i];
+		fprintf(fp, "%s\t%lu\t%.3f\t%.3f\t%.3f\t%lu\n", pua->name,
+				pua->calls, pua->wall / 1000.0,
+				pua->cpu / 1000.0, pua->worst / 1000.0,
+				pua->overruns);
+	}
+	if(fflush(fp) != 0)
+		return -error_set_code(1, "%s", strerror(errno));
+	return 0;
+}
+
+
+/* private */
+/* functions */
+/* panel_usage_account */
+static void _panel_usage_account(PanelUsage * usage, gpointer applet,
+		char const * source, gint64 wall, gint64 cpu)
+{
+	PanelUsageApplet * pua;
+	char buf[128];
+
+	if((pua = _panel_usage_lookup(usage, applet)) != NULL)
+	{
+		pua->calls++;
+		pua->wall += wall;
+		pua->cpu += cpu;
+		pua->last = wall;
+		if(wall > pua->worst)
+			pua->worst = wall;
+	}
+	/* watchdog */
+	if(usage->budget == 0 || wall <= (gint64)usage->budget * 1000)
+		return;
+	if(pua != NULL)
+		pua->overruns++;
+	snprintf(buf, sizeof(buf), "%s: %s callback took %.1f ms"
+			" (cpu: %.1f ms, budget: %u ms)",
+			(pua != NULL) ? pua->name : "(unknown)", source,
+			wall / 1000.0, cpu / 1000.0, usage->budget);
+	panel_error(NULL, buf, 0);
+}
+
+
+/* panel_usage_cpu */
+static gint64 _panel_usage_cpu(void)
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+	struct timespec ts;
+#endif
+	struct rusage ru;
+
+#ifdef CLOCK_THREAD_CPUTIME_ID
+	/* only count the main loop, not the other threads */
+	if(clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+		return (gint64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+	if(getrusage(RUSAGE_SELF, &ru) != 0)
+		return 0;
+	return ((gint64)ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000
+		+ ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+}
+
+
+/* panel_usage_lookup */
+static PanelUsageApplet * _panel_usage_lookup(PanelUsage * usage,
+		gpointer applet)
+{
+	size_t i;
+
+	for(i = 0; i < usage->instances_cnt; i++)
+		if(usage->instances[i].applet == applet)
+			return usage->instances[i].pua;
+	return NULL;
+}
+
+
+/* callbacks */
+/* panel_usage_on_filter */
+static GdkFilterReturn _panel_usage_on_filter(GdkXEvent * xevent,
+		GdkEvent * event, gpointer data)
+{
+	PanelUsageFilter * puf = data;
+	PanelUsage * usage = puf->usage;
+	gpointer applet = puf->applet;
+	GdkFilterReturn ret;
+	PanelUsageCall call;
+
+	panel_usage_begin(&call);
+	/* the filter may remove itself */
+	ret = puf->filter(xevent, event, applet);
+	panel_usage_end(usage, applet, "filter", &call);
+	return ret;
+}
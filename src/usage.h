@@ -0,0 +1,80 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Panel */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#ifndef PANEL_USAGE_H
+# define PANEL_USAGE_H
+
+# include <stdio.h>
+# include <gdk/gdk.h>
+
+
+/* PanelUsage */
+/* types */
+typedef struct _PanelUsage PanelUsage;
+
+typedef struct _PanelUsageStats
+{
+	char const * name;
+	unsigned long calls;
+	gint64 wall;			/* in microseconds		*/
+	gint64 cpu;			/* in microseconds		*/
+	gint64 last;			/* in microseconds		*/
+	gint64 worst;			/* in microseconds		*/
+	unsigned long overruns;
+} PanelUsageStats;
+
+typedef struct _PanelUsageCall
+{
+	gint64 wall;			/* in microseconds		*/
+	gint64 cpu;			/* in microseconds		*/
+} PanelUsageCall;
+
+
+/* constants */
+# define PANEL_USAGE_BUDGET_DEFAULT	0	/* in milliseconds	*/
+
+
+/* functions */
+PanelUsage * panel_usage_new(void);
+void panel_usage_delete(PanelUsage * usage);
+
+/* accessors */
+guint panel_usage_get_budget(PanelUsage * usage);
+int panel_usage_get_stats(PanelUsage * usage, size_t index,
+		PanelUsageStats * stats);
+void panel_usage_set_budget(PanelUsage * usage, guint budget);
+
+/* useful */
+int panel_usage_register(PanelUsage * usage, gpointer applet,
+		char const * name);
+void panel_usage_unregister(PanelUsage * usage, gpointer applet);
+
+gboolean panel_usage_call(PanelUsage * usage, gpointer applet,
+		GSourceFunc callback, gpointer data);
+/* for the callbacks of any other type */
+void panel_usage_begin(PanelUsageCall * call);
+void panel_usage_end(PanelUsage * usage, gpointer applet,
+		char const * source, PanelUsageCall const * call);
+
+int panel_usage_add_filter(PanelUsage * usage, GdkWindow * window,
+		GdkFilterFunc filter, gpointer applet);
+void panel_usage_remove_filter(PanelUsage * usage, GdkWindow * window,
+		GdkFilterFunc filter, gpointer applet);
+
+int panel_usage_report(PanelUsage * usage, FILE * fp);
+
+#endif /* !PANEL_USAGE_H */
@@ -0,0 +1,295 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Panel */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#include <System.h>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#ifdef DEBUG
+# include <stdio.h>
+#endif
+#include <gio/gio.h>
+#include "watch.h"
+
+
+/* PanelWatch */
+/* private */
+/* types */
+typedef struct _PanelWatchFile
+{
+	String * filename;
+	GFileMonitor * monitor;		/* polled if NULL		*/
+
+	/* last contents known */
+	gchar * contents;		/* NULL if missing		*/
+	gsize length;
+
+	/* last status known, when polling */
+	dev_t dev;
+	ino_t ino;
+	off_t size;
+	time_t mtime;
+} PanelWatchFile;
+
+struct _PanelWatch
+{
+	PanelWatchCallback callback;
+	void * data;
+
+	PanelWatchFile * files;
+	size_t files_cnt;
+
+	guint source;			/* coalesces the notifications	*/
+	guint poll;
+	unsigned int changes;
+};
+
+
+/* prototypes */
+static void _panel_watch_read(PanelWatchFile * file);
+static gboolean _panel_watch_stat(PanelWatchFile * file);
+
+/* callbacks */
+static void _panel_watch_on_changed(GFileMonitor * monitor, GFile * file,
+		GFile * other, GFileMonitorEvent event, gpointer data);
+static gboolean _panel_watch_on_poll(gpointer data);
+static gboolean _panel_watch_on_timeout(gpointer data);
+
+
+/* public */
+/* functions */
+/* panel_watch_new */
+PanelWatch * panel_watch_new(PanelWatchCallback callback, void * data)
+{
+	PanelWatch * watch;
+
+	if((watch = object_new(sizeof(*watch))) == NULL)
+		return NULL;
+	watch->callback = callback;
+	watch->data = data;
+	watch->files = NULL;
+	watch->files_cnt = 0;
+	watch->source = 0;
+	watch->poll = 0;
+	watch->changes = 0;
+	return watch;
+}
+
+
+/* panel_watch_delete */
+void panel_watch_delete(PanelWatch * watch)
+{
+	size_t i;
+
+	if(watch->poll != 0)
+		g_source_remove(watch->poll);
+	if(watch->source != 0)
+		g_source_remove(watch->source);
+	for(i = 0; i < watch->files_cnt; i++)
+	{
+		if(watch->files[i].monitor != NULL)
+		{
+			g_file_monitor_cancel(watch->files[i].monitor);
+			g_object_unref(watch->files[i].monitor);
+		}
+		g_free(watch->files[i].contents);
+		string_delete(watch->files[i].filename);
+	}
+	free(watch->files);
+	object_delete(watch);
+}
+
+
+/* accessors */
+/* panel_watch_get_changes */
+unsigned int panel_watch_get_changes(PanelWatch * watch)
+{
+	return watch->changes;
+}
+
+
+/* useful */
+/* panel_watch_add */
+int panel_watch_add(PanelWatch * watch, char const * filename)
+{
+	PanelWatchFile * file;
+	GFile * f;
+	GError * error = NULL;
+
+	if((file = realloc(watch->files, sizeof(*file)
+					* (watch->files_cnt + 1))) == NULL)
+		return -error_set_code(1, "%s", strerror(errno));
+	watch->files = file;
+	file = &watch->files[watch->files_cnt];
+	if((file->filename = string_new(filename)) == NULL)
+		return -1;
+	file->contents = NULL;
+	file->length = 0;
+	file->dev = 0;
+	file->ino = 0;
+	file->size = 0;
+	file->mtime = 0;
+	_panel_watch_read(file);
+	_panel_watch_stat(file);
+	/* let the kernel tell us about changes if possible */
+	f = g_file_new_for_path(filename);
+	if((file->monitor = g_file_monitor_file(f, G_FILE_MONITOR_NONE, NULL,
+					&error)) != NULL)
+		g_signal_connect(file->monitor, "changed", G_CALLBACK(
+					_panel_watch_on_changed), watch);
+	else
+	{
+#ifdef DEBUG
+		fprintf(stderr, "DEBUG: %s(\"%s\") %s\n", __func__, filename,
+				error->message);
+#endif
+		g_error_free(error);
+		if(watch->poll == 0)
+			watch->poll = g_timeout_add_seconds(PANEL_WATCH_POLL,
+					_panel_watch_on_poll, watch);
+	}
+	g_object_unref(f);
+	watch->files_cnt++;
+	return 0;
+}
+
+
+/* panel_watch_update */
+void panel_watch_update(PanelWatch * watch)
+{
+	size_t i;
+
+	/* forget about the changes already known */
+	for(i = 0; i < watch->files_cnt; i++)
+	{
+		_panel_watch_read(&watch->files[i]);
+		_panel_watch_stat(&watch->files[i]);
+	}
+}
+
+
+/* private */
+/* functions */
+/* panel_watch_read */
+static void _panel_watch_read(PanelWatchFile * file)
+{
+	g_free(file->contents);
+	file->contents = NULL;
+	file->length = 0;
+	if(g_file_get_contents(file->filename, &file->contents, &file->length,
+				NULL) != TRUE)
+		file->contents = NULL;
+}
+
+
+/* panel_watch_stat */
+static gboolean _panel_watch_stat(PanelWatchFile * file)
+{
+	struct stat st;
+	gboolean ret;
+
+	if(stat(file->filename, &st) != 0)
+		memset(&st, 0, sizeof(st));
+	ret = (st.st_dev != file->dev || st.st_ino != file->ino
+			|| st.st_size != file->size
+			|| st.st_mtime != file->mtime) ? TRUE : FALSE;
+	file->dev = st.st_dev;
+	file->ino = st.st_ino;
+	file->size = st.st_size;
+	file->mtime = st.st_mtime;
+	return ret;
+}
+
+
+/* callbacks */
+/* panel_watch_on_changed */
+static void _panel_watch_on_changed(GFileMonitor * monitor, GFile * file,
+		GFile * other, GFileMonitorEvent event, gpointer data)
+{
+	PanelWatch * watch = data;
+	(void) monitor;
+	(void) file;
+	(void) other;
+	(void) event;
+
+	/* files are usually written in several steps */
+	if(watch->source == 0)
+		watch->source = g_timeout_add(PANEL_WATCH_DELAY,
+				_panel_watch_on_timeout, watch);
+}
+
+
+/* panel_watch_on_poll */
+static gboolean _panel_watch_on_poll(gpointer data)
+{
+	PanelWatch * watch = data;
+	size_t i;
+
+	for(i = 0; i < watch->files_cnt; i++)
+		if(watch->files[i].monitor == NULL
+				&& _panel_watch_stat(&watch->files[i])
+				&& watch->source == 0)
+			watch->source = g_timeout_add(PANEL_WATCH_DELAY,
+					_panel_watch_on_timeout, watch);
+	return TRUE;
+}
+
+
+/* panel_watch_on_timeout */
+static gboolean _panel_watch_on_timeout(gpointer data)
+{
+	PanelWatch * watch = data;
+	PanelWatchFile * file;
+	gchar * contents;
+	gsize length;
+	gboolean changed = FALSE;
+	size_t i;
+
+	watch->source = 0;
+	/* only report actual changes to the contents */
+	for(i = 0; i < watch->files_cnt; i++)
+	{
+		file = &watch->files[i];
+		if(g_file_get_contents(file->filename, &contents, &length, NULL)
+				!= TRUE)
+			contents = NULL;
+		if(contents == NULL && file->contents == NULL)
+			continue;
+		if(contents != NULL && file->contents != NULL
+				&& length == file->length
+				&& memcmp(contents, file->contents, length) == 0)
+		{
+			g_free(contents);
+			continue;
+		}
+		g_free(file->contents);
+		file->contents = contents;
+		file->length = (contents != NULL) ? length : 0;
+		changed = TRUE;
+	}
+#ifdef DEBUG
+	fprintf(stderr, "DEBUG: %s() %s\n", __func__, changed ? "changed"
+			: "unchanged");
+#endif
+	if(changed)
+	{
+		watch->changes++;
+		watch->callback(watch->data);
+	}
+	return FALSE;
+}
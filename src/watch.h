@@ -0,0 +1,48 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Panel */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#ifndef PANEL_WATCH_H
+# define PANEL_WATCH_H
+
+# include <glib.h>
+
+
+/* PanelWatch */
+/* types */
+typedef struct _PanelWatch PanelWatch;
+
+typedef void (*PanelWatchCallback)(void * data);
+
+
+/* constants */
+# define PANEL_WATCH_DELAY		250	/* in milliseconds	*/
+# define PANEL_WATCH_POLL		2	/* in seconds		*/
+
+
+/* functions */
+PanelWatch * panel_watch_new(PanelWatchCallback callback, void * data);
+void panel_watch_delete(PanelWatch * watch);
+
+/* accessors */
+unsigned int panel_watch_get_changes(PanelWatch * watch);
+
+/* useful */
+int panel_watch_add(PanelWatch * watch, char const * filename);
+
+void panel_watch_update(PanelWatch * watch);
+
+#endif /* !PANEL_WATCH_H */
@@ -1,5 +1,5 @@
 /* $Id$ */
-/* Copyright (c) 2011-2024 Pierre Pronchery <khorben@defora.org> */
+/* Copyright (c) 2011-2026 Pierre Pronchery <khorben@defora.org> */
 /* This file is part of DeforaOS Desktop Panel */
 /* This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -26,26 +26,20 @@
 #  include <gtk/gtkx.h>
 # endif
 #endif
+#include "profile.h"
+#include "registry.h"
 #include "window.h"
 #include "../config.h"
 #define _(string) gettext(string)
 #define N_(string) string
 
-/* constants */
-#ifndef PREFIX
-# define PREFIX		"/usr/local"
-#endif
-#ifndef LIBDIR
-# define LIBDIR		PREFIX "/lib"
-#endif
-
 
 /* PanelWindow */
 /* private */
 /* types */
 struct _PanelApplet
 {
-	Plugin * plugin;
+	String * name;
 	PanelAppletDefinition * pad;
 	PanelApplet * pa;
 	GtkWidget * widget;
@@ -57,12 +51,28 @@ struct _PanelWindow
 	PanelWindowPosition position;
 	GtkIconSize iconsize;
 	gint height;
+	gint width;
 	GdkRectangle root;
 
+	/* strut */
+	unsigned long strut[12];	/* last published		*/
+	gboolean strut_set;
+
 	/* applets */
 	PanelAppletHelper * helper;
 	PanelApplet * applets;
 	size_t applets_cnt;
+	PanelTimer * timer;
+	PanelUsage * usage;
+
+	/* placeholders, for the applets being loaded */
+	GtkWidget ** placeholders;
+	size_t placeholders_cnt;
+
+	/* suspension */
+	gboolean visible;
+	gboolean suspend;
+	gboolean suspended;
 
 	/* widgets */
 	GtkWidget * window;
@@ -70,14 +80,38 @@ struct _PanelWindow
 };
 
 
+/* constants */
+static char const * _panel_window_positions[] =
+{
+	"bottom", "top", "left", "right", "center", "floating", "managed",
+	"embedded"
+};
+
+
+/* variables */
+static GdkAtom _panel_window_atom_cardinal = GDK_NONE;
+static GdkAtom _panel_window_atom_strut = GDK_NONE;
+static GdkAtom _panel_window_atom_strut_partial = GDK_NONE;
+
+
 /* prototypes */
+static int _panel_window_insert(PanelWindow * panel, size_t index,
+		char const * applet, GtkWidget * placeholder);
 static void _panel_window_reset(PanelWindow * panel);
 static void _panel_window_reset_strut(PanelWindow * panel);
+static void _panel_window_resume_applet(PanelWindow * panel, PanelApplet * pa);
+static void _panel_window_suspend_applet(PanelWindow * panel,
+		PanelApplet * pa);
+static void _panel_window_update(PanelWindow * panel);
 
 /* callbacks */
 static gboolean _panel_window_on_closex(gpointer data);
 static gboolean _panel_window_on_configure_event(GtkWidget * widget,
 		GdkEvent * event, gpointer data);
+static gboolean _panel_window_on_draw(GtkWidget * widget, gpointer event,
+		gpointer data);
+static gboolean _panel_window_on_map_event(GtkWidget * widget,
+		GdkEvent * event, gpointer data);
 
 
 /* public */
@@ -91,7 +125,9 @@ PanelWindow * panel_window_new(PanelAppletHelper * helper,
 	int icon_width;
 	int icon_height;
 	GtkOrientation orientation;
+	gint64 begin;
 
+	begin = panel_profile_begin();
 	if(gtk_icon_size_lookup(iconsize, &icon_width, &icon_height) != TRUE)
 	{
 		error_set_code(1, _("Invalid panel size"));
@@ -105,6 +141,13 @@ PanelWindow * panel_window_new(PanelAppletHelper * helper,
 	panel->helper = helper;
 	panel->applets = NULL;
 	panel->applets_cnt = 0;
+	panel->timer = NULL;
+	panel->usage = NULL;
+	panel->placeholders = NULL;
+	panel->placeholders_cnt = 0;
+	panel->visible = TRUE;
+	panel->suspend = FALSE;
+	panel->suspended = FALSE;
 	if(position != PANEL_WINDOW_POSITION_EMBEDDED)
 	{
 		panel->window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
@@ -126,6 +169,9 @@ PanelWindow * panel_window_new(PanelAppletHelper * helper,
 	}
 	gtk_container_set_border_width(GTK_CONTAINER(panel->window), 2);
 	panel->height = icon_height + (PANEL_BORDER_WIDTH * 4);
+	panel->width = panel->height;
+	memset(&panel->strut, 0, sizeof(panel->strut));
+	panel->strut_set = FALSE;
 #ifdef DEBUG
 	fprintf(stderr, "DEBUG: %s() %u height=%d\n", __func__, position,
 			panel->height);
@@ -182,9 +228,23 @@ PanelWindow * panel_window_new(PanelAppletHelper * helper,
 	}
 	g_signal_connect_swapped(panel->window, "delete-event", G_CALLBACK(
 				_panel_window_on_closex), panel);
+	if(panel_profile_is_enabled())
+	{
+		g_signal_connect(panel->window, "map-event", G_CALLBACK(
+					_panel_window_on_map_event), panel);
+#if GTK_CHECK_VERSION(3, 0, 0)
+		g_signal_connect(panel->window, "draw", G_CALLBACK(
+					_panel_window_on_draw), panel);
+#else
+		g_signal_connect(panel->window, "expose-event", G_CALLBACK(
+					_panel_window_on_draw), panel);
+#endif
+	}
 	gtk_container_add(GTK_CONTAINER(panel->window), panel->box);
 	gtk_widget_show_all(panel->box);
 	panel_window_reset(panel, root);
+	panel_profile_end(begin, _panel_window_positions[position],
+			"panel_window_new");
 	return panel;
 }
 
@@ -199,6 +259,22 @@ void panel_window_delete(PanelWindow * panel)
 
 
 /* accessors */
+/* panel_window_get_applet_count */
+size_t panel_window_get_applet_count(PanelWindow * panel)
+{
+	return panel->applets_cnt;
+}
+
+
+/* panel_window_get_applet_name */
+char const * panel_window_get_applet_name(PanelWindow * panel, size_t index)
+{
+	if(index >= panel->applets_cnt)
+		return NULL;
+	return panel->applets[index].name;
+}
+
+
 /* panel_window_get_height */
 int panel_window_get_height(PanelWindow * panel)
 {
@@ -261,6 +337,13 @@ PanelWindowType panel_window_get_type(PanelWindow * panel)
 }
 
 
+/* panel_window_get_usage */
+PanelUsage * panel_window_get_usage(PanelWindow * panel)
+{
+	return panel->usage;
+}
+
+
 /* panel_window_get_width */
 int panel_window_get_width(PanelWindow * panel)
 {
@@ -299,6 +382,13 @@ void panel_window_set_keep_above(PanelWindow * panel, gboolean keep)
 }
 
 
+/* panel_window_set_timer */
+void panel_window_set_timer(PanelWindow * panel, PanelTimer * timer)
+{
+	panel->timer = timer;
+}
+
+
 /* panel_window_set_title */
 void panel_window_set_title(PanelWindow * panel, char const * title)
 {
@@ -306,35 +396,124 @@ void panel_window_set_title(PanelWindow * panel, char const * title)
 }
 
 
+/* panel_window_set_usage */
+void panel_window_set_usage(PanelWindow * panel, PanelUsage * usage)
+{
+	panel->usage = usage;
+}
+
+
 /* useful */
+/* panel_window_add_filter */
+void panel_window_add_filter(PanelWindow * panel, GdkWindow * window,
+		GdkFilterFunc filter, gpointer applet)
+{
+	/* account for the time spent per applet when possible */
+	if(panel->usage == NULL || panel_usage_add_filter(panel->usage,
+				window, filter, applet) != 0)
+		gdk_window_add_filter(window, filter, applet);
+}
+
+
 /* panel_window_append */
 int panel_window_append(PanelWindow * panel, char const * applet)
 {
-	PanelAppletHelper * helper = panel->helper;
-	PanelApplet * pa;
+	int ret;
+	GtkWidget * placeholder = NULL;
 
-	if((pa = realloc(panel->applets, sizeof(*pa)
-					* (panel->applets_cnt + 1))) == NULL)
-		return -error_set_code(1, "%s", strerror(errno));
-	panel->applets = pa;
-	pa = &panel->applets[panel->applets_cnt];
-	if((pa->plugin = plugin_new(LIBDIR, PACKAGE, "applets", applet))
+	/* the applet takes the place of the first placeholder */
+	if(panel->placeholders_cnt > 0)
+	{
+		placeholder = panel->placeholders[0];
+		memmove(&panel->placeholders[0], &panel->placeholders[1],
+				sizeof(*panel->placeholders)
+				* --panel->placeholders_cnt);
+	}
+	ret = _panel_window_insert(panel, panel->applets_cnt, applet,
+			placeholder);
+	if(placeholder != NULL)
+		gtk_widget_destroy(placeholder);
+	return ret;
+}
+
+
+/* panel_window_append_placeholder */
+int panel_window_append_placeholder(PanelWindow * panel, char const * icon)
+{
+	GtkWidget ** p;
+	GtkWidget * widget;
+	gint width;
+	gint height;
+
+	if((p = realloc(panel->placeholders, sizeof(*p)
+					* (panel->placeholders_cnt + 1)))
 			== NULL)
-		return -1;
-	pa->widget = NULL;
-	if((pa->pad = plugin_lookup(pa->plugin, "applet")) == NULL
-			|| (pa->pa = pa->pad->init(helper, &pa->widget)) == NULL
-			|| pa->widget == NULL)
+		return -error_set_code(1, "%s", strerror(errno));
+	panel->placeholders = p;
+	if(icon != NULL)
+		widget = gtk_image_new_from_icon_name(icon, panel->iconsize);
+	else
 	{
-		if(pa->pa != NULL)
-			pa->pad->destroy(pa->pa);
-		plugin_delete(pa->plugin);
-		return -1;
+		widget = gtk_image_new();
+		if(gtk_icon_size_lookup(panel->iconsize, &width, &height))
+			gtk_widget_set_size_request(widget, width, height);
 	}
-	gtk_box_pack_start(GTK_BOX(panel->box), pa->widget, pa->pad->expand,
-			pa->pad->fill, 0);
-	gtk_widget_show_all(pa->widget);
-	panel->applets_cnt++;
+	gtk_widget_set_sensitive(widget, FALSE);
+	gtk_box_pack_start(GTK_BOX(panel->box), widget, FALSE, TRUE, 0);
+	gtk_widget_show(widget);
+	panel->placeholders[panel->placeholders_cnt++] = widget;
+	return 0;
+}
+
+
+/* panel_window_insert */
+int panel_window_insert(PanelWindow * panel, size_t index, char const * applet)
+{
+	return _panel_window_insert(panel, index, applet, NULL);
+}
+
+
+/* panel_window_move */
+int panel_window_move(PanelWindow * panel, size_t from, size_t to)
+{
+	PanelApplet pa;
+
+	if(from >= panel->applets_cnt || to >= panel->applets_cnt)
+		return -error_set_code(1, "%s", strerror(ERANGE));
+	if(from == to)
+		return 0;
+	pa = panel->applets[from];
+	if(from < to)
+		memmove(&panel->applets[from], &panel->applets[from + 1],
+				sizeof(pa) * (to - from));
+	else
+		memmove(&panel->applets[to + 1], &panel->applets[to],
+				sizeof(pa) * (from - to));
+	panel->applets[to] = pa;
+	/* the box only holds the applets once they are all loaded */
+	gtk_box_reorder_child(GTK_BOX(panel->box), pa.widget, to);
+	return 0;
+}
+
+
+/* panel_window_remove */
+int panel_window_remove(PanelWindow * panel, size_t index)
+{
+	PanelApplet * pa;
+
+	if(index >= panel->applets_cnt)
+		return -error_set_code(1, "%s", strerror(ERANGE));
+	pa = &panel->applets[index];
+	pa->pad->destroy(pa->pa);
+	/* the timer forgets about the applet */
+	if(panel->suspended && panel->timer != NULL)
+		panel_timer_resume(panel->timer, pa->pa);
+	if(panel->usage != NULL)
+		panel_usage_unregister(panel->usage, pa->pa);
+	panel_registry_release(pa->pad);
+	string_delete(pa->name);
+	memmove(&panel->applets[index], &panel->applets[index + 1],
+			sizeof(*pa) * (--panel->applets_cnt - index));
 	return 0;
 }
 
@@ -349,11 +528,40 @@ void panel_window_remove_all(PanelWindow * panel)
 	{
 		pa = &panel->applets[i];
 		pa->pad->destroy(pa->pa);
-		plugin_delete(pa->plugin);
+		if(panel->suspended && panel->timer != NULL)
+			panel_timer_resume(panel->timer, pa->pa);
+		if(panel->usage != NULL)
+			panel_usage_unregister(panel->usage, pa->pa);
+		panel_registry_release(pa->pad);
+		string_delete(pa->name);
 	}
 	free(panel->applets);
 	panel->applets = NULL;
 	panel->applets_cnt = 0;
+	panel_window_remove_placeholders(panel);
+}
+
+
+/* panel_window_remove_filter */
+void panel_window_remove_filter(PanelWindow * panel, GdkWindow * window,
+		GdkFilterFunc filter, gpointer applet)
+{
+	if(panel->usage != NULL)
+		panel_usage_remove_filter(panel->usage, window, filter, applet);
+	gdk_window_remove_filter(window, filter, applet);
+}
+
+
+/* panel_window_remove_placeholders */
+void panel_window_remove_placeholders(PanelWindow * panel)
+{
+	size_t i;
+
+	for(i = 0; i < panel->placeholders_cnt; i++)
+		gtk_widget_destroy(panel->placeholders[i]);
+	free(panel->placeholders);
+	panel->placeholders = NULL;
+	panel->placeholders_cnt = 0;
 }
 
 
@@ -372,11 +580,79 @@ void panel_window_show(PanelWindow * panel, gboolean show)
 		gtk_widget_show(panel->window);
 	else
 		gtk_widget_hide(panel->window);
+	panel->visible = show;
+	_panel_window_update(panel);
+}
+
+
+/* panel_window_suspend */
+void panel_window_suspend(PanelWindow * panel, gboolean suspend)
+{
+	panel->suspend = suspend;
+	_panel_window_update(panel);
 }
 
 
 /* private */
 /* functions */
+/* panel_window_insert */
+static int _panel_window_insert(PanelWindow * panel, size_t index,
+		char const * applet, GtkWidget * placeholder)
+{
+	PanelAppletHelper * helper = panel->helper;
+	PanelApplet * pa;
+	PanelApplet p;
+	gint position;
+	gint64 begin;
+
+	if(index > panel->applets_cnt)
+		return -error_set_code(1, "%s", strerror(ERANGE));
+	if((pa = realloc(panel->applets, sizeof(*pa)
+					* (panel->applets_cnt + 1))) == NULL)
+		return -error_set_code(1, "%s", strerror(errno));
+	panel->applets = pa;
+	if((p.name = string_new(applet)) == NULL)
+		return -1;
+	if((p.pad = panel_registry_acquire(applet)) == NULL)
+	{
+		string_delete(p.name);
+		return -1;
+	}
+	p.widget = NULL;
+	begin = panel_profile_begin();
+	p.pa = p.pad->init(helper, &p.widget);
+	panel_profile_end(begin, applet, "init");
+	if(p.pa == NULL || p.widget == NULL)
+	{
+		if(p.pa != NULL)
+			p.pad->destroy(p.pa);
+		panel_registry_release(p.pad);
+		string_delete(p.name);
+		return -1;
+	}
+	/* the applet remains anonymous if this fails */
+	if(panel->usage != NULL)
+		panel_usage_register(panel->usage, p.pa, applet);
+	gtk_box_pack_start(GTK_BOX(panel->box), p.widget, p.pad->expand,
+			p.pad->fill, 0);
+	gtk_widget_show_all(p.widget);
+	if(placeholder != NULL)
+	{
+		gtk_container_child_get(GTK_CONTAINER(panel->box), placeholder,
+				"position", &position, NULL);
+		gtk_box_reorder_child(GTK_BOX(panel->box), p.widget, position);
+	}
+	else if(index < panel->applets_cnt)
+		gtk_box_reorder_child(GTK_BOX(panel->box), p.widget, index);
+	pa = &panel->applets[index];
+	memmove(&pa[1], pa, sizeof(*pa) * (panel->applets_cnt++ - index));
+	*pa = p;
+	if(panel->suspended)
+		_panel_window_suspend_applet(panel, pa);
+	return 0;
+}
+
+
 /* panel_window_reset */
 static void _panel_window_reset(PanelWindow * panel)
 {
@@ -384,7 +660,7 @@ static void _panel_window_reset(PanelWindow * panel)
 	{
 		case PANEL_WINDOW_POSITION_TOP:
 			gtk_window_move(GTK_WINDOW(panel->window),
-					panel->root.x, 0);
+					panel->root.x, panel->root.y);
 			gtk_window_resize(GTK_WINDOW(panel->window),
 					panel->root.width, panel->height);
 			break;
@@ -397,19 +673,17 @@ static void _panel_window_reset(PanelWindow * panel)
 					panel->root.width, panel->height);
 			break;
 		case PANEL_WINDOW_POSITION_LEFT:
-			/* FIXME really implement */
 			gtk_window_move(GTK_WINDOW(panel->window),
-					panel->root.x, 0);
-			gtk_window_resize(GTK_WINDOW(panel->window), 48,
-					panel->root.height);
+					panel->root.x, panel->root.y);
+			gtk_window_resize(GTK_WINDOW(panel->window),
+					panel->width, panel->root.height);
 			break;
 		case PANEL_WINDOW_POSITION_RIGHT:
-			/* FIXME really implement */
 			gtk_window_move(GTK_WINDOW(panel->window),
-					panel->root.x + panel->root.width - 48,
-					panel->root.y);
-			gtk_window_resize(GTK_WINDOW(panel->window), 48,
-					panel->root.height);
+					panel->root.x + panel->root.width
+					- panel->width, panel->root.y);
+			gtk_window_resize(GTK_WINDOW(panel->window),
+					panel->width, panel->root.height);
 			break;
 		case PANEL_WINDOW_POSITION_CENTER:
 		case PANEL_WINDOW_POSITION_FLOATING:
@@ -424,8 +698,9 @@ static void _panel_window_reset(PanelWindow * panel)
 static void _panel_window_reset_strut(PanelWindow * panel)
 {
 	GdkWindow * window;
-	GdkAtom atom;
-	GdkAtom cardinal;
+	GdkScreen * screen;
+	gint width;
+	gint height;
 	unsigned long strut[12];
 
 #if GTK_CHECK_VERSION(2, 14, 0)
@@ -433,41 +708,109 @@ static void _panel_window_reset_strut(PanelWindow * panel)
 #else
 	window = panel->window->window;
 #endif
+	/* the struts are relative to the edges of the whole screen */
+	screen = gtk_widget_get_screen(panel->window);
+	width = gdk_screen_get_width(screen);
+	height = gdk_screen_get_height(screen);
 	memset(&strut, 0, sizeof(strut));
-	/* FIXME check that this code is correct */
 	switch(panel->position)
 	{
 		case PANEL_WINDOW_POSITION_TOP:
-			strut[2] = panel->height;
+			strut[2] = panel->root.y + panel->height;
 			strut[8] = panel->root.x;
-			strut[9] = panel->root.x + panel->root.width;
+			strut[9] = panel->root.x + panel->root.width - 1;
 			break;
 		case PANEL_WINDOW_POSITION_BOTTOM:
-			strut[3] = panel->height;
+			strut[3] = height - panel->root.y - panel->root.height
+				+ panel->height;
 			strut[10] = panel->root.x;
-			strut[11] = panel->root.x + panel->root.width;
+			strut[11] = panel->root.x + panel->root.width - 1;
 			break;
-#if 0 /* FIXME implement */
 		case PANEL_WINDOW_POSITION_LEFT:
+			strut[0] = panel->root.x + panel->width;
+			strut[4] = panel->root.y;
+			strut[5] = panel->root.y + panel->root.height - 1;
+			break;
 		case PANEL_WINDOW_POSITION_RIGHT:
+			strut[1] = width - panel->root.x - panel->root.width
+				+ panel->width;
+			strut[6] = panel->root.y;
+			strut[7] = panel->root.y + panel->root.height - 1;
 			break;
-#endif
 		case PANEL_WINDOW_POSITION_CENTER:
 		case PANEL_WINDOW_POSITION_FLOATING:
 		case PANEL_WINDOW_POSITION_MANAGED:
 		case PANEL_WINDOW_POSITION_EMBEDDED:
 			break;
 	}
-	cardinal = gdk_atom_intern("CARDINAL", FALSE);
-	atom = gdk_atom_intern("_NET_WM_STRUT", FALSE);
-	gdk_property_change(window, atom, cardinal, 32, GDK_PROP_MODE_REPLACE,
+	/* every change makes the window manager lay out the clients again */
+	if(panel->strut_set && memcmp(&panel->strut, &strut, sizeof(strut))
+			== 0)
+		return;
+	memcpy(&panel->strut, &strut, sizeof(strut));
+	panel->strut_set = TRUE;
+	if(_panel_window_atom_cardinal == GDK_NONE)
+	{
+		_panel_window_atom_cardinal = gdk_atom_intern("CARDINAL",
+				FALSE);
+		_panel_window_atom_strut = gdk_atom_intern("_NET_WM_STRUT",
+				FALSE);
+		_panel_window_atom_strut_partial = gdk_atom_intern(
+				"_NET_WM_STRUT_PARTIAL", FALSE);
+	}
+	gdk_property_change(window, _panel_window_atom_strut,
+			_panel_window_atom_cardinal, 32, GDK_PROP_MODE_REPLACE,
 			(guchar *)strut, 4);
-	atom = gdk_atom_intern("_NET_WM_STRUT_PARTIAL", FALSE);
-	gdk_property_change(window, atom, cardinal, 32, GDK_PROP_MODE_REPLACE,
+	gdk_property_change(window, _panel_window_atom_strut_partial,
+			_panel_window_atom_cardinal, 32, GDK_PROP_MODE_REPLACE,
 			(guchar *)strut, 12);
 }
 
 
+/* panel_window_resume_applet */
+static void _panel_window_resume_applet(PanelWindow * panel, PanelApplet * pa)
+{
+	if(panel->timer != NULL)
+		panel_timer_resume(panel->timer, pa->pa);
+	if(pa->pad->resume != NULL)
+		pa->pad->resume(pa->pa);
+}
+
+
+/* panel_window_suspend_applet */
+static void _panel_window_suspend_applet(PanelWindow * panel,
+		PanelApplet * pa)
+{
+	if(pa->pad->suspend != NULL)
+		pa->pad->suspend(pa->pa);
+	if(panel->timer != NULL)
+		panel_timer_suspend(panel->timer, pa->pa);
+}
+
+
+/* panel_window_update */
+static void _panel_window_update(PanelWindow * panel)
+{
+	gboolean suspend;
+	size_t i;
+
+	/* stop sampling while nobody can see the applets */
+	suspend = (panel->visible == FALSE || panel->suspend) ? TRUE : FALSE;
+	if(suspend == panel->suspended)
+		return;
+#ifdef DEBUG
+	fprintf(stderr, "DEBUG: %s() %u %s\n", __func__, panel->position,
+			suspend ? "suspend" : "resume");
+#endif
+	panel->suspended = suspend;
+	for(i = 0; i < panel->applets_cnt; i++)
+		if(suspend)
+			_panel_window_suspend_applet(panel, &panel->applets[i]);
+		else
+			_panel_window_resume_applet(panel, &panel->applets[i]);
+}
+
+
 /* callbacks */
 /* panel_window_on_closex */
 static gboolean _panel_window_on_closex(gpointer data)
@@ -491,6 +834,7 @@ static gboolean _panel_window_on_configure_event(GtkWidget * widget,
 	if(event->type != GDK_CONFIGURE)
 		return FALSE;
 	panel->height = cevent->height;
+	panel->width = cevent->width;
 #ifdef DEBUG
 	fprintf(stderr, "DEBUG: %s() %u height=%d\n", __func__, panel->position,
 			panel->height);
@@ -505,7 +849,21 @@ static gboolean _panel_window_on_configure_event(GtkWidget * widget,
 				_panel_window_reset_strut(panel);
 			break;
 		case PANEL_WINDOW_POSITION_BOTTOM:
-			if(cevent->y + cevent->height != panel->root.height)
+			if(cevent->y + cevent->height
+					!= panel->root.y + panel->root.height)
+				_panel_window_reset(panel);
+			else
+				_panel_window_reset_strut(panel);
+			break;
+		case PANEL_WINDOW_POSITION_LEFT:
+			if(cevent->x != panel->root.x)
+				_panel_window_reset(panel);
+			else
+				_panel_window_reset_strut(panel);
+			break;
+		case PANEL_WINDOW_POSITION_RIGHT:
+			if(cevent->x + cevent->width
+					!= panel->root.x + panel->root.width)
 				_panel_window_reset(panel);
 			else
 				_panel_window_reset_strut(panel);
@@ -516,3 +874,33 @@ static gboolean _panel_window_on_configure_event(GtkWidget * widget,
 	}
 	return FALSE;
 }
+
+
+/* panel_window_on_draw */
+static gboolean _panel_window_on_draw(GtkWidget * widget, gpointer event,
+		gpointer data)
+{
+	PanelWindow * panel = data;
+	(void) event;
+
+	panel_profile_mark(_panel_window_positions[panel->position],
+			"first draw");
+	g_signal_handlers_disconnect_by_func(widget, _panel_window_on_draw,
+			data);
+	return FALSE;
+}
+
+
+/* panel_window_on_map_event */
+static gboolean _panel_window_on_map_event(GtkWidget * widget,
+		GdkEvent * event, gpointer data)
+{
+	PanelWindow * panel = data;
+	(void) event;
+
+	panel_profile_mark(_panel_window_positions[panel->position],
+			"first map");
+	g_signal_handlers_disconnect_by_func(widget,
+			_panel_window_on_map_event, data);
+	return FALSE;
+}
@@ -1,5 +1,5 @@
 /* $Id$ */
-/* Copyright (c) 2011-2015 Pierre Pronchery <khorben@defora.org> */
+/* Copyright (c) 2011-2026 Pierre Pronchery <khorben@defora.org> */
 /* This file is part of DeforaOS Desktop Panel */
 /* This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -22,6 +22,8 @@
 # include "../include/Panel/applet.h"
 # include "../include/Panel/window.h"
 # include "panel.h"
+# include "timer.h"
+# include "usage.h"
 
 
 /* PanelWindow */
@@ -47,22 +49,33 @@ PanelWindow * panel_window_new(PanelAppletHelper * helper,
 void panel_window_delete(PanelWindow * panel);
 
 /* accessors */
+size_t panel_window_get_applet_count(PanelWindow * panel);
+char const * panel_window_get_applet_name(PanelWindow * panel, size_t index);
 int panel_window_get_height(PanelWindow * panel);
 GtkOrientation panel_window_get_orientation(PanelWindow * panel);
 void panel_window_get_position(PanelWindow * panel, gint * x, gint * y);
 void panel_window_get_size(PanelWindow * panel, gint * width, gint * height);
+PanelUsage * panel_window_get_usage(PanelWindow * panel);
 int panel_window_get_width(PanelWindow * panel);
 uint32_t panel_window_get_xid(PanelWindow * panel);
 
 void panel_window_set_accept_focus(PanelWindow * panel, gboolean accept);
 void panel_window_set_keep_above(PanelWindow * panel, gboolean keep);
+void panel_window_set_timer(PanelWindow * panel, PanelTimer * timer);
 void panel_window_set_title(PanelWindow * panel, char const * title);
+void panel_window_set_usage(PanelWindow * panel, PanelUsage * usage);
 
 /* useful */
 int panel_window_append(PanelWindow * panel, char const * applet);
+int panel_window_append_placeholder(PanelWindow * panel, char const * icon);
+int panel_window_insert(PanelWindow * panel, size_t index, char const * applet);
+int panel_window_move(PanelWindow * panel, size_t from, size_t to);
+int panel_window_remove(PanelWindow * panel, size_t index);
 void panel_window_remove_all(PanelWindow * panel);
+void panel_window_remove_placeholders(PanelWindow * panel);
 
 void panel_window_reset(PanelWindow * panel, GdkRectangle * root);
 void panel_window_show(PanelWindow * panel, gboolean show);
+void panel_window_suspend(PanelWindow * panel, gboolean suspend);
 
 #endif /* !PANEL_WINDOW_H */
@@ -41,6 +41,9 @@ static int _perror(char const * message, int ret);
 static char const * _applets2_helper_config_get(Panel * panel,
 		char const * section, char const * variable);
 static int _applets2_helper_error(Panel * panel, char const * message, int ret);
+static guint _applets2_helper_timeout_add(Panel * panel, guint interval,
+		GSourceFunc callback, PanelApplet * applet);
+static void _applets2_helper_timeout_remove(Panel * panel, guint id);
 
 static gboolean _applets2(gpointer data)
 {
@@ -86,6 +89,8 @@ static gboolean _applets2(gpointer data)
 	}
 	helper.config_get = _applets2_helper_config_get;
 	helper.error = _applets2_helper_error;
+	helper.timeout_add = _applets2_helper_timeout_add;
+	helper.timeout_remove = _applets2_helper_timeout_remove;
 	while((de = readdir(dir)) != NULL)
 	{
 		if((len = strlen(de->d_name)) < sizeof(ext))
@@ -146,6 +151,21 @@ static int _applets2_helper_error(Panel * panel, char const * message, int ret)
 	return ret;
 }
 
+static guint _applets2_helper_timeout_add(Panel * panel, guint interval,
+		GSourceFunc callback, PanelApplet * applet)
+{
+	(void) panel;
+
+	return g_timeout_add(interval, callback, applet);
+}
+
+static void _applets2_helper_timeout_remove(Panel * panel, guint id)
+{
+	(void) panel;
+
+	g_source_remove(id);
+}
+
 
 /* dlerror */
 static int _dlerror(char const * message, int ret)
@@ -0,0 +1,158 @@
+#!/bin/sh
+#$Id$
+#Copyright (c) 2026 Pierre Pronchery <khorben@defora.org>
+#This file is part of DeforaOS Desktop Panel
+#This program is free software: you can redistribute it and/or modify
+#it under the terms of the GNU General Public License as published by
+#the Free Software Foundation, version 3 of the License.
+#
+#This program is distributed in the hope that it will be useful,
+#but WITHOUT ANY WARRANTY; without even the implied warranty of
+#MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#GNU General Public License for more details.
+#
+#You should have received a copy of the GNU General Public License
+#along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#variables
+[ -n "$OBJDIR" ] || OBJDIR="./"
+APPLETS="battery clock cpu cpufreq memory network pager swap tasks"
+DURATION="10"
+PROGNAME="benchmark.sh"
+TICKS="20"
+XVFB_DISPLAY=":99"
+#executables
+DATE="date"
+ECHO="echo"
+KILL="kill"
+PANEL_TEST="${OBJDIR}../tools/panel-test"
+SLEEP="sleep"
+UNAME="uname"
+XVFB="Xvfb"
+[ $($UNAME -s) != "Darwin" ] || ECHO="/bin/echo"
+
+
+#functions
+#benchmark
+_benchmark()
+{
+	applet="$1"
+
+	$ECHO -n "$applet:" 1>&2
+	#one line of key=value pairs per applet
+	LD_LIBRARY_PATH="$OBJDIR../src" \
+		"$PANEL_TEST" -b "$TICKS" -s "$DURATION" "$applet" 2> /dev/null
+	res=$?
+	if [ $res -ne 0 ]; then
+		echo "applets=$applet error=$res"
+		echo " FAIL" 1>&2
+	else
+		echo " DONE" 1>&2
+	fi
+	return $res
+}
+
+
+#date
+_date()
+{
+	if [ -n "$SOURCE_DATE_EPOCH" ]; then
+		TZ=UTC $DATE -d "@$SOURCE_DATE_EPOCH" '+%a %b %d %T %Z %Y'
+	else
+		$DATE
+	fi
+}
+
+
+#error
+_error()
+{
+	echo "$PROGNAME: $@" 1>&2
+	return 2
+}
+
+
+#usage
+_usage()
+{
+	echo "Usage: $PROGNAME [-c] target..." 1>&2
+	return 1
+}
+
+
+#xvfb_start
+_xvfb_start()
+{
+	#prefer a local server for reproducible measurements
+	$XVFB "$XVFB_DISPLAY" -screen 0 1024x768x24 > /dev/null 2>&1 &
+	xvfb=$!
+	$SLEEP 1
+	if ! $KILL -0 "$xvfb" 2> /dev/null; then
+		xvfb=
+		[ -n "$DISPLAY" ] || return 2
+	else
+		DISPLAY="$XVFB_DISPLAY"
+		export DISPLAY
+	fi
+	return 0
+}
+
+
+#xvfb_stop
+_xvfb_stop()
+{
+	[ -z "$xvfb" ] || $KILL "$xvfb"
+}
+
+
+#main
+clean=0
+while getopts "cO:P:" name; do
+	case "$name" in
+		c)
+			clean=1
+			;;
+		O)
+			export "${OPTARG%%=*}"="${OPTARG#*=}"
+			;;
+		P)
+			#XXX ignored
+			;;
+		?)
+			_usage
+			exit $?
+			;;
+	esac
+done
+shift $((OPTIND - 1))
+if [ $# -lt 1 ]; then
+	_usage
+	exit $?
+fi
+
+[ "$clean" -ne 0 ]			&& exit 0
+
+xvfb=
+if ! _xvfb_start; then
+	_error "Could not start $XVFB"
+	exit $?
+fi
+while [ $# -ge 1 ]; do
+	target="$1"
+	shift
+
+	FAILED=
+	($ECHO -n "# "; _date) > "$target"
+	echo "Benchmarking applets:" 1>&2
+	for applet in $APPLETS; do
+		_benchmark "$applet" >> "$target" || FAILED="$FAILED $applet"
+	done
+	if [ -n "$FAILED" ]; then
+		echo "Failed benchmarks:$FAILED" 1>&2
+		_xvfb_stop
+		exit 2
+	fi
+	echo "All benchmarks completed" 1>&2
+done
+_xvfb_stop
@@ -0,0 +1,194 @@
+/* $Id$ */
+/* Copyright (c) 2026 Pierre Pronchery <khorben@defora.org> */
+/* This file is part of DeforaOS Desktop Panel */
+/* This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include "Panel/image.h"
+
+#define PROGNAME	"image"
+
+#define ICON_SIZE	256
+#define PIXBUF_SIZE	24
+#define ITERATIONS	200
+
+
+/* private */
+/* prototypes */
+static int _image_benchmark(unsigned long const * argb);
+static int _image_scale(void);
+static int _image_unpack(unsigned long const * argb, unsigned int flags);
+
+static GdkPixbuf * _reference_pixbuf(unsigned long const * argb, int width,
+		int size);
+
+
+/* functions */
+/* image_benchmark */
+static int _image_benchmark(unsigned long const * argb)
+{
+	gint64 reference;
+	gint64 image;
+	int i;
+	GdkPixbuf * pixbuf;
+
+	reference = g_get_monotonic_time();
+	for(i = 0; i < ITERATIONS; i++)
+	{
+		if((pixbuf = _reference_pixbuf(argb, ICON_SIZE, PIXBUF_SIZE))
+				== NULL)
+			return 2;
+		g_object_unref(pixbuf);
+	}
+	reference = g_get_monotonic_time() - reference;
+	image = g_get_monotonic_time();
+	for(i = 0; i < ITERATIONS; i++)
+	{
+		if((pixbuf = panel_image_new_pixbuf(argb, ICON_SIZE, ICON_SIZE,
+						PIXBUF_SIZE, PIXBUF_SIZE))
+				== NULL)
+			return 2;
+		if(gdk_pixbuf_get_width(pixbuf) != PIXBUF_SIZE
+				|| gdk_pixbuf_get_height(pixbuf) != PIXBUF_SIZE)
+		{
+			g_object_unref(pixbuf);
+			return 3;
+		}
+		g_object_unref(pixbuf);
+	}
+	image = g_get_monotonic_time() - image;
+	printf("%dx%d to %dx%d: reference %.3f ms, image %.3f ms\n",
+			ICON_SIZE, ICON_SIZE, PIXBUF_SIZE, PIXBUF_SIZE,
+			reference / 1000.0 / ITERATIONS,
+			image / 1000.0 / ITERATIONS);
+	return 0;
+}
+
+
+/* image_scale */
+static int _image_scale(void)
+{
+	unsigned char src[37 * 29 * 4];
+	unsigned char dst[10 * 7 * 4];
+	size_t i;
+
+	/* a uniform image remains uniform */
+	for(i = 0; i < sizeof(src); i++)
+		src[i] = (i % 4) * 60 + 7;
+	if(panel_image_scale(dst, 10, 7, src, 37, 29) != 0)
+		return 2;
+	for(i = 0; i < sizeof(dst); i++)
+		if(dst[i] != (i % 4) * 60 + 7)
+		{
+			printf("%s: Pixel %lu differs (%u)\n", "scale",
+					(unsigned long)i / 4, dst[i]);
+			return 3;
+		}
+	/* only downscaling is supported */
+	return (panel_image_scale(dst, 38, 7, src, 37, 29) == 0) ? 4 : 0;
+}
+
+
+/* image_unpack */
+static int _image_unpack(unsigned long const * argb, unsigned int flags)
+{
+	unsigned char * rgba;
+	unsigned int a;
+	unsigned int c[4];
+	size_t i;
+	size_t j;
+
+	/* odd count, to cover the vector code and the remainder */
+	if((rgba = malloc(ICON_SIZE * ICON_SIZE * 4)) == NULL)
+		return 2;
+	panel_image_unpack(rgba, argb, ICON_SIZE * ICON_SIZE - 3, flags);
+	for(i = 0; i < ICON_SIZE * ICON_SIZE - 3; i++)
+	{
+		a = (argb[i] >> 24) & 0xff;
+		c[0] = (argb[i] >> 16) & 0xff;
+		c[1] = (argb[i] >> 8) & 0xff;
+		c[2] = argb[i] & 0xff;
+		c[3] = a;
+		for(j = 0; j < 4; j++)
+		{
+			if(j < 3 && (flags & PANEL_IMAGE_PREMULTIPLIED))
+				c[j] = (c[j] * a + 127) / 255;
+			if(rgba[i * 4 + j] == c[j])
+				continue;
+			printf("%s: Pixel %lu differs (0x%08lx)\n", "unpack",
+					(unsigned long)i, argb[i]);
+			free(rgba);
+			return 3;
+		}
+	}
+	free(rgba);
+	return 0;
+}
+
+
+/* reference_pixbuf */
+static GdkPixbuf * _reference_pixbuf(unsigned long const * argb, int width,
+		int size)
+{
+	GdkPixbuf * ret;
+	unsigned long cnt = width * width * 4;
+	unsigned char * rgba;
+	unsigned long i;
+	unsigned long j;
+	GdkPixbuf * p;
+
+	/* as formerly done by the tasks applet */
+	if((rgba = malloc(cnt)) == NULL)
+		return NULL;
+	for(i = 0, j = 0; j < cnt; i++)
+	{
+		rgba[j++] = (argb[i] >> 16) & 0xff; /* red */
+		rgba[j++] = (argb[i] >> 8) & 0xff; /* green */
+		rgba[j++] = argb[i] & 0xff; /* blue */
+		rgba[j++] = (argb[i] >> 24) & 0xff; /* alpha */
+	}
+	p = gdk_pixbuf_new_from_data(rgba, GDK_COLORSPACE_RGB, TRUE, 8, width,
+			width, width * 4, (GdkPixbufDestroyNotify)free, NULL);
+	ret = gdk_pixbuf_scale_simple(p, size, size, GDK_INTERP_BILINEAR);
+	g_object_unref(p);
+	return ret;
+}
+
+
+/* main */
+int main(void)
+{
+	int ret;
+	unsigned long * argb;
+	size_t i;
+
+	if((argb = malloc(sizeof(*argb) * ICON_SIZE * ICON_SIZE)) == NULL)
+		return 2;
+	srand(ICON_SIZE);
+	for(i = 0; i < ICON_SIZE * ICON_SIZE; i++)
+		/* the upper bits of a long are to be ignored */
+		argb[i] = ((unsigned long)rand() << 16 ^ rand())
+			| ((unsigned long)rand() << 31 << 1);
+	if((ret = _image_unpack(argb, 0)) == 0
+			&& (ret = _image_unpack(argb,
+					PANEL_IMAGE_PREMULTIPLIED)) == 0
+			&& (ret = _image_scale()) == 0)
+		ret = _image_benchmark(argb);
+	free(argb);
+	if(ret != 0)
+		fprintf(stderr, "%s: %s\n", PROGNAME, "Test failed");
+	return ret;
+}
@@ -119,6 +119,7 @@ while [ $# -ge 1 ]; do
 	_date > "$target"
 	FAILED=
 	echo "Performing tests:" 1>&2
+	_test "image"
 	_test "user"
 	_test "wpa_supplicant"
 	echo "Expected failures:" 1>&2
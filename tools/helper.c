@@ -1,5 +1,5 @@
 /* $Id$ */
-/* Copyright (c) 2012-2024 Pierre Pronchery <khorben@defora.org> */
+/* Copyright (c) 2012-2026 Pierre Pronchery <khorben@defora.org> */
 /* This file is part of DeforaOS Desktop Panel */
 /* This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -23,6 +23,7 @@
 #include <gtk/gtk.h>
 #include <System.h>
 #include <Desktop.h>
+#include "../src/timer.h"
 #include "../src/window.h"
 #include "../config.h"
 
@@ -46,6 +47,8 @@ struct _Panel
 	PanelAppletHelper helper[PANEL_POSITION_COUNT];
 	PanelWindow * windows[PANEL_POSITION_COUNT];
 
+	PanelTimer * timer;
+
 	GdkScreen * screen;
 	GdkWindow * root;
 	gint root_width;		/* width of the root window	*/
@@ -140,8 +143,13 @@ static int _panel_init(Panel * panel, PanelWindowPosition position,
 	GdkRectangle rect;
 	size_t i;
 
+	if((panel->timer = panel_timer_new()) == NULL)
+		return -1;
 	if((panel->config = config_new()) == NULL)
+	{
+		panel_timer_delete(panel->timer);
 		return -1;
+	}
 	if(config_load_preferences(panel->config, PANEL_CONFIG_VENDOR,
 				PACKAGE, PANEL_CONFIG_FILE) != 0)
 		error_print(PROGNAME);
@@ -158,6 +166,8 @@ static int _panel_init(Panel * panel, PanelWindowPosition position,
 	panel->windows[top] = panel_window_new(&panel->helper[top],
 			PANEL_WINDOW_TYPE_NORMAL, position, iconsize, &rect);
 	panel->helper[top].window = panel->windows[top];
+	if(panel->windows[top] != NULL)
+		panel_window_set_timer(panel->windows[top], panel->timer);
 	for(i = 0; i < sizeof(panel->windows) / sizeof(*panel->windows); i++)
 		if(i != top)
 			panel->windows[i] = NULL;
@@ -194,6 +204,7 @@ static void _panel_destroy(Panel * panel)
 		gtk_widget_destroy(panel->sh_window);
 	if(panel->su_window != NULL)
 		gtk_widget_destroy(panel->su_window);
+	panel_timer_delete(panel->timer);
 }
 
 
@@ -306,6 +317,8 @@ static void _helper_init(PanelAppletHelper * helper, Panel * panel,
 	helper->suspend = _init_can_suspend() ? _panel_helper_suspend : NULL;
 	helper->suspend_dialog = (helper->suspend != NULL)
 		? _panel_helper_suspend_dialog : NULL;
+	helper->timeout_add = _panel_helper_timeout_add;
+	helper->timeout_remove = _panel_helper_timeout_remove;
 }
 
 static int _init_can_shutdown(void)
@@ -1,5 +1,5 @@
 /* $Id$ */
-/* Copyright (c) 2011-2018 Pierre Pronchery <khorben@defora.org> */
+/* Copyright (c) 2011-2026 Pierre Pronchery <khorben@defora.org> */
 /* This file is part of DeforaOS Desktop Panel */
 /* This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -16,6 +16,8 @@
 
 
 #include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
 #include <unistd.h>
 #include <stdarg.h>
 #include <stdlib.h>
@@ -24,6 +26,9 @@
 #include <locale.h>
 #include <libintl.h>
 #include <gtk/gtk.h>
+#ifdef GDK_WINDOWING_X11
+# include <gdk/gdkx.h>
+#endif
 #include <System.h>
 #include <Desktop.h>
 #include "../src/panel.h"
@@ -53,10 +58,46 @@
 
 
 /* private */
+/* types */
+typedef struct _Benchmark
+{
+	Panel * panel;
+	unsigned int ticks;		/* limit, in timer wake-ups	*/
+	unsigned int seconds;		/* limit, in seconds		*/
+
+	/* measurements */
+	gint64 init;			/* in microseconds		*/
+	gint64 start;			/* monotonic, in microseconds	*/
+	unsigned int wakeups;
+	struct rusage usage;
+	unsigned long requests;
+	unsigned long redraws;
+} Benchmark;
+
+
+/* constants */
+#define BENCHMARK_POLL		250	/* in milliseconds		*/
+
+
+/* variables */
+static Benchmark * _benchmark = NULL;
+
+
 /* prototypes */
 static int _test(PanelWindowType type, PanelWindowPosition position,
 		GtkIconSize iconsize, char * applets[]);
 
+static unsigned long _benchmark_get_requests(void);
+
+static void _benchmark_report(Benchmark * benchmark, char * applets[]);
+static void _benchmark_start(Benchmark * benchmark);
+
+/* callbacks */
+static gboolean _benchmark_on_idle(gpointer data);
+static gboolean _benchmark_on_redraw(GSignalInvocationHint * hint,
+		guint n_params, GValue const * params, gpointer data);
+static gboolean _benchmark_on_timeout(gpointer data);
+
 static int _usage(void);
 
 
@@ -67,25 +108,166 @@ static int _test(PanelWindowType type, PanelWindowPosition position,
 {
 	Panel panel;
 	size_t i;
+	gint64 begin;
+	guint signal = 0;
+	gulong hook = 0;
 
 	_panel_init(&panel, position, type, iconsize);
 	_panel_set_title(&panel, "Applet tester");
+	if(_benchmark != NULL)
+	{
+		_benchmark->panel = &panel;
+		/* count the redraws of every widget */
+#if GTK_CHECK_VERSION(3, 0, 0)
+		signal = g_signal_lookup("draw", GTK_TYPE_WIDGET);
+#else
+		signal = g_signal_lookup("expose-event", GTK_TYPE_WIDGET);
+#endif
+		hook = g_signal_add_emission_hook(signal, 0,
+				_benchmark_on_redraw, _benchmark, NULL);
+	}
 	for(i = 0; applets[i] != NULL; i++)
+	{
+		begin = g_get_monotonic_time();
 		if(_panel_append(&panel, PANEL_POSITION_TOP, applets[i]) != 0)
 			error_print(PROGNAME_PANEL_TEST);
+		if(_benchmark != NULL)
+			_benchmark->init += g_get_monotonic_time() - begin;
+	}
 	_panel_show(&panel, TRUE);
+	if(_benchmark != NULL)
+		/* measure the steady state once the panel is drawn */
+		g_idle_add_full(G_PRIORITY_LOW, _benchmark_on_idle, _benchmark,
+				NULL);
 	gtk_main();
+	if(_benchmark != NULL)
+	{
+		g_signal_remove_emission_hook(signal, hook);
+		_benchmark_report(_benchmark, applets);
+	}
 	_panel_destroy(&panel);
 	return 0;
 }
 
 
+/* benchmark */
+/* benchmark_get_requests */
+static unsigned long _benchmark_get_requests(void)
+{
+#ifdef GDK_WINDOWING_X11
+	GdkDisplay * display;
+
+	if((display = gdk_display_get_default()) == NULL)
+		return 0;
+# if GTK_CHECK_VERSION(3, 0, 0)
+	if(!GDK_IS_X11_DISPLAY(display))
+		return 0;
+# endif
+	return NextRequest(GDK_DISPLAY_XDISPLAY(display));
+#else
+	return 0;
+#endif
+}
+
+
+/* benchmark_report */
+static void _benchmark_report(Benchmark * benchmark, char * applets[])
+{
+	struct rusage usage;
+	unsigned int ticks;
+	gint64 duration;
+	double cpu;
+	size_t i;
+
+	duration = g_get_monotonic_time() - benchmark->start;
+	getrusage(RUSAGE_SELF, &usage);
+	ticks = panel_timer_get_wakeups(benchmark->panel->timer)
+		- benchmark->wakeups;
+	cpu = (usage.ru_utime.tv_sec - benchmark->usage.ru_utime.tv_sec
+			+ usage.ru_stime.tv_sec
+			- benchmark->usage.ru_stime.tv_sec) * 1000000.0
+		+ usage.ru_utime.tv_usec - benchmark->usage.ru_utime.tv_usec
+		+ usage.ru_stime.tv_usec - benchmark->usage.ru_stime.tv_usec;
+	/* one line of key=value pairs per run */
+	fputs("applets=", stdout);
+	for(i = 0; applets[i] != NULL; i++)
+		printf("%s%s", (i > 0) ? "," : "", applets[i]);
+	printf(" init=%.3f duration=%.3f ticks=%u cpu=%.3f cpu_per_tick=%.3f"
+			" rss=%ld rss_growth=%ld requests=%lu redraws=%lu\n",
+			benchmark->init / 1000.0, duration / 1000.0, ticks,
+			cpu / 1000.0, (ticks > 0) ? cpu / 1000.0 / ticks : 0.0,
+			(long)usage.ru_maxrss,
+			(long)(usage.ru_maxrss - benchmark->usage.ru_maxrss),
+			_benchmark_get_requests() - benchmark->requests,
+			benchmark->redraws);
+	fflush(stdout);
+}
+
+
+/* benchmark_start */
+static void _benchmark_start(Benchmark * benchmark)
+{
+	benchmark->start = g_get_monotonic_time();
+	benchmark->wakeups = panel_timer_get_wakeups(benchmark->panel->timer);
+	getrusage(RUSAGE_SELF, &benchmark->usage);
+	benchmark->requests = _benchmark_get_requests();
+	benchmark->redraws = 0;
+}
+
+
+/* callbacks */
+/* benchmark_on_idle */
+static gboolean _benchmark_on_idle(gpointer data)
+{
+	Benchmark * benchmark = data;
+
+	_benchmark_start(benchmark);
+	g_timeout_add(BENCHMARK_POLL, _benchmark_on_timeout, benchmark);
+	return FALSE;
+}
+
+
+/* benchmark_on_redraw */
+static gboolean _benchmark_on_redraw(GSignalInvocationHint * hint,
+		guint n_params, GValue const * params, gpointer data)
+{
+	Benchmark * benchmark = data;
+	(void) hint;
+	(void) n_params;
+	(void) params;
+
+	benchmark->redraws++;
+	return TRUE;
+}
+
+
+/* benchmark_on_timeout */
+static gboolean _benchmark_on_timeout(gpointer data)
+{
+	Benchmark * benchmark = data;
+
+	if(benchmark->ticks > 0 && panel_timer_get_wakeups(
+				benchmark->panel->timer) - benchmark->wakeups
+			>= benchmark->ticks)
+		gtk_main_quit();
+	else if(benchmark->seconds > 0 && g_get_monotonic_time()
+			- benchmark->start >= benchmark->seconds * 1000000LL)
+		gtk_main_quit();
+	else
+		return TRUE;
+	return FALSE;
+}
+
+
 /* usage */
 static int _usage(void)
 {
-	fputs("Usage: " PROGNAME_PANEL_TEST " [-C|-F|-M][-L|-S|-X|-x][-n] applet...\n"
+	fputs("Usage: " PROGNAME_PANEL_TEST " [-C|-F|-M][-L|-S|-X|-x][-n]"
+" [-b ticks][-s seconds] applet...\n"
 "       " PROGNAME_PANEL_TEST " -l\n"
-"  -l	Lists the plug-ins available\n", stderr);
+"  -b	Benchmark the applets for this number of timer wake-ups\n"
+"  -l	Lists the plug-ins available\n"
+"  -s	Benchmark the applets for this number of seconds\n", stderr);
 	return 1;
 }
 
@@ -99,7 +281,9 @@ int main(int argc, char * argv[])
 	PanelWindowPosition position = PANEL_WINDOW_POSITION_MANAGED;
 	GtkIconSize iconsize = GTK_ICON_SIZE_LARGE_TOOLBAR;
 	GtkIconSize huge;
+	Benchmark benchmark;
 	int o;
+	char * p;
 
 	if(setlocale(LC_ALL, "") == NULL)
 		_error("setlocale", 1);
@@ -109,9 +293,16 @@ int main(int argc, char * argv[])
 	if((huge = gtk_icon_size_from_name("panel-huge"))
 			== GTK_ICON_SIZE_INVALID)
 		huge = gtk_icon_size_register("panel-huge", 64, 64);
-	while((o = getopt(argc, argv, "CFLlMnSXx")) != -1)
+	memset(&benchmark, 0, sizeof(benchmark));
+	while((o = getopt(argc, argv, "b:CFLlMnSs:Xx")) != -1)
 		switch(o)
 		{
+			case 'b':
+				benchmark.ticks = strtoul(optarg, &p, 10);
+				if(optarg[0] == '\0' || *p != '\0')
+					return _usage();
+				_benchmark = &benchmark;
+				break;
 			case 'C':
 				position = PANEL_WINDOW_POSITION_CENTER;
 				break;
@@ -132,6 +323,12 @@ int main(int argc, char * argv[])
 			case 'S':
 				iconsize = GTK_ICON_SIZE_SMALL_TOOLBAR;
 				break;
+			case 's':
+				benchmark.seconds = strtoul(optarg, &p, 10);
+				if(optarg[0] == '\0' || *p != '\0')
+					return _usage();
+				_benchmark = &benchmark;
+				break;
 			case 'X':
 				iconsize = huge;
 				break;